@@ -0,0 +1,56 @@
+# overrides_bin.py
+# Date overrides (Ramadan, special days) and weekday rules (Jumu'ah) as a small
+# overrides-only PRAY3 file.
+# Uploaded with 'f' or copied to the library as override.pray, it applies to
+# whichever schedule file the device runs, so the base tables stay as they are.
+#
+#   python overrides_bin.py rules.txt [override.pray]
+#
+# The rules file format is described in pray2_format.py.
+
+from __future__ import annotations
+import sys
+from datetime import date
+from pray2_format import (parse_override_rules, compile_overrides, pack_overrides,
+                          parse_weekly_rules, pack_weekly, pack_pray3)
+
+# The device keeps the whole file in RAM (override_buf in main.c) and ignores a
+# bigger one.
+DEVICE_MAX = 1024
+
+
+def build(text: str) -> bytes:
+    entries = compile_overrides(parse_override_rules(text))
+    weekly = parse_weekly_rules(text)
+    if not entries and weekly is None:
+        raise ValueError("no override rules")
+    first = entries[0][0] if entries else date(2000, 1, 1)
+    # No days: the header's start date and RTC string are placeholders
+    buf = pack_pray3(first, [], 0, [0] * 5, first.strftime("00:00:00|%d/%m/%y"), 0,
+                     overrides=pack_overrides(entries) if entries else None,
+                     weekly=pack_weekly(weekly) if weekly else None)
+    if len(buf) > DEVICE_MAX:
+        raise ValueError(f"{len(buf)} bytes, the device takes at most {DEVICE_MAX}: "
+                         f"{len(entries)} date ranges, merge or drop some")
+    return buf
+
+
+def main(argv):
+    if not 2 <= len(argv) <= 3:
+        print(f"usage: {argv[0]} rules.txt [override.pray]")
+        return 2
+    out = argv[2] if len(argv) > 2 else "override.pray"
+    try:
+        with open(argv[1], encoding="utf-8") as f:
+            buf = build(f.read())
+    except (OSError, ValueError) as e:
+        print(e)
+        return 1
+    with open(out, "wb") as f:
+        f.write(buf)
+    print(f"{out}: {len(buf)} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
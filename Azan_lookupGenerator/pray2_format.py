@@ -0,0 +1,349 @@
+# pray2_format.py
+# PRAY2 v2 and PRAY3 binary layouts, kept free of adhanpy so tests can import it.
+# The firmware decodes this with RelaySwitching/src/pray2_reader.h;
+# tests/test_pray2_roundtrip.py runs that exact code over files written here.
+
+from __future__ import annotations
+from datetime import date, timedelta
+import struct, zlib
+
+MAGIC = b"PRAY2"
+VERSION = 2
+HEADER_SIZE = 64
+
+FLAG_DURATIONS = 0x01     # bit 0: per-day ON durations follow the table
+FLAG_LOCATION = 0x02      # bit 1: location section between header and table
+FLAG_RTC_ONE_SHOT = 0x10  # bit 4: MCU sets its RTC once from rtc_ascii, then clears it
+
+# Everything up to the table, in file order (offsets in pray2_reader.h).
+HEADER_STRUCT = struct.Struct("<5sBHHHBBBB17sB5HIIIIHH")
+assert HEADER_STRUCT.size == HEADER_SIZE
+
+# lat_udeg, lon_udeg, utc_offset_min, asr_shadow, offset_min[5] (Fajr..Isha):
+# what the firmware computes from once the table's span has ended.
+LOCATION_STRUCT = struct.Struct("<iihB5b")
+LOCATION_SIZE = 16
+assert LOCATION_STRUCT.size == LOCATION_SIZE
+
+# PRAY3: a 48-byte header (bytes 8..43 as PRAY2's, section_count in PRAY2's pad
+# byte, payload_size at 44), then a directory of (type, 0, offset, size)
+# entries, then the sections. A reader skips types it does not know.
+MAGIC3 = b"PRAY3"
+VERSION3 = 3
+HEADER3_SIZE = 48
+HEADER3_STRUCT = struct.Struct("<5sBHHHBBBB17sB5HI")
+assert HEADER3_STRUCT.size == HEADER3_SIZE
+DIR_ENTRY = struct.Struct("<HHII")
+MAX_SECTIONS = 16
+
+SEC_TIMES = 1      # days x 5 u16 minutes
+SEC_DURATIONS = 2  # days x 5 u16 seconds
+SEC_LOCATION = 3   # pack_location()
+SEC_METHOD = 4     # pack_method(), for method_code 0 (CUSTOM)
+SEC_DST = 5        # pack_dst()
+SEC_OVERRIDES = 6  # pack_overrides()
+SEC_CRC = 7        # u32 CRC32 of every byte before it
+SEC_WEEKLY = 8     # pack_weekly()
+
+METHOD_STRUCT = struct.Struct("<HHB3x")
+DST_ENTRY = struct.Struct("<ihxx")
+# first_day, days, prayer mask, mode, value, on_sec (pray3_override_t)
+OVERRIDE_ENTRY = struct.Struct("<iHBBhH")
+OVR_ABSOLUTE = 0x01
+PRAYER_BITS = {"Fajr": 0x01, "Dhuhr": 0x02, "Asr": 0x04, "Maghrib": 0x08, "Isha": 0x10}
+# mask, mode, value, on_sec (pray3_weekly_t), one per WEEKDAYS entry
+WEEKLY_ENTRY = struct.Struct("<BBhHxx")
+WEEKDAYS = ("Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat")
+
+
+def validate_rtc_ascii(s: str) -> str | None:
+    """
+    Verify 'HH:MM:SS|DD/MM/YY' exactly (17 chars) and return normalized string or None.
+    """
+    s = s.strip()
+    if len(s) != 17:
+        return None
+    try:
+        if not (s[2]==':' and s[5]==':' and s[8]=='|' and s[11]=='/' and s[14]=='/'):
+            return None
+        HH = int(s[0:2]); MM = int(s[3:5]); SS = int(s[6:8])
+        DD = int(s[9:11]); MO = int(s[12:14]); YY = int(s[15:17])
+        if not (0 <= HH <= 23 and 0 <= MM <= 59 and 0 <= SS <= 59):
+            return None
+        if not (1 <= MO <= 12 and 1 <= DD <= 31):
+            return None
+        # Return in exact normalized format
+        return f"{HH:02d}:{MM:02d}:{SS:02d}|{DD:02d}/{MO:02d}/{YY:02d}"
+    except Exception:
+        return None
+
+
+def pack_location(lat: float, lon: float, utc_offset_min: int, offsets,
+                  asr_shadow: int = 1) -> bytes:
+    """The location section; offsets are the five per-prayer minutes, Fajr..Isha."""
+    if not (-90 <= lat <= 90 and -180 <= lon <= 180 and -720 <= utc_offset_min <= 840):
+        raise ValueError(f"location out of range: {lat}, {lon}, UTC{utc_offset_min:+d} min")
+    return LOCATION_STRUCT.pack(round(lat * 1e6), round(lon * 1e6), utc_offset_min, asr_shadow,
+                                *offsets)
+
+
+def pack_pray2(start: date, rows, method_code: int, default_on, rtc_ascii: str,
+               flags: int, durations=None, location: bytes | None = None) -> bytes:
+    """
+    Build a PRAY2 file: header, optional location section (pack_location()),
+    days x 5 u16 minutes, optional durations block (same shape, seconds), then
+    CRC32 of everything before it.
+    flags bits 0 and 1 are set or cleared here to match `durations` and `location`.
+    """
+    days = len(rows)
+    rtc_bytes = rtc_ascii.encode("ascii")
+    if len(rtc_bytes) != 17:
+        raise ValueError(f"RTC string must be 17 chars, got {len(rtc_bytes)}")
+    if durations is not None and len(durations) != days:
+        raise ValueError(f"durations has {len(durations)} days, table has {days}")
+
+    if location is None:
+        flags &= ~FLAG_LOCATION
+        location = b""
+    elif len(location) != LOCATION_SIZE:
+        raise ValueError(f"location section must be {LOCATION_SIZE} bytes, got {len(location)}")
+    else:
+        flags |= FLAG_LOCATION
+
+    table_offset = HEADER_SIZE + len(location)
+    table_size = days * 5 * 2
+    if durations is None:
+        flags &= ~FLAG_DURATIONS
+        durations_offset = durations_size = 0
+    else:
+        flags |= FLAG_DURATIONS
+        durations_offset = table_offset + table_size
+        durations_size = table_size
+
+    buf = bytearray(HEADER_STRUCT.pack(
+        MAGIC, VERSION, HEADER_SIZE, start.year, days, start.month, start.day,
+        flags & 0xFF, method_code, rtc_bytes, 0, *default_on,
+        table_offset, table_size, durations_offset, durations_size, 0, 0))
+    buf += location
+    for t in rows:
+        buf += struct.pack("<5H", *t)
+    for t in durations or ():
+        buf += struct.pack("<5H", *t)
+
+    buf += struct.pack("<I", zlib.crc32(buf) & 0xFFFFFFFF)
+    return bytes(buf)
+
+
+def pack_method(fajr_angle: float, isha_angle: float, isha_interval_min: int = 0) -> bytes:
+    """The METHOD section: CUSTOM angles in degrees, or Isha a fixed interval after Maghrib."""
+    if not (0 < fajr_angle < 30 and 0 <= isha_angle < 30 and 0 <= isha_interval_min <= 255):
+        raise ValueError(f"method out of range: {fajr_angle}, {isha_angle}, {isha_interval_min}")
+    return METHOD_STRUCT.pack(round(fajr_angle * 100), round(isha_angle * 100), isha_interval_min)
+
+
+def pack_dst(transitions) -> bytes:
+    """The DST section: (local date, UTC offset in minutes from that date on), rising."""
+    days = [(d - date(1970, 1, 1)).days for d, _ in transitions]
+    if days != sorted(set(days)):
+        raise ValueError("DST transitions must be rising and distinct")
+    buf = bytearray(struct.pack("<HH", len(days), 0))
+    for day, (_, off) in zip(days, transitions):
+        buf += DST_ENTRY.pack(day, off)
+    return bytes(buf)
+
+
+def pack_pray3(start: date, rows, method_code: int, default_on, rtc_ascii: str,
+               flags: int, durations=None, location: bytes | None = None,
+               method: bytes | None = None, dst: bytes | None = None,
+               overrides: bytes | None = None, weekly: bytes | None = None, extra=()) -> bytes:
+    """
+    Build a PRAY3 file: header, directory, the sections given (times unless
+    rows is empty, then durations, location, method, dst, overrides, weekly
+    and any `extra` (type, bytes) pairs), then the CRC32 of everything before
+    it as the last section. No rows and only `overrides` and/or `weekly` is an
+    overrides-only file.
+    Only flags bit 4 is kept; the sections say the rest.
+    """
+    days = len(rows)
+    rtc_bytes = rtc_ascii.encode("ascii")
+    if len(rtc_bytes) != 17:
+        raise ValueError(f"RTC string must be 17 chars, got {len(rtc_bytes)}")
+    if durations is not None and len(durations) != days:
+        raise ValueError(f"durations has {len(durations)} days, table has {days}")
+    if location is not None and len(location) != LOCATION_SIZE:
+        raise ValueError(f"location section must be {LOCATION_SIZE} bytes, got {len(location)}")
+
+    sections = [(SEC_TIMES, b"".join(struct.pack("<5H", *t) for t in rows))] if days else []
+    if durations is not None:
+        sections.append((SEC_DURATIONS, b"".join(struct.pack("<5H", *t) for t in durations)))
+    for kind, body in ((SEC_LOCATION, location), (SEC_METHOD, method), (SEC_DST, dst),
+                       (SEC_OVERRIDES, overrides), (SEC_WEEKLY, weekly)):
+        if body is not None:
+            sections.append((kind, body))
+    sections += list(extra)
+    count = len(sections) + 1  # and the CRC
+    if count > MAX_SECTIONS:
+        raise ValueError(f"{count} sections, at most {MAX_SECTIONS}")
+
+    directory = bytearray()
+    off = HEADER3_SIZE + count * DIR_ENTRY.size
+    for kind, body in sections:
+        directory += DIR_ENTRY.pack(kind, 0, off, len(body))
+        off += len(body)
+    directory += DIR_ENTRY.pack(SEC_CRC, 0, off, 4)
+
+    buf = bytearray(HEADER3_STRUCT.pack(
+        MAGIC3, VERSION3, HEADER3_SIZE, start.year, days, start.month, start.day,
+        flags & FLAG_RTC_ONE_SHOT, method_code, rtc_bytes, count, *default_on, off))
+    buf += directory
+    for _, body in sections:
+        buf += body
+    buf += struct.pack("<I", zlib.crc32(buf) & 0xFFFFFFFF)
+    return bytes(buf)
+
+
+# ---- date overrides ----
+# A rules file has one rule per line, "#" comments and blank lines ignored:
+#
+#   <first date> [<last date>]  <prayers>  <change>  [<relay seconds>]
+#   2026-02-18 2026-03-19  Isha        +120        # Ramadan
+#   2026-02-18 2026-03-19  Fajr        -10   90
+#   2026-03-20             Dhuhr,Asr   =13:30
+#   2026-03-21             all         0     120
+#
+# prayers: comma-separated names or "all"; change: +N / -N minutes, =HH:MM,
+# or 0 for the time as computed. A later rule wins where rules overlap.
+#
+# A line can name weekdays (Sun..Sat, comma-separated) instead of dates; it
+# applies on each such day before the day's dated rules, so a dated =HH:MM
+# replaces its time and a dated +N / -N moves it further:
+#
+#   Fri                    Dhuhr       =13:30  300    # Jumu'ah
+#
+# One weekday rule per day. The device can replace them ("fri=..." in its
+# config), so the rules change without a new file.
+
+def _rule_days(field: str):
+    """The WEEKDAYS indexes a rule's first field names, or None for a date."""
+    names = [w.capitalize() for w in field.split(",")]
+    if not all(w in WEEKDAYS for w in names):
+        return None
+    return [WEEKDAYS.index(w) for w in names]
+
+
+def _parse_effect(rest):
+    """(mask, mode, value, on_sec) from <prayers> <change> [<relay seconds>]."""
+    if not 2 <= len(rest) <= 3:
+        raise ValueError
+    names = rest[0].split(",")
+    mask = 0x1F if names == ["all"] else 0
+    for p in names if mask == 0 else ():
+        mask |= PRAYER_BITS[p.capitalize()]
+    change = rest[1]
+    if change.startswith("="):
+        hh, mm = change[1:].split(":")
+        mode, value = OVR_ABSOLUTE, int(hh) * 60 + int(mm)
+        if not (0 <= int(hh) <= 23 and 0 <= int(mm) <= 59):
+            raise ValueError
+    else:
+        mode, value = 0, int(change)
+        if not -1439 <= value <= 1439:
+            raise ValueError
+    on_sec = int(rest[2]) if len(rest) > 2 else 0
+    if not 0 <= on_sec <= 36000:
+        raise ValueError
+    return mask, mode, value, on_sec
+
+
+def parse_override_rules(text: str):
+    """Dated rules as (first, last, mask, mode, value, on_sec); ValueError names the bad line."""
+    rules = []
+    for n, line in enumerate(text.splitlines(), 1):
+        f = line.split("#", 1)[0].split()
+        if not f or _rule_days(f[0]) is not None:
+            continue
+        try:
+            first = date.fromisoformat(f[0])
+            last = date.fromisoformat(f[1]) if len(f) > 1 and f[1][:1].isdigit() and "-" in f[1] else None
+            rest = f[2:] if last else f[1:]
+            last = last or first
+            if last < first:
+                raise ValueError
+            rules.append((first, last) + _parse_effect(rest))
+        except (ValueError, KeyError, IndexError):
+            raise ValueError(f"override rules line {n}: {line.strip()!r}") from None
+    return rules
+
+
+def parse_weekly_rules(text: str):
+    """
+    The weekday rules as seven (mask, mode, value, on_sec), Sunday first, mask
+    0 for no rule; None if there are none. ValueError names the bad line.
+    """
+    table = [(0, 0, 0, 0)] * 7
+    seen = set()
+    for n, line in enumerate(text.splitlines(), 1):
+        f = line.split("#", 1)[0].split()
+        days = _rule_days(f[0]) if f else None
+        if days is None:
+            continue
+        try:
+            effect = _parse_effect(f[1:])
+            if seen & set(days):
+                raise ValueError
+        except (ValueError, KeyError, IndexError):
+            raise ValueError(f"override rules line {n}: {line.strip()!r}") from None
+        for d in days:
+            table[d] = effect
+        seen.update(days)
+    return table if seen else None
+
+
+def compile_overrides(rules):
+    """
+    Entries for pack_overrides(): each day's effect per prayer (the last rule
+    touching it), prayers with the same effect in one entry, and runs of days
+    with the same entries merged into one range. Entries of one range share
+    their first day; ranges never overlap, as pray3_find_overrides() expects.
+    """
+    effects = {}  # date -> {prayer bit: (mode, value, on_sec)}
+    for first, last, mask, mode, value, on_sec in rules:
+        for k in range((last - first).days + 1):
+            day = effects.setdefault(first + timedelta(days=k), {})
+            for bit in PRAYER_BITS.values():
+                if mask & bit:
+                    day[bit] = (mode, value, on_sec)
+
+    def entries_of(day):
+        by_effect = {}
+        for bit, eff in day.items():
+            by_effect[eff] = by_effect.get(eff, 0) | bit
+        return tuple(sorted((mask,) + eff for eff, mask in by_effect.items()))
+
+    out, run = [], None  # run: [first, days, entries]
+    for d in sorted(effects):
+        e = entries_of(effects[d])
+        if run and run[0] + timedelta(days=run[1]) == d and run[2] == e and run[1] < 0xFFFF:
+            run[1] += 1
+            continue
+        if run:
+            out.append(tuple(run))
+        run = [d, 1, e]
+    if run:
+        out.append(tuple(run))
+    # At most one entry per prayer a day: within the reader's PRAY3_OVR_MAX
+    return [(first, days, mask, mode, value, on_sec)
+            for first, days, e in out for mask, mode, value, on_sec in e]
+
+
+def pack_weekly(table) -> bytes:
+    """The WEEKLY section from parse_weekly_rules()' table."""
+    return b"".join(WEEKLY_ENTRY.pack(*rule) for rule in table)
+
+
+def pack_overrides(entries) -> bytes:
+    """The OVERRIDES section from compile_overrides() entries."""
+    buf = bytearray(struct.pack("<HH", len(entries), 0))
+    for first, days, mask, mode, value, on_sec in entries:
+        buf += OVERRIDE_ENTRY.pack((first - date(1970, 1, 1)).days, days, mask, mode, value, on_sec)
+    return bytes(buf)
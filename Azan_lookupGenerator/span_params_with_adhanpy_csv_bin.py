@@ -1,12 +1,16 @@
 # generate_pray2_bin_and_csv.py
-# One interactive tool: computes times with adhanpy, writes PRAY2 .bin and (optionally) CSV.
+# One interactive tool: computes times with adhanpy, writes a PRAY2 or PRAY3 .bin and (optionally) CSV.
 
 from __future__ import annotations
 from datetime import datetime, date, timedelta
-import calendar, os, struct, zlib, csv
+import calendar, os, csv
 from zoneinfo import ZoneInfo
 from adhanpy.PrayerTimes import PrayerTimes
 from adhanpy.calculation import CalculationMethod
+from pray2_format import (pack_pray2, pack_pray3, pack_location, pack_dst, validate_rtc_ascii,
+                          parse_override_rules, compile_overrides, pack_overrides,
+                          parse_weekly_rules, pack_weekly,
+                          FLAG_RTC_ONE_SHOT)
 
 PRAYERS = ["Fajr", "Dhuhr", "Asr", "Maghrib", "Isha"]
 
@@ -31,31 +35,7 @@ METHOD_CODE = {
     "UMM_AL_QURA": 4, "MOON_SIGHTING_COMMITTEE": 5, "NORTH_AMERICA": 6,
 }
 
-# One-shot RTC flag (MCU will clear this after setting its RTC once)
-FLAG_RTC_ONE_SHOT = 0x10  # bit 4
-
 # ---- helpers ----
-def validate_rtc_ascii(s: str) -> str | None:
-    """
-    Verify 'HH:MM:SS|DD/MM/YY' exactly (17 chars) and return normalized string or None.
-    """
-    s = s.strip()
-    if len(s) != 17:
-        return None
-    try:
-        if not (s[2]==':' and s[5]==':' and s[8]=='|' and s[11]=='/' and s[14]=='/'):
-            return None
-        HH = int(s[0:2]); MM = int(s[3:5]); SS = int(s[6:8])
-        DD = int(s[9:11]); MO = int(s[12:14]); YY = int(s[15:17])
-        if not (0 <= HH <= 23 and 0 <= MM <= 59 and 0 <= SS <= 59):
-            return None
-        if not (1 <= MO <= 12 and 1 <= DD <= 31):
-            return None
-        # Return in exact normalized format
-        return f"{HH:02d}:{MM:02d}:{SS:02d}|{DD:02d}/{MO:02d}/{YY:02d}"
-    except Exception:
-        return None
-
 def ask_rtc_ascii(tzname: str) -> str:
     """
     Ask user to type installation-local RTC time. Enter to use computer's current time in tzname.
@@ -74,6 +54,19 @@ def ask_rtc_ascii(tzname: str) -> str:
         print("  ✖ Invalid format. Please use exactly HH:MM:SS|DD/MM/YY (17 chars). Try again.")
 
 
+def ask_override_rules():
+    """Compiled overrides and weekday rules from a rules file (see pray2_format), or (None, None)."""
+    while True:
+        path=input("Override rules file (Ramadan, special days, Jumu'ah) [blank for none]: ").strip()
+        if not path: return None, None
+        try:
+            with open(path, encoding="utf-8") as f:
+                text=f.read()
+            entries=compile_overrides(parse_override_rules(text)); weekly=parse_weekly_rules(text)
+            print(f"  {len(entries)} override entries, {sum(1 for r in weekly or () if r[0])} weekday rules")
+            return entries or None, weekly
+        except (OSError, ValueError) as e: print(f"   → {e}")
+
 def month_span(year:int, month:int):
     last = calendar.monthrange(year, month)[1]
     return date(year, month, 1), date(year, month, last)
@@ -183,57 +176,48 @@ def write_csv(path,start,end,lat,lon,tzname,method_key,offsets):
             w.writerow([d.isoformat(), d.strftime("%A"),
                         *(t.strftime("%H:%M") for t in (fajr,sunrise,dhuhr,asr,mag,isha))])
 
-# ---- PRAY2 v2 BIN writer (local RTC string) ----
-def write_pray2_bin(path, start, end, lat, lon, tzname, method_key, offsets, default_on,
-                    rtc_ascii: str, flags: int):
-    rows = compute_minutes_table(start, end, lat, lon, tzname, method_key, offsets)
-    days = len(rows); start_month = start.month; start_day = start.day; year = start.year
-    magic = b"PRAY2"; version = 2; header_size = 64
-    method_code = METHOD_CODE[method_key]
+# ---- location section: what the device computes from after the span ----
+def fallback_utc_offset(tzname, end):
+    """UTC offset (minutes) on the day after the span, and whether it changes in the year after."""
+    tz=ZoneInfo(tzname); first=end+timedelta(days=1)
+    at_noon=lambda d: int(datetime(d.year,d.month,d.day,12,tzinfo=tz).utcoffset().total_seconds())//60
+    offs={at_noon(first+timedelta(days=k)) for k in range(0,366,7)}
+    return at_noon(first), len(offs)>1
 
-    rtc_bytes = rtc_ascii.encode("ascii")
-    if len(rtc_bytes) != 17:
-        raise RuntimeError(f"RTC string must be 17 chars, got {len(rtc_bytes)}")
-
-    table_offset = header_size
-    table_size = days * 5 * 2
-    durations_offset = 0
-    durations_size = 0
-
-    buf = bytearray()
-    buf += magic
-    buf += struct.pack("<B", version)
-    buf += struct.pack("<H", header_size)
-    buf += struct.pack("<H", year)
-    buf += struct.pack("<H", days)
-    buf += struct.pack("<B", start_month)
-    buf += struct.pack("<B", start_day)
-    buf += struct.pack("<B", flags & 0xFF)       # <-- flags includes RTC_ONE_SHOT bit if chosen
-    buf += struct.pack("<B", method_code)
-    buf += rtc_bytes                               # 17
-    buf += struct.pack("<B", 0)                    # pad to 34
-    buf += struct.pack("<5H", *default_on)         # 34..43
-    buf += struct.pack("<I", table_offset)
-    buf += struct.pack("<I", table_size)
-    buf += struct.pack("<I", durations_offset)
-    buf += struct.pack("<I", durations_size)
-    buf += struct.pack("<H", 0)
-    buf += struct.pack("<H", 0)
-    assert len(buf) == header_size
-
-    for t in rows:
-        buf += struct.pack("<5H", *t)
-
-    # Keep CRC appended (MCU ignores it; harmless). Delete these 2 lines if you truly don't want it.
-    crc = zlib.crc32(buf) & 0xFFFFFFFF
-    buf += struct.pack("<I", crc)
+def dst_transitions(tzname, end, years=10):
+    """(first local date, UTC offset in minutes) each time the offset changes in the years after the span."""
+    tz=ZoneInfo(tzname); first=end+timedelta(days=1); out=[]
+    at_noon=lambda d: int(datetime(d.year,d.month,d.day,12,tzinfo=tz).utcoffset().total_seconds())//60
+    prev=at_noon(first)
+    for k in range(1, years*366):
+        d=first+timedelta(days=k); off=at_noon(d)
+        if off!=prev: out.append((d, off)); prev=off
+    return out
 
+# ---- PRAY2 v2 / PRAY3 BIN writer (local RTC string) ----
+def write_pray2_bin(path, start, end, lat, lon, tzname, method_key, offsets, default_on,
+                    rtc_ascii: str, flags: int, pray3: bool = False, overrides=None, weekly=None):
+    rows = compute_minutes_table(start, end, lat, lon, tzname, method_key, offsets)
+    utc_off, dst = fallback_utc_offset(tzname, end)
+    location = pack_location(lat, lon, utc_off, [offsets[p] for p in PRAYERS])
+    if pray3:
+        # The DST section carries the zone's changes, so the device follows them
+        buf = pack_pray3(start, rows, METHOD_CODE[method_key], default_on, rtc_ascii, flags,
+                         location=location, dst=pack_dst(dst_transitions(tzname, end)),
+                         overrides=pack_overrides(overrides) if overrides else None,
+                         weekly=pack_weekly(weekly) if weekly else None)
+    else:
+        if dst:
+            print(f"  ! {tzname} changes its UTC offset: times computed on the device after "
+                  f"{end.isoformat()} use UTC{utc_off:+d} min all year (PRAY3 follows it).")
+        buf = pack_pray2(start, rows, METHOD_CODE[method_key], default_on, rtc_ascii, flags,
+                         location=location)
     with open(path, "wb") as f:
         f.write(buf)
 
 # ---- main ----
 def main():
-    print("=== Prayer Schedule → PRAY2 .bin (+ optional CSV) ===")
+    print("=== Prayer Schedule → PRAY2/PRAY3 .bin (+ optional CSV) ===")
     year=ask_int("Year",1900,2100)
     print("""
 Choose what to generate:
@@ -276,6 +260,8 @@ Choose what to generate:
     rtc_ascii = ask_rtc_ascii(tzname)   # user-typed or defaulted to current time in tzname
     set_once = ask_yes_no("Set RTC on device once from this file?", default=True)
     flags = FLAG_RTC_ONE_SHOT if set_once else 0
+    pray3 = ask_yes_no("Write the sectioned PRAY3 format (needs current firmware)?", default=False)
+    overrides, weekly = ask_override_rules() if pray3 else (None, None)
 
     span=f"{start.strftime('%Y%m%d')}-{end.strftime('%Y%m%d')}"
     bin_default=f"prayer_{year}_{span}_{method_key}.bin"
@@ -284,7 +270,7 @@ Choose what to generate:
 
     print("\n=== Writing BIN ===")
     write_pray2_bin(bin_path, start, end, lat, lon, tzname, method_key, offsets,
-                    default_on, rtc_ascii, flags)
+                    default_on, rtc_ascii, flags, pray3, overrides, weekly)
     size=os.path.getsize(bin_path)
     print(f"BIN written: {bin_path}  |  size: {size} bytes ({size/1024:.2f} KiB)")
 
@@ -0,0 +1,116 @@
+# conftest.py
+# Builds tests/pray2_shim.c (the firmware's pray2_reader.h, unchanged) and the
+# firmware's src/pray_calc.c into host shared libraries once per session and
+# loads them with ctypes.
+# Set PRAY2_SHIM / PRAY_CALC_LIB to use prebuilt libraries, CC to pick the compiler.
+
+from __future__ import annotations
+import ctypes, os, shutil, subprocess, sys
+from pathlib import Path
+import pytest
+
+HERE = Path(__file__).resolve().parent
+ROOT = HERE.parent
+FIRMWARE_SRC = ROOT.parent / "RelaySwitching" / "src"
+
+sys.path.insert(0, str(ROOT))  # pray2_format lives next to the generators
+
+
+class ShimHeader(ctypes.Structure):
+    _fields_ = [
+        ("year", ctypes.c_uint16),
+        ("days", ctypes.c_uint16),
+        ("start_month", ctypes.c_uint8),
+        ("start_day", ctypes.c_uint8),
+        ("flags", ctypes.c_uint8),
+        ("method_code", ctypes.c_uint8),
+        ("rtc_ascii", ctypes.c_char * 18),
+        ("default_on_sec", ctypes.c_uint16 * 5),
+        ("table_offset", ctypes.c_uint32),
+        ("table_size", ctypes.c_uint32),
+        ("durations_offset", ctypes.c_uint32),
+        ("durations_size", ctypes.c_uint32),
+        ("has_durations", ctypes.c_uint8),
+        ("has_location", ctypes.c_uint8),
+        ("utc_offset_min", ctypes.c_int16),
+        ("lat_udeg", ctypes.c_int32),
+        ("lon_udeg", ctypes.c_int32),
+        ("asr_shadow", ctypes.c_uint8),
+        ("offset_min", ctypes.c_int8 * 5),
+        ("version", ctypes.c_uint8),
+        ("has_method", ctypes.c_uint8),
+        ("fajr_cdeg", ctypes.c_uint16),
+        ("isha_cdeg", ctypes.c_uint16),
+        ("isha_interval_min", ctypes.c_uint8),
+    ]
+
+
+class CalcParams(ctypes.Structure):
+    """struct pray_calc_params"""
+    _fields_ = [
+        ("lat", ctypes.c_float),
+        ("lon", ctypes.c_float),
+        ("utc_offset_min", ctypes.c_int16),
+        ("method", ctypes.c_uint8),
+        ("asr_shadow", ctypes.c_uint8),
+        ("offset_min", ctypes.c_int8 * 5),
+        ("fajr_angle", ctypes.c_float),
+        ("isha_angle", ctypes.c_float),
+        ("isha_interval_min", ctypes.c_uint8),
+    ]
+
+
+def _build(out_dir: Path, name: str, source: Path, libs=()) -> Path:
+    cc = os.environ.get("CC") or shutil.which("cc") or shutil.which("gcc") or shutil.which("clang")
+    if not cc:
+        pytest.skip(f"no C compiler to build {name}")
+    lib = out_dir / f"lib{name}.so"
+    subprocess.run([cc, "-shared", "-fPIC", "-O2", "-Wall", "-Wextra", "-Werror",
+                    f"-I{FIRMWARE_SRC}", str(source), "-o", str(lib), *libs],
+                   check=True)
+    return lib
+
+
+@pytest.fixture(scope="session")
+def shim(tmp_path_factory):
+    path = os.environ.get("PRAY2_SHIM") or _build(tmp_path_factory.mktemp("shim"), "pray2_shim",
+                                                  HERE / "pray2_shim.c")
+    lib = ctypes.CDLL(str(path))
+    u8p, u16p = ctypes.POINTER(ctypes.c_uint8), ctypes.POINTER(ctypes.c_uint16)
+
+    lib.shim_parse.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.POINTER(ShimHeader)]
+    lib.shim_parse.restype = ctypes.c_int
+    lib.shim_last_msg.restype = ctypes.c_char_p
+    lib.shim_payload_size.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
+    lib.shim_payload_size.restype = ctypes.c_uint32
+    lib.shim_table.argtypes = [ctypes.c_char_p, ctypes.c_size_t, u16p, ctypes.c_size_t]
+    lib.shim_table.restype = ctypes.c_int
+    lib.shim_day_index.argtypes = [ctypes.c_char_p, ctypes.c_size_t] + [ctypes.c_int] * 3
+    lib.shim_day_index.restype = ctypes.c_int
+    lib.shim_fires_on_day.argtypes = ([ctypes.c_char_p, ctypes.c_size_t] + [ctypes.c_int] * 3
+                                      + [u16p, u8p, u16p])
+    lib.shim_fires_on_day.restype = ctypes.c_int
+    lib.shim_parse_rtc.argtypes = [ctypes.c_char_p, ctypes.POINTER(ctypes.c_int)]
+    lib.shim_parse_rtc.restype = ctypes.c_int
+    lib.shim_dst.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.POINTER(ctypes.c_int32),
+                             ctypes.POINTER(ctypes.c_int16), ctypes.c_int]
+    lib.shim_dst.restype = ctypes.c_int
+    lib.shim_rows_lazy.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.c_uint16,
+                                   ctypes.c_uint16, u16p, ctypes.POINTER(ctypes.c_uint32)]
+    lib.shim_rows_lazy.restype = ctypes.c_int
+    lib.shim_day_with_overrides.argtypes = ([ctypes.c_char_p, ctypes.c_size_t] * 2
+                                            + [ctypes.c_int] * 3 + [u16p, u16p])
+    lib.shim_day_with_overrides.restype = ctypes.c_int
+    return lib
+
+
+@pytest.fixture(scope="session")
+def calc(tmp_path_factory):
+    path = os.environ.get("PRAY_CALC_LIB") or _build(tmp_path_factory.mktemp("calc"), "pray_calc",
+                                                     FIRMWARE_SRC / "pray_calc.c", ["-lm"])
+    lib = ctypes.CDLL(str(path))
+    u16p = ctypes.POINTER(ctypes.c_uint16)
+    for fn in (lib.pray_calc_times, lib.pray_calc_day):
+        fn.argtypes = [ctypes.POINTER(CalcParams)] + [ctypes.c_int] * 3 + [u16p]
+        fn.restype = ctypes.c_bool
+    return lib
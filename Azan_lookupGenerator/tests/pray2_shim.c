@@ -0,0 +1,207 @@
+// pray2_shim.c — pray2_reader.h as a host shared library for the Python tests
+//
+// Flat, ctypes-friendly wrappers around the firmware's own parser and
+// scheduler; nothing here reimplements the format. Built by conftest.py.
+#include <stdint.h>
+#include <string.h>
+
+#include "pray2_reader.h"
+
+// Last diagnostic from the reader, so a test can show why a file was rejected.
+static char last_msg[64];
+
+void print_uart(char *buf)
+{
+    strncpy(last_msg, buf, sizeof(last_msg) - 1);
+}
+
+const char *shim_last_msg(void)
+{
+    return last_msg;
+}
+
+// Header fields in pray2_header_t order, without the pointers; the location
+// and METHOD sections flattened after them.
+struct shim_header {
+    uint16_t year;
+    uint16_t days;
+    uint8_t start_month;
+    uint8_t start_day;
+    uint8_t flags;
+    uint8_t method_code;
+    char rtc_ascii[18];
+    uint16_t default_on_sec[5];
+    uint32_t table_offset;
+    uint32_t table_size;
+    uint32_t durations_offset;
+    uint32_t durations_size;
+    uint8_t has_durations;
+    uint8_t has_location;
+    int16_t utc_offset_min;
+    int32_t lat_udeg;
+    int32_t lon_udeg;
+    uint8_t asr_shadow;
+    int8_t offset_min[5];
+    uint8_t version;
+    uint8_t has_method;
+    uint16_t fajr_cdeg;
+    uint16_t isha_cdeg;
+    uint8_t isha_interval_min;
+};
+
+int shim_parse(const uint8_t *buf, size_t len, struct shim_header *out)
+{
+    pray2_header_t h;
+    pray2_location_t loc = {0};
+    pray3_method_t m = {0};
+    last_msg[0] = '\0';
+    pray2_status_t st = pray2_validate_and_parse_no_crc(buf, len, &h);
+    if (st != PRAY2_OK) return (int)st;
+
+    out->year = h.year;
+    out->days = h.days;
+    out->start_month = h.start_month;
+    out->start_day = h.start_day;
+    out->flags = h.flags;
+    out->method_code = h.method_code;
+    memcpy(out->rtc_ascii, h.rtc_ascii, sizeof(out->rtc_ascii));
+    memcpy(out->default_on_sec, h.default_on_sec, sizeof(out->default_on_sec));
+    out->table_offset = h.table_offset;
+    out->table_size = h.table_size;
+    out->durations_offset = h.durations_offset;
+    out->durations_size = h.durations_size;
+    out->has_durations = h.durations_ptr != NULL;
+    out->has_location = pray2_get_location(&h, &loc);
+    out->utc_offset_min = loc.utc_offset_min;
+    out->lat_udeg = loc.lat_udeg;
+    out->lon_udeg = loc.lon_udeg;
+    out->asr_shadow = loc.asr_shadow;
+    memcpy(out->offset_min, loc.offset_min, sizeof(out->offset_min));
+    out->version = h.version;
+    out->has_method = pray3_get_method(&h, &m);
+    out->fajr_cdeg = m.fajr_cdeg;
+    out->isha_cdeg = m.isha_cdeg;
+    out->isha_interval_min = m.isha_interval_min;
+    return PRAY2_OK;
+}
+
+// DST section entries into days/offsets. Returns how many, -1 if the file is rejected.
+int shim_dst(const uint8_t *buf, size_t len, int32_t *days, int16_t *offsets, int max)
+{
+    pray2_header_t h;
+    pray3_dst_t e[32];
+    if (pray2_validate_and_parse_no_crc(buf, len, &h) != PRAY2_OK) return -1;
+    int n = pray3_get_dst(&h, e, max < 32 ? max : 32);
+    for (int i = 0; i < n; ++i) {
+        days[i] = e[i].day;
+        offsets[i] = e[i].utc_offset_min;
+    }
+    return n;
+}
+
+// A pray_src_t over a buffer that counts what is read through it
+struct mem_src {
+    pray_src_t src;
+    const uint8_t *buf;
+    uint32_t bytes;
+};
+
+static int mem_read(const pray_src_t *src, uint32_t off, void *buf, uint32_t len)
+{
+    struct mem_src *m = (struct mem_src *)src->ctx;
+    if ((uint64_t)off + len > src->size) return -1;
+    memcpy(buf, m->buf + off, len);
+    m->bytes += len;
+    return 0;
+}
+
+// Open buf through a source and read rows first..first+n-1 from it; *bytes gets
+// what was read in total. Returns n, or -1 if the file or a row is rejected.
+int shim_rows_lazy(const uint8_t *buf, size_t len, uint16_t first, uint16_t n,
+                   uint16_t *out, uint32_t *bytes)
+{
+    struct mem_src m = {.src = {mem_read, (uint32_t)len, &m}, .buf = buf};
+    pray2_header_t h;
+    if (pray_open(&m.src, &h) != PRAY2_OK) return -1;
+    for (uint16_t i = 0; i < n; ++i) {
+        if (!pray2_get_day_minutes(&h, (uint16_t)(first + i), out + (size_t)i * 5u)) return -1;
+    }
+    *bytes = m.bytes;
+    return n;
+}
+
+uint32_t shim_payload_size(const uint8_t *buf, size_t len)
+{
+    return pray2_payload_size(buf, len);
+}
+
+// Whole table in one call: out gets days*5 minutes. Returns days or -1.
+int shim_table(const uint8_t *buf, size_t len, uint16_t *out, size_t out_len)
+{
+    pray2_header_t h;
+    if (pray2_validate_and_parse_no_crc(buf, len, &h) != PRAY2_OK) return -1;
+    if (out_len < (size_t)h.days * 5u) return -1;
+    for (uint16_t i = 0; i < h.days; ++i) {
+        if (!pray2_get_day_minutes(&h, i, out + (size_t)i * 5u)) return -1;
+    }
+    return h.days;
+}
+
+int shim_day_index(const uint8_t *buf, size_t len, int y, int m, int d)
+{
+    pray2_header_t h;
+    if (pray2_validate_and_parse_no_crc(buf, len, &h) != PRAY2_OK) return -2;
+    return pray2_compute_day_index(&h, y, m, d);
+}
+
+// Run the 1 Hz scheduler over one local day at minute resolution, starting
+// just after midnight. out_min/out_prayer/out_on get one entry per fire.
+// Returns the number of fires, or -1 if the file or date is rejected.
+int shim_fires_on_day(const uint8_t *buf, size_t len, int y, int m, int d,
+                      uint16_t out_min[5], uint8_t out_prayer[5], uint16_t out_on[5])
+{
+    pray2_header_t h;
+    pray2_sched_t s;
+    pray2_time_t t = {0, 0, 0, d, m, y};
+    char rtc[32];
+    int fires = 0;
+
+    if (pray2_validate_and_parse_no_crc(buf, len, &h) != PRAY2_OK) return -1;
+    if (!pray2_sched_init(&s, &h, &t)) return -1;
+    for (int min = 1; min < 24 * 60; ++min) {
+        int p;
+        uint16_t on;
+        snprintf(rtc, sizeof(rtc), "%02d:%02d:00|%02d/%02d/%02d", min / 60, min % 60, d, m, y % 100);
+        if (pray2_sched_tick(&s, rtc, &p, &on)) {
+            if (fires >= 5) return -1;
+            out_min[fires] = (uint16_t)min;
+            out_prayer[fires] = (uint8_t)p;
+            out_on[fires] = on;
+            fires++;
+        }
+    }
+    return fires;
+}
+
+// One local day of buf's schedule with ovr's overrides and weekday rules
+// applied (ovr NULL: buf's own). Returns 1 with the times and relay seconds, 0 if the day has none, -1
+// if a file is rejected.
+int shim_day_with_overrides(const uint8_t *buf, size_t len, const uint8_t *ovr, size_t ovr_len,
+                            int y, int m, int d, uint16_t out_min[5], uint16_t out_on[5])
+{
+    pray2_header_t h, o;
+    pray2_sched_t s;
+    pray2_time_t t = {0, 0, 0, d, m, y};
+
+    if (pray2_validate_and_parse_no_crc(buf, len, &h) != PRAY2_OK) return -1;
+    if (ovr && pray2_validate_and_parse_no_crc(ovr, ovr_len, &o) != PRAY2_OK) return -1;
+    if (!pray2_sched_init_ex(&s, &h, &t, NULL, ovr ? &o : NULL, NULL)) return 0;
+    memcpy(out_min, s.today_min, sizeof(s.today_min));
+    memcpy(out_on, s.today_on, sizeof(s.today_on));
+    return 1;
+}
+
+int shim_parse_rtc(const char *s, int out[6])
+{
+    return pray2_parse_rtc_ascii(s, &out[0], &out[1], &out[2], &out[3], &out[4], &out[5]);
+}
@@ -0,0 +1,190 @@
+# test_overrides.py
+# Date overrides and weekday rules end to end: rules text ->
+# compile_overrides() / parse_weekly_rules() -> an overrides-only PRAY3 file
+# (overrides_bin.py) or sections of the schedule file -> the firmware scheduler
+# through the shim. Every day must come out as applying the rules to the table
+# in Python would.
+#
+#   python -m pytest tests -q          (from Azan_lookupGenerator/)
+
+from __future__ import annotations
+import ctypes, random
+from datetime import date, timedelta
+import pytest
+
+from pray2_format import (pack_pray3, parse_override_rules, compile_overrides, pack_overrides,
+                          parse_weekly_rules, pack_weekly, PRAYER_BITS, OVR_ABSOLUTE, WEEKDAYS)
+import overrides_bin
+
+SEED = 2026
+DEFAULT_ON = [60, 45, 45, 45, 45]
+
+RULES = """
+# Ramadan 1447
+2026-02-18 2026-03-19  Isha       +120
+2026-02-18 2026-03-19  Fajr       -10    90
+2026-03-20             Dhuhr,Asr  =13:30          # Eid
+2026-03-21             all        0      120
+2026-03-01             Isha       +60             # overrides Ramadan's Isha that day
+Fri                    Dhuhr      =13:30  300     # Jumu'ah
+Mon,Thu                Isha       -5
+"""
+
+
+def base_file(start: date, days: int, rng: random.Random) -> tuple[list, bytes]:
+    rows = [tuple(sorted(rng.sample(range(240, 1200), 5))) for _ in range(days)]
+    return rows, pack_pray3(start, rows, 1, DEFAULT_ON, "12:00:00|01/01/26", 0)
+
+
+def expected(rules, row, d, weekly=None):
+    """
+    Apply rules to one row as the device should: the weekday's rule, then the
+    last dated rule per prayer.
+    """
+    eff = {}
+    for first, last, mask, mode, value, on_sec in rules:
+        if first <= d <= last:
+            for i, bit in enumerate(PRAYER_BITS.values()):
+                if mask & bit:
+                    eff[i] = (mode, value, on_sec)
+    mins, on = list(row), list(DEFAULT_ON)
+    w_mask, *w_eff = weekly[(d.weekday() + 1) % 7] if weekly else (0,)
+    steps = [(i, w_eff) for i in range(5) if w_mask & (1 << i)] + list(eff.items())
+    for i, (mode, value, on_sec) in steps:
+        mins[i] = max(0, min(1439, value if mode & OVR_ABSOLUTE else mins[i] + value))
+        on[i] = on_sec or on[i]
+    for i in range(1, 5):
+        if mins[i] <= mins[i - 1]:
+            mins[i] = min(mins[i - 1] + 1, 1439)
+    return mins, on
+
+
+def day(shim, buf, ovr, d):
+    mins, on = (ctypes.c_uint16 * 5)(), (ctypes.c_uint16 * 5)()
+    rc = shim.shim_day_with_overrides(buf, len(buf), ovr, len(ovr) if ovr else 0,
+                                      d.year, d.month, d.day, mins, on)
+    assert rc == 1, d
+    return list(mins), list(on)
+
+
+def test_rules_parse():
+    rules = parse_override_rules(RULES)
+    assert len(rules) == 5
+    assert rules[0] == (date(2026, 2, 18), date(2026, 3, 19), 0x10, 0, 120, 0)
+    assert rules[2] == (date(2026, 3, 20), date(2026, 3, 20), 0x06, OVR_ABSOLUTE, 13 * 60 + 30, 0)
+    assert rules[3][2] == 0x1F and rules[3][5] == 120
+
+
+@pytest.mark.parametrize("line", ["2026-02-30 Isha +1", "2026-03-02 2026-03-01 Isha +1",
+                                  "2026-03-01 Jumuah +1", "2026-03-01 Isha =24:00",
+                                  "2026-03-01 Isha", "2026-03-01 Isha +1 99999"])
+def test_rules_rejected(line):
+    with pytest.raises(ValueError, match="line 1"):
+        parse_override_rules(line)
+
+
+def test_weekly_rules_parse():
+    table = parse_weekly_rules(RULES)
+    assert table[WEEKDAYS.index("Fri")] == (0x02, OVR_ABSOLUTE, 13 * 60 + 30, 300)
+    assert table[1] == table[4] == (0x10, 0, -5, 0)
+    assert [r[0] for r in table].count(0) == 4
+    assert parse_weekly_rules("2026-03-01 Isha +1") is None
+    assert len(pack_weekly(table)) == 56
+
+
+@pytest.mark.parametrize("text", ["Fri Dhuhr", "Fri Jumuah =13:30", "Fri Dhuhr +1 99999",
+                                  "Sun Isha +1\nSat,sun Isha +2"])
+def test_weekly_rules_rejected(text):
+    with pytest.raises(ValueError, match=f"line {text.count(chr(10)) + 1}"):
+        parse_weekly_rules(text)
+
+
+def test_compiled_entries_do_not_overlap():
+    entries = compile_overrides(parse_override_rules(RULES))
+    starts = sorted({e[0] for e in entries})
+    assert [e[0] for e in entries] == sorted(e[0] for e in entries)
+    for first in starts:
+        group = [e for e in entries if e[0] == first]
+        assert len({e[1] for e in group}) == 1
+    ranges = [(f, f + timedelta(days=[e for e in entries if e[0] == f][0][1])) for f in starts]
+    assert all(a[1] <= b[0] for a, b in zip(ranges, ranges[1:]))
+    # Ramadan split around 1 March; the days after it merge back into one range
+    assert (date(2026, 3, 2), 18) in {(e[0], e[1]) for e in entries}
+
+
+def test_overrides_file_applies_to_every_day(shim, tmp_path):
+    rng = random.Random(SEED)
+    start = date(2026, 1, 1)
+    rows, buf = base_file(start, 120, rng)
+    rules, weekly = parse_override_rules(RULES), parse_weekly_rules(RULES)
+    path = tmp_path / "rules.txt"
+    path.write_text(RULES)
+    out = tmp_path / "override.pray"
+    assert overrides_bin.main(["overrides_bin.py", str(path), str(out)]) == 0
+    ovr = out.read_bytes()
+    assert len(ovr) < 300  # the delta upload
+
+    for k, row in enumerate(rows):
+        d = start + timedelta(days=k)
+        assert day(shim, buf, ovr, d) == expected(rules, row, d, weekly), d
+
+
+def test_too_big_for_device():
+    start = date(2026, 1, 1)
+    text = "\n".join(f"{start + timedelta(days=2 * k)} Isha +{k % 50 + 1}" for k in range(120))
+    with pytest.raises(ValueError, match="at most 1024"):
+        overrides_bin.build(text)
+    assert len(overrides_bin.build("\n".join(text.splitlines()[:20]))) <= overrides_bin.DEVICE_MAX
+
+
+def test_weekly_only_file(shim):
+    rng = random.Random(SEED + 3)
+    start = date(2026, 5, 1)
+    rows, buf = base_file(start, 21, rng)
+    weekly = parse_weekly_rules("Fri Dhuhr =13:30 300")
+    ovr = overrides_bin.build("Fri Dhuhr =13:30 300")
+    fridays = 0
+    for k, row in enumerate(rows):
+        d = start + timedelta(days=k)
+        mins, on = day(shim, buf, ovr, d)
+        assert (mins, on) == expected([], row, d, weekly), d
+        fridays += d.weekday() == 4 and mins[1] == 13 * 60 + 30 and on[1] == 300
+    assert fridays == 3
+
+
+def test_section_in_schedule_file(shim):
+    rng = random.Random(SEED + 1)
+    start = date(2026, 2, 1)
+    rows = [tuple(sorted(rng.sample(range(240, 1200), 5))) for _ in range(60)]
+    rules, weekly = parse_override_rules(RULES), parse_weekly_rules(RULES)
+    buf = pack_pray3(start, rows, 1, DEFAULT_ON, "12:00:00|01/02/26", 0,
+                     overrides=pack_overrides(compile_overrides(rules)), weekly=pack_weekly(weekly))
+    for k, row in enumerate(rows):
+        d = start + timedelta(days=k)
+        assert day(shim, buf, None, d) == expected(rules, row, d, weekly), d
+
+
+def test_random_rules_match(shim):
+    rng = random.Random(SEED + 2)
+    start = date(2026, 1, 1)
+    rows, buf = base_file(start, 200, rng)
+    for _ in range(20):
+        lines = []
+        for _ in range(rng.randint(1, 12)):
+            first = start + timedelta(days=rng.randrange(200))
+            last = first + timedelta(days=rng.randrange(40))
+            prayers = ",".join(rng.sample(list(PRAYER_BITS), rng.randint(1, 3)))
+            change = rng.choice([f"{rng.randint(-90, 90):+d}",
+                                 f"={rng.randrange(24):02d}:{rng.randrange(60):02d}", "0"])
+            on = rng.choice(["", str(rng.randint(1, 300))])
+            lines.append(f"{first} {last} {prayers} {change} {on}")
+        for wd in rng.sample(WEEKDAYS, rng.randint(0, 3)):
+            prayers = ",".join(rng.sample(list(PRAYER_BITS), rng.randint(1, 2)))
+            lines.append(f"{wd} {prayers} {rng.randint(-30, 30):+d} {rng.choice(['', '240'])}")
+        rng.shuffle(lines)
+        text = "\n".join(lines)
+        rules, weekly = parse_override_rules(text), parse_weekly_rules(text)
+        ovr = overrides_bin.build(text)
+        for k in rng.sample(range(200), 40):
+            d = start + timedelta(days=k)
+            assert day(shim, buf, ovr, d) == expected(rules, rows[k], d, weekly), (text, d)
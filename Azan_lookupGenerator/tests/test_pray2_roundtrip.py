@@ -0,0 +1,340 @@
+# test_pray2_roundtrip.py
+# Differential test: files written by pray2_format.pack_pray2 and pack_pray3
+# (the generator's writers) are decoded by the firmware's pray2_reader.h
+# through the shim, and every field, section, table entry, day index and
+# scheduler fire must match.
+#
+#   python -m pytest tests -q          (from Azan_lookupGenerator/)
+
+from __future__ import annotations
+import ctypes, random, struct, zlib
+from datetime import date, timedelta
+import pytest
+
+from pray2_format import (pack_pray2, pack_pray3, pack_location, pack_method, pack_dst,
+                          validate_rtc_ascii, HEADER_SIZE, HEADER3_SIZE, DIR_ENTRY,
+                          LOCATION_SIZE, FLAG_DURATIONS, FLAG_LOCATION, FLAG_RTC_ONE_SHOT)
+from conftest import ROOT, ShimHeader
+
+SEED = 2025
+N_FILES = 3000
+REF_BIN = ROOT / "prayer_2025_20250101-20251231_KARACHI.bin"
+
+
+def rand_rtc(rng: random.Random) -> str:
+    s = (f"{rng.randrange(24):02d}:{rng.randrange(60):02d}:{rng.randrange(60):02d}|"
+         f"{rng.randint(1, 31):02d}/{rng.randint(1, 12):02d}/{rng.randrange(100):02d}")
+    assert validate_rtc_ascii(s) == s
+    return s
+
+
+def rand_start(rng: random.Random) -> date:
+    return date(1900, 1, 1) + timedelta(days=rng.randrange((date(2100, 12, 31) - date(1900, 1, 1)).days))
+
+
+def rand_rows(rng: random.Random, days: int, realistic: bool):
+    """realistic: what compute_minutes_table produces, strictly rising in 1..1439."""
+    rows = []
+    for _ in range(days):
+        if realistic:
+            rows.append(tuple(sorted(rng.sample(range(1, 1440), 5))))
+        else:
+            rows.append(tuple(rng.randrange(0x10000) for _ in range(5)))
+    return rows
+
+
+def rand_location(rng: random.Random):
+    return dict(lat=round(rng.uniform(-90, 90), 6), lon=round(rng.uniform(-180, 180), 6),
+                utc_offset_min=rng.randint(-720, 840),
+                offsets=[rng.randint(-128, 127) for _ in range(5)], asr_shadow=rng.choice([1, 2]))
+
+
+def rand_file(rng: random.Random, realistic: bool = False):
+    start = rand_start(rng)
+    days = rng.choice([1, 1, 28, 29, 30, 31, 365, 366, rng.randint(1, 800)])
+    rows = rand_rows(rng, days, realistic)
+    durations = rand_rows(rng, days, False) if rng.random() < 0.25 else None
+    loc = rand_location(rng) if rng.random() < 0.5 else None
+    args = dict(start=start, rows=rows, method_code=rng.randrange(7),
+                default_on=[rng.randint(0, 36000) for _ in range(5)], rtc_ascii=rand_rtc(rng),
+                flags=rng.choice([0, FLAG_RTC_ONE_SHOT, rng.randrange(256)]), durations=durations,
+                location=pack_location(**loc) if loc else None)
+    return dict(args, loc=loc), pack_pray2(**args)
+
+
+def parse(shim, buf: bytes) -> ShimHeader:
+    h = ShimHeader()
+    st = shim.shim_parse(buf, len(buf), ctypes.byref(h))
+    assert st == 0, f"reader rejected a generator file: status {st} ({shim.shim_last_msg().decode()})"
+    return h
+
+
+def table(shim, buf: bytes, days: int):
+    out = (ctypes.c_uint16 * (days * 5))()
+    assert shim.shim_table(buf, len(buf), out, len(out)) == days
+    return [tuple(out[i * 5:i * 5 + 5]) for i in range(days)]
+
+
+def test_every_field_roundtrips(shim):
+    rng = random.Random(SEED)
+    for _ in range(N_FILES):
+        a, buf = rand_file(rng)
+        h = parse(shim, buf)
+        days = len(a["rows"])
+        has_dur = a["durations"] is not None
+        loc = a["loc"]
+        flags = ((a["flags"] & ~(FLAG_DURATIONS | FLAG_LOCATION)) | (FLAG_DURATIONS if has_dur else 0)
+                 | (FLAG_LOCATION if loc else 0))
+        table_offset = HEADER_SIZE + (LOCATION_SIZE if loc else 0)
+
+        assert (h.year, h.start_month, h.start_day) == (a["start"].year, a["start"].month, a["start"].day)
+        assert h.days == days
+        assert h.flags == flags
+        assert h.method_code == a["method_code"]
+        assert h.rtc_ascii.decode() == a["rtc_ascii"]
+        assert list(h.default_on_sec) == a["default_on"]
+        assert (h.table_offset, h.table_size) == (table_offset, days * 10)
+        assert h.has_durations == has_dur
+        if has_dur:
+            assert (h.durations_offset, h.durations_size) == (table_offset + days * 10, days * 10)
+        else:
+            assert (h.durations_offset, h.durations_size) == (0, 0)
+        assert table(shim, buf, days) == a["rows"]
+        assert h.has_location == (loc is not None)
+        if loc:
+            assert (h.lat_udeg, h.lon_udeg) == (round(loc["lat"] * 1e6), round(loc["lon"] * 1e6))
+            assert (h.utc_offset_min, h.asr_shadow) == (loc["utc_offset_min"], loc["asr_shadow"])
+            assert list(h.offset_min) == loc["offsets"]
+        else:
+            assert (h.lat_udeg, h.lon_udeg, h.utc_offset_min, h.asr_shadow) == (0, 0, 0, 0)
+
+        # The CRC the generator appends covers exactly what the reader says it should.
+        payload = shim.shim_payload_size(buf, len(buf))
+        assert payload == len(buf) - 4
+        assert struct.unpack_from("<I", buf, payload)[0] == zlib.crc32(buf[:payload])
+
+
+def test_day_index_matches_calendar(shim):
+    rng = random.Random(SEED + 1)
+    for _ in range(500):
+        a, buf = rand_file(rng)
+        start, days = a["start"], len(a["rows"])
+        probes = [-1, 0, days - 1, days] + [rng.randrange(days) for _ in range(8)]
+        for k in probes:
+            d = start + timedelta(days=k)
+            want = k if 0 <= k < days else -1
+            assert shim.shim_day_index(buf, len(buf), d.year, d.month, d.day) == want, (start, k)
+
+
+def test_scheduler_fires_generator_rows(shim):
+    rng = random.Random(SEED + 2)
+    n = 0
+    while n < 200:
+        a, buf = rand_file(rng, realistic=True)
+        d = a["start"] + timedelta(days=rng.randrange(len(a["rows"])))
+        if not 2000 <= d.year <= 2099:  # the RTC string carries a two-digit year
+            continue
+        mins = (ctypes.c_uint16 * 5)()
+        prayers = (ctypes.c_uint8 * 5)()
+        on = (ctypes.c_uint16 * 5)()
+        fires = shim.shim_fires_on_day(buf, len(buf), d.year, d.month, d.day, mins, prayers, on)
+        row = a["rows"][(d - a["start"]).days]
+        assert fires == 5
+        assert list(mins) == list(row)
+        assert list(prayers) == [0, 1, 2, 3, 4]
+        assert list(on) == a["default_on"]
+        n += 1
+
+
+def test_rtc_strings_the_generator_accepts(shim):
+    rng = random.Random(SEED + 3)
+    out = (ctypes.c_int * 6)()
+    for _ in range(5000):
+        s = rand_rtc(rng)
+        assert shim.shim_parse_rtc(s.encode(), out) == 1, s
+        want = [int(s[0:2]), int(s[3:5]), int(s[6:8]), int(s[9:11]), int(s[12:14]), 2000 + int(s[15:17])]
+        assert list(out) == want
+
+
+@pytest.mark.parametrize("patch, status", [
+    (lambda b: b[:HEADER_SIZE - 1], 1),                  # too small
+    (lambda b: b"PRAY9" + b[5:], 2),                     # magic
+    (lambda b: b"PRAY3" + b[5:], 3),                     # PRAY3 magic, version 2
+    (lambda b: b[:48] + struct.pack("<I", 11) + b[52:], 6),  # table_size != days*10
+    (lambda b: b[:12] + bytes([13]) + b[13:], 9),        # start month
+    (lambda b: b[:12] + bytes([2, 30]) + b[14:], 9),     # 30 February
+])
+def test_reader_rejects_what_generator_never_writes(shim, patch, status):
+    _, buf = rand_file(random.Random(SEED + 4))
+    bad = patch(buf)
+    assert shim.shim_parse(bad, len(bad), ctypes.byref(ShimHeader())) == status
+
+
+@pytest.mark.parametrize("patch", [
+    lambda b: b[:44] + struct.pack("<I", HEADER_SIZE) + b[48:],  # table over the section
+    lambda b: b[:64] + struct.pack("<i", 90_000_001) + b[68:],   # latitude
+    lambda b: b[:72] + struct.pack("<h", 841) + b[74:],          # UTC offset
+    lambda b: b[:74] + bytes([3]) + b[75:],                      # Asr shadow factor
+])
+def test_reader_rejects_bad_location(shim, patch):
+    rows = [(300, 720, 900, 1080, 1200)] * 3
+    loc = pack_location(30.033, 40.55, 300, [0, 1, -1, 2, -2])
+    buf = pack_pray2(date(2025, 12, 29), rows, 1, [60, 45, 45, 45, 45], "12:00:00|29/12/25", 0,
+                     location=loc)
+    assert parse(shim, buf).has_location
+    bad = patch(buf)
+    assert shim.shim_parse(bad, len(bad), ctypes.byref(ShimHeader())) == 10  # PRAY2_ERR_LOCATION
+
+
+def rand_pray3(rng: random.Random):
+    a, _ = rand_file(rng)
+    del a["loc"]
+    a["flags"] &= FLAG_RTC_ONE_SHOT
+    if a["method_code"] == 0:
+        a["method"] = (round(rng.uniform(10, 20), 2), round(rng.uniform(10, 20), 2),
+                       rng.choice([0, 90, 120]))
+    if rng.random() < 0.5:
+        first = rng.randrange(-20000, 40000)
+        a["dst"] = [(date(1970, 1, 1) + timedelta(days=first + 180 * i), rng.choice([0, 60, 300, 330]))
+                    for i in range(rng.randint(0, 20))]
+    if rng.random() < 0.3:
+        a["extra"] = [(rng.randint(8, 0xFFFF), rng.randbytes(rng.randrange(40)))]
+    args = dict(a, method=pack_method(*a["method"]) if "method" in a else None,
+                dst=pack_dst(a["dst"]) if "dst" in a else None)
+    return a, pack_pray3(**args)
+
+
+def test_pray3_every_section_roundtrips(shim):
+    rng = random.Random(SEED + 6)
+    for _ in range(1000):
+        a, buf = rand_pray3(rng)
+        h = parse(shim, buf)
+        days = len(a["rows"])
+        assert h.version == 3
+        assert (h.year, h.start_month, h.start_day, h.days) == (a["start"].year, a["start"].month,
+                                                                a["start"].day, days)
+        assert (h.flags, h.method_code) == (a["flags"], a["method_code"])
+        assert h.rtc_ascii.decode() == a["rtc_ascii"]
+        assert list(h.default_on_sec) == a["default_on"]
+        assert h.has_durations == (a["durations"] is not None)
+        assert table(shim, buf, days) == a["rows"]
+        assert bool(h.has_location) == (a["location"] is not None)
+        assert bool(h.has_method) == ("method" in a)
+        if "method" in a:
+            fajr, isha, interval = a["method"]
+            assert (h.fajr_cdeg, h.isha_cdeg, h.isha_interval_min) == (round(fajr * 100),
+                                                                       round(isha * 100), interval)
+        days_out = (ctypes.c_int32 * 32)()
+        offs_out = (ctypes.c_int16 * 32)()
+        n = shim.shim_dst(buf, len(buf), days_out, offs_out, 32)
+        want = [((d - date(1970, 1, 1)).days, off) for d, off in a.get("dst", [])]
+        assert list(zip(days_out[:n], offs_out[:n])) == want
+
+        payload = shim.shim_payload_size(buf, len(buf))
+        assert payload == len(buf) - 4
+        assert struct.unpack_from("<I", buf, payload)[0] == zlib.crc32(buf[:payload])
+
+
+def test_pray3_reads_only_what_is_used(shim):
+    rng = random.Random(SEED + 7)
+    rows = rand_rows(rng, 3 * 366, True)
+    buf = pack_pray3(date(2025, 1, 1), rows, 1, [60, 45, 45, 45, 45], "12:00:00|01/01/25", 0,
+                     durations=rows, location=pack_location(24.86, 67.0, 300, [0] * 5),
+                     dst=pack_dst([(date(2026, 3, 29), 360)]))
+    out = (ctypes.c_uint16 * 10)()
+    read = ctypes.c_uint32()
+    assert shim.shim_rows_lazy(buf, len(buf), 700, 2, out, ctypes.byref(read)) == 2
+    assert [tuple(out[0:5]), tuple(out[5:10])] == rows[700:702]
+    # Header and directory at open, then one row each: not the 22 KB file
+    assert read.value <= HEADER3_SIZE + 16 * DIR_ENTRY.size + 2 * 10
+
+
+def test_pray2_and_pray3_agree(shim):
+    rng = random.Random(SEED + 8)
+    for _ in range(200):
+        a, buf2 = rand_file(rng)
+        loc = a.pop("loc")
+        buf3 = pack_pray3(**a)
+        h2, h3 = parse(shim, buf2), parse(shim, buf3)
+        for f in ("year", "days", "start_month", "start_day", "method_code", "has_location",
+                  "lat_udeg", "lon_udeg", "utc_offset_min", "asr_shadow", "has_durations"):
+            assert getattr(h2, f) == getattr(h3, f), f
+        assert (h2.version, h3.version) == (2, 3)
+        assert bool(h3.has_location) == (loc is not None)
+        assert table(shim, buf2, h2.days) == table(shim, buf3, h3.days)
+
+
+@pytest.mark.parametrize("patch, status", [
+    (lambda b: b[:33] + bytes([0]) + b[34:], 11),                           # no sections
+    (lambda b: b[:33] + bytes([17]) + b[34:], 11),                          # too many
+    (lambda b: b[:HEADER3_SIZE + 8] + struct.pack("<I", 11) + b[HEADER3_SIZE + 12:], 6),  # times
+    (lambda b: b[:HEADER3_SIZE + 4] + struct.pack("<I", 1 << 20) + b[HEADER3_SIZE + 8:], 11),  # past end
+    (lambda b: b[:6] + struct.pack("<H", 64) + b[8:], 4),                  # header size
+])
+def test_reader_rejects_bad_pray3(shim, patch, status):
+    rows = [(300, 720, 900, 1080, 1200)] * 3
+    buf = pack_pray3(date(2025, 12, 29), rows, 1, [60, 45, 45, 45, 45], "12:00:00|29/12/25", 0,
+                     location=pack_location(30.033, 40.55, 300, [0] * 5))
+    assert parse(shim, buf).has_location
+    bad = patch(buf)
+    assert shim.shim_parse(bad, len(bad), ctypes.byref(ShimHeader())) == status
+
+
+def test_reference_file_repacks_identically(shim):
+    if not REF_BIN.exists():
+        pytest.skip(f"{REF_BIN.name} not present")
+    buf = REF_BIN.read_bytes()
+    h = parse(shim, buf)
+    rows = table(shim, buf, h.days)
+    again = pack_pray2(date(h.year, h.start_month, h.start_day), rows, h.method_code,
+                       list(h.default_on_sec), h.rtc_ascii.decode(), h.flags)
+    assert again == buf
+
+
+def test_adhanpy_tables_roundtrip(shim, tmp_path):
+    """The full generator path, when adhanpy is installed."""
+    pytest.importorskip("adhanpy")
+    import span_params_with_adhanpy_csv_bin as gen
+
+    rng = random.Random(SEED + 5)
+    for i in range(20):
+        start = date(rng.randint(2024, 2030), rng.randint(1, 12), 1)
+        end = start + timedelta(days=rng.randint(0, 40))
+        lat, lon = rng.uniform(-55, 55), rng.uniform(-180, 180)
+        method = rng.choice(list(gen.METHOD_MAP))
+        offsets = {p: rng.randint(-10, 10) for p in gen.PRAYERS}
+        on = [rng.randint(0, 36000) for _ in range(5)]
+        path = tmp_path / f"gen{i}.bin"
+        gen.write_pray2_bin(path, start, end, lat, lon, "UTC", method, offsets, on,
+                            rand_rtc(rng), FLAG_RTC_ONE_SHOT)
+
+        buf = path.read_bytes()
+        h = parse(shim, buf)
+        assert h.method_code == gen.METHOD_CODE[method]
+        assert h.has_location and h.utc_offset_min == 0
+        assert list(h.offset_min) == [offsets[p] for p in gen.PRAYERS]
+        assert table(shim, buf, h.days) == gen.compute_minutes_table(start, end, lat, lon, "UTC",
+                                                                      method, offsets)
+
+
+def test_adhanpy_pray3_carries_dst(shim, tmp_path):
+    pytest.importorskip("adhanpy")
+    import span_params_with_adhanpy_csv_bin as gen
+
+    start, end = date(2025, 1, 1), date(2025, 1, 31)
+    offsets = {p: 0 for p in gen.PRAYERS}
+    path = tmp_path / "london.bin"
+    gen.write_pray2_bin(path, start, end, 51.5, -0.13, "Europe/London", "MUSLIM_WORLD_LEAGUE",
+                        offsets, [60, 45, 45, 45, 45], "12:00:00|01/01/25", 0, pray3=True)
+    buf = path.read_bytes()
+    h = parse(shim, buf)
+    assert h.version == 3 and h.has_location and h.utc_offset_min == 0
+    assert table(shim, buf, h.days) == gen.compute_minutes_table(start, end, 51.5, -0.13,
+                                                                  "Europe/London",
+                                                                  "MUSLIM_WORLD_LEAGUE", offsets)
+    days_out = (ctypes.c_int32 * 32)()
+    offs_out = (ctypes.c_int16 * 32)()
+    n = shim.shim_dst(buf, len(buf), days_out, offs_out, 32)
+    assert n == 20  # ten years of BST on and off
+    first = date(1970, 1, 1) + timedelta(days=days_out[0])
+    assert (first, offs_out[0], offs_out[1]) == (date(2025, 3, 30), 60, 0)
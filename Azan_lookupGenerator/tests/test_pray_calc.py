@@ -0,0 +1,131 @@
+# test_pray_calc.py
+# Differential test: the firmware's on-device computation (src/pray_calc.c,
+# built by conftest) against the generator's adhanpy tables, row for row.
+#
+#   python -m pytest tests -q          (from Azan_lookupGenerator/)
+#
+# pray_calc runs in single precision, so a time whose seconds land within a
+# few milliseconds of adhanpy's rounding point (:30 / :31) can round the other
+# way. The reference year must match exactly; elsewhere only a small share of
+# days may differ, by one minute in one prayer.
+
+from __future__ import annotations
+import ctypes, random
+from datetime import date, timedelta
+import pytest
+
+from conftest import CalcParams, ShimHeader
+
+adhanpy = pytest.importorskip("adhanpy")
+import span_params_with_adhanpy_csv_bin as gen  # noqa: E402
+
+SEED = 2026
+REF = dict(lat=30.033, lon=40.55, tz="Asia/Karachi", method="KARACHI")
+
+# (lat, lon, fixed zone, its UTC offset in minutes); Etc/GMT signs are inverted
+LOCATIONS = [
+    (24.86, 67.01, "Etc/GMT-5", 300),
+    (21.42, 39.83, "Etc/GMT-3", 180),
+    (51.50, -0.12, "Etc/GMT", 0),
+    (40.71, -74.00, "Etc/GMT+5", -300),
+    (-33.87, 151.21, "Etc/GMT-10", 600),
+    (1.35, 103.80, "Etc/GMT-8", 480),
+    (-54.80, -68.30, "Etc/GMT+3", -180),
+]
+
+
+def params(lat, lon, utc_offset_min, method, offsets=None) -> CalcParams:
+    p = CalcParams(lat=lat, lon=lon, utc_offset_min=utc_offset_min,
+                   method=gen.METHOD_CODE[method], asr_shadow=1)
+    for i, name in enumerate(gen.PRAYERS):
+        p.offset_min[i] = (offsets or {}).get(name, 0)
+    return p
+
+
+def calc_row(calc, p: CalcParams, d: date):
+    out = (ctypes.c_uint16 * 5)()
+    assert calc.pray_calc_day(ctypes.byref(p), d.year, d.month, d.day, out), d
+    return tuple(out)
+
+
+def test_reference_year_exact(calc):
+    start, end = date(2025, 1, 1), date(2025, 12, 31)
+    offsets = {name: 0 for name in gen.PRAYERS}
+    want = gen.compute_minutes_table(start, end, REF["lat"], REF["lon"], REF["tz"], REF["method"],
+                                     offsets)
+    p = params(REF["lat"], REF["lon"], 300, REF["method"])
+    got = [calc_row(calc, p, start + timedelta(days=i)) for i in range(len(want))]
+    assert got == want
+
+
+@pytest.mark.parametrize("method", list(gen.METHOD_MAP))
+def test_methods_and_locations(calc, method):
+    rng = random.Random(f"{SEED}-{method}")
+    days = differ = 0
+    for lat, lon, tz, utc in LOCATIONS:
+        offsets = {name: rng.randint(-10, 10) for name in gen.PRAYERS}
+        p = params(lat, lon, utc, method, offsets)
+        for _ in range(40):
+            d = date(2000, 1, 1) + timedelta(days=rng.randrange(365 * 60))
+            want = gen.compute_minutes_table(d, d, lat, lon, tz, method, offsets)[0]
+            got = calc_row(calc, p, d)
+            days += 1
+            if got != want:
+                differ += 1
+                diff = [abs(a - b) for a, b in zip(got, want)]
+                assert sorted(diff)[-2:] == [0, 1], (lat, lon, d, got, want)
+    assert differ <= days // 100, f"{differ} of {days} days differ"
+
+
+def test_asr_shadow_and_custom_angles(calc):
+    """Hanafi Asr is later; a CUSTOM method with Karachi's angles is Karachi bar Dhuhr +1."""
+    d = date(2025, 6, 21)
+    shafi = calc_row(calc, params(REF["lat"], REF["lon"], 300, "KARACHI"), d)
+    p = params(REF["lat"], REF["lon"], 300, "KARACHI")
+    p.asr_shadow = 2
+    hanafi = calc_row(calc, p, d)
+    assert hanafi[2] > shafi[2] and hanafi[:2] == shafi[:2] and hanafi[3:] == shafi[3:]
+
+    custom = params(REF["lat"], REF["lon"], 300, "CUSTOM")
+    custom.fajr_angle = custom.isha_angle = 18.0
+    row = calc_row(calc, custom, d)
+    assert (row[0], row[1] + 1, *row[2:]) == shafi
+
+
+def test_polar_day_is_refused(calc):
+    out = (ctypes.c_uint16 * 5)()
+    p = params(78.22, 15.65, 60, "KARACHI")  # Longyearbyen, midnight sun
+    assert not calc.pray_calc_day(ctypes.byref(p), 2025, 6, 21, out)
+
+
+def test_fallback_continues_generator_table(calc, shim, tmp_path):
+    """After a file's span the firmware computes from its location section."""
+    start, end = date(2025, 11, 1), date(2025, 12, 31)
+    offsets = {"Fajr": -3, "Dhuhr": 2, "Asr": 0, "Maghrib": 1, "Isha": 5}
+    path = tmp_path / "span.bin"
+    gen.write_pray2_bin(path, start, end, REF["lat"], REF["lon"], REF["tz"], REF["method"], offsets,
+                        [60, 45, 45, 45, 45], "12:00:00|01/11/25", 0)
+    buf = path.read_bytes()
+    h = ShimHeader()
+    assert shim.shim_parse(buf, len(buf), ctypes.byref(h)) == 0 and h.has_location
+
+    p = CalcParams(lat=h.lat_udeg * 1e-6, lon=h.lon_udeg * 1e-6, utc_offset_min=h.utc_offset_min,
+                   method=h.method_code, asr_shadow=h.asr_shadow)
+    p.offset_min[:] = list(h.offset_min)
+    after = [end + timedelta(days=k) for k in range(1, 61)]
+    want = gen.compute_minutes_table(after[0], after[-1], REF["lat"], REF["lon"], REF["tz"],
+                                     REF["method"], offsets)
+    assert [calc_row(calc, p, d) for d in after] == want
+
+
+def test_offset_past_midnight_wraps(calc):
+    """Like the generator's datetime arithmetic, an offset past midnight wraps, then rows rise."""
+    lat, lon, tz, utc = 24.86, 67.01, "Etc/GMT-8", 480  # Karachi three hours east: Isha ~23:00
+    offsets = {name: 0 for name in gen.PRAYERS}
+    offsets["Isha"] = 120
+    p = params(lat, lon, utc, "KARACHI", offsets)
+    start = date(2025, 6, 1)
+    want = gen.compute_minutes_table(start, start + timedelta(days=29), lat, lon, tz, "KARACHI", offsets)
+    got = [calc_row(calc, p, start + timedelta(days=i)) for i in range(len(want))]
+    assert got == want
+    assert all(row[4] == row[3] + 1 for row in got)  # wrapped to after midnight, lifted past Maghrib
@@ -17,6 +17,8 @@
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/i2c.h>
 #include <RTCmcp7940.h>
+#include "app_trace.h"
+#include "app_counters.h"
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/timeutil.h>
@@ -75,7 +77,10 @@ static int read_register(const struct device *dev, uint8_t addr, uint8_t *val)
 {
 	const struct mcp7940n_config *cfg = dev->config;
 
+	APP_TRACE_BEGIN(RTC_I2C, (uint32_t)addr << 16 | 1u);
 	int rc = i2c_write_read_dt(&cfg->i2c, &addr, sizeof(addr), val, 1);
+	APP_TRACE_END(RTC_I2C, rc);
+	if (rc) APP_CNT_INC(I2C_ERRORS);
 
 	return rc;
 }
@@ -93,7 +98,11 @@ static int write_register(const struct device *dev, enum mcp7940n_register addr,
 	const struct mcp7940n_config *cfg = dev->config;
 	uint8_t time_data[2] = {addr, value};
 
-	return i2c_write_dt(&cfg->i2c, time_data, sizeof(time_data));
+	APP_TRACE_BEGIN(RTC_I2C, (uint32_t)addr << 16 | 1u);
+	int rc = i2c_write_dt(&cfg->i2c, time_data, sizeof(time_data));
+	APP_TRACE_END(RTC_I2C, rc);
+	if (rc) APP_CNT_INC(I2C_ERRORS);
+	return rc;
 }
 
 /**
@@ -128,7 +137,11 @@ static int write_data_block(const struct device *dev, enum mcp7940n_register add
 	time_data[0] = addr;
 	memcpy(&time_data[1], write_block_start, size);
 
-	return i2c_write_dt(&cfg->i2c, time_data, size + 1);
+	APP_TRACE_BEGIN(RTC_I2C, (uint32_t)addr << 16 | size);
+	int rc = i2c_write_dt(&cfg->i2c, time_data, size + 1);
+	APP_TRACE_END(RTC_I2C, rc);
+	if (rc) APP_CNT_INC(I2C_ERRORS);
+	return rc;
 }
 
 /**
@@ -161,8 +174,12 @@ int RTCmcp7940_get_datetime(const struct device *dev, char *time_str)
 
 		//	k_sem_take(&data->lock, K_FOREVER);
 
+	APP_CNT_INC(RTC_READS);
+	APP_TRACE_BEGIN(RTC_I2C, (uint32_t)addr << 16 | RTC_TIME_REGISTERS_SIZE);
 	int rc = i2c_write_read_dt(&cfg->i2c, &addr, sizeof(addr), &data->registers,
 				   RTC_TIME_REGISTERS_SIZE);
+	APP_TRACE_END(RTC_I2C, rc);
+	if (rc) APP_CNT_INC(I2C_ERRORS);
 
 	if (rc < 0) {
 		LOG_ERR("Failed to read datetime");
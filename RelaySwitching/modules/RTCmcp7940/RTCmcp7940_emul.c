@@ -0,0 +1,196 @@
+/**
+ * @file RTCmcp7940_emul.c
+ * @brief I2C emulator for the MCP7940N RTC.
+ *
+ * Register writes land in a 0x60-byte register file; the driver's
+ * write-pointer/read protocol (register address first, auto-increment) is
+ * honoured. Registers 0x00-0x06 are recomputed from the running clock before
+ * every read, and a write to any of them re-bases the clock on what was
+ * written. Clearing ST stops the clock, as on the real part.
+ */
+
+#define DT_DRV_COMPAT zephyr_rtcmcp7940
+
+#include "RTCmcp7940.h"
+#include "RTCmcp7940_emul.h"
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/timeutil.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#define EMUL_ST_BIT      BIT(7) /**< REG_RTC_SEC: oscillator start */
+#define EMUL_OSCRUN_BIT  BIT(5) /**< REG_RTC_WDAY: oscillator running */
+#define EMUL_LPYR_BIT    BIT(5) /**< REG_RTC_MONTH: leap year */
+#define EMUL_12H_BIT     BIT(6) /**< REG_RTC_HOUR: 12-hour mode */
+#define EMUL_PM_BIT      BIT(5) /**< REG_RTC_HOUR: PM in 12-hour mode */
+
+/* 2025-01-01 00:00:00 UTC, the first day of the reference schedule. */
+#define EMUL_DEFAULT_EPOCH 1735689600
+
+#define BCD_TO_BIN(val) (((val) >> 4) * 10 + ((val) & 0x0F))
+#define BIN_TO_BCD(val) ((((val) / 10) << 4) | ((val) % 10))
+
+/**
+ * @brief Runtime state of one emulated MCP7940N.
+ */
+struct mcp7940n_emul_data {
+	struct k_spinlock lock;
+	uint8_t regs[REG_INVAL]; /**< Register file and SRAM */
+	uint8_t ptr;             /**< Register address pointer */
+	time_t base;             /**< Clock value at base_ms */
+	int64_t base_ms;         /**< Uptime the clock was last set */
+	bool running;            /**< ST bit state */
+};
+
+static time_t emul_now(const struct mcp7940n_emul_data *data)
+{
+	if (!data->running) {
+		return data->base;
+	}
+	return data->base + (time_t)((k_uptime_get() - data->base_ms) / 1000);
+}
+
+/* Refresh 0x00-0x06 from the clock, keeping the control bits software set. */
+static void emul_regs_from_clock(struct mcp7940n_emul_data *data)
+{
+	time_t now = emul_now(data);
+	struct tm tm;
+	uint8_t *r = data->regs;
+
+	gmtime_r(&now, &tm);
+	int year = tm.tm_year + 1900;
+	bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+
+	r[REG_RTC_SEC] = (r[REG_RTC_SEC] & EMUL_ST_BIT) | BIN_TO_BCD(tm.tm_sec);
+	r[REG_RTC_MIN] = BIN_TO_BCD(tm.tm_min);
+	if (r[REG_RTC_HOUR] & EMUL_12H_BIT) {
+		int h12 = tm.tm_hour % 12 ? tm.tm_hour % 12 : 12;
+
+		r[REG_RTC_HOUR] = EMUL_12H_BIT | (tm.tm_hour >= 12 ? EMUL_PM_BIT : 0) |
+				  BIN_TO_BCD(h12);
+	} else {
+		r[REG_RTC_HOUR] = BIN_TO_BCD(tm.tm_hour);
+	}
+	r[REG_RTC_WDAY] = (r[REG_RTC_WDAY] & 0x18) | (data->running ? EMUL_OSCRUN_BIT : 0) |
+			  (tm.tm_wday + 1);
+	r[REG_RTC_DATE] = BIN_TO_BCD(tm.tm_mday);
+	r[REG_RTC_MONTH] = (leap ? EMUL_LPYR_BIT : 0) | BIN_TO_BCD(tm.tm_mon + 1);
+	r[REG_RTC_YEAR] = BIN_TO_BCD(year % 100);
+}
+
+/* Re-base the clock on whatever is now in 0x00-0x06. */
+static void emul_clock_from_regs(struct mcp7940n_emul_data *data)
+{
+	const uint8_t *r = data->regs;
+	struct tm tm = {0};
+	uint8_t hr = r[REG_RTC_HOUR];
+
+	tm.tm_sec = BCD_TO_BIN(r[REG_RTC_SEC] & 0x7F);
+	tm.tm_min = BCD_TO_BIN(r[REG_RTC_MIN] & 0x7F);
+	if (hr & EMUL_12H_BIT) {
+		tm.tm_hour = BCD_TO_BIN(hr & 0x1F) % 12 + ((hr & EMUL_PM_BIT) ? 12 : 0);
+	} else {
+		tm.tm_hour = BCD_TO_BIN(hr & 0x3F);
+	}
+	tm.tm_mday = BCD_TO_BIN(r[REG_RTC_DATE] & 0x3F);
+	tm.tm_mon = BCD_TO_BIN(r[REG_RTC_MONTH] & 0x1F) - 1;
+	tm.tm_year = BCD_TO_BIN(r[REG_RTC_YEAR]) + 100;
+
+	data->base = timeutil_timegm(&tm);
+	data->base_ms = k_uptime_get();
+	data->running = (r[REG_RTC_SEC] & EMUL_ST_BIT) != 0;
+}
+
+static int mcp7940n_emul_transfer(const struct emul *target, struct i2c_msg *msgs,
+				  int num_msgs, int addr)
+{
+	struct mcp7940n_emul_data *data = target->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+	bool pointer_set = false;
+	bool time_written = false;
+
+	ARG_UNUSED(addr);
+
+	/* Time registers are latched at the start of a read, as on the chip. */
+	emul_regs_from_clock(data);
+
+	for (int m = 0; m < num_msgs; m++) {
+		struct i2c_msg *msg = &msgs[m];
+
+		for (uint32_t i = 0; i < msg->len; i++) {
+			if (msg->flags & I2C_MSG_READ) {
+				msg->buf[i] = data->regs[data->ptr];
+			} else if (!pointer_set) {
+				data->ptr = msg->buf[i];
+				pointer_set = true;
+				if (data->ptr >= REG_INVAL) {
+					k_spin_unlock(&data->lock, key);
+					return -EIO;
+				}
+				continue;
+			} else {
+				data->regs[data->ptr] = msg->buf[i];
+				time_written |= data->ptr <= REG_RTC_YEAR;
+			}
+			data->ptr = (data->ptr + 1) % REG_INVAL;
+		}
+	}
+
+	if (time_written) {
+		emul_clock_from_regs(data);
+	}
+
+	k_spin_unlock(&data->lock, key);
+	return 0;
+}
+
+void mcp7940n_emul_set_time(const struct emul *target, time_t epoch)
+{
+	struct mcp7940n_emul_data *data = target->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+	data->base = epoch;
+	data->base_ms = k_uptime_get();
+	data->running = true;
+	data->regs[REG_RTC_SEC] |= EMUL_ST_BIT;
+
+	k_spin_unlock(&data->lock, key);
+}
+
+time_t mcp7940n_emul_get_time(const struct emul *target)
+{
+	struct mcp7940n_emul_data *data = target->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+	time_t now = emul_now(data);
+
+	k_spin_unlock(&data->lock, key);
+	return now;
+}
+
+static const struct i2c_emul_api mcp7940n_emul_api = {
+	.transfer = mcp7940n_emul_transfer,
+};
+
+static int mcp7940n_emul_init(const struct emul *target, const struct device *parent)
+{
+	struct mcp7940n_emul_data *data = target->data;
+
+	ARG_UNUSED(parent);
+
+	/* A board with a good backup battery: clock already set and running. */
+	memset(data->regs, 0, sizeof(data->regs));
+	mcp7940n_emul_set_time(target, EMUL_DEFAULT_EPOCH);
+	return 0;
+}
+
+#define MCP7940N_EMUL(n)                                                        \
+	static struct mcp7940n_emul_data mcp7940n_emul_data_##n;                \
+	EMUL_DT_INST_DEFINE(n, mcp7940n_emul_init, &mcp7940n_emul_data_##n,     \
+			    NULL, &mcp7940n_emul_api, NULL)
+
+DT_INST_FOREACH_STATUS_OKAY(MCP7940N_EMUL)
@@ -0,0 +1,32 @@
+/**
+ * @file RTCmcp7940_emul.h
+ * @brief I2C emulator for the MCP7940N RTC (native_sim).
+ *
+ * The emulator keeps the MCP7940N register file and derives the time-keeping
+ * registers from kernel uptime, so the clock runs at simulated speed: with
+ * native_sim --no-rt a day of schedule passes in seconds.
+ */
+
+#ifndef CUSTOM_MODULE_RTCMCP7940_EMUL_H
+#define CUSTOM_MODULE_RTCMCP7940_EMUL_H
+
+#include <zephyr/drivers/emul.h>
+#include <time.h>
+
+/**
+ * @brief Sets the emulated clock and starts the oscillator.
+ *
+ * @param target Emulator instance.
+ * @param epoch Seconds since 1970-01-01 UTC.
+ */
+void mcp7940n_emul_set_time(const struct emul *target, time_t epoch);
+
+/**
+ * @brief Returns the emulated clock as seconds since 1970-01-01 UTC.
+ *
+ * @param target Emulator instance.
+ * @return Current emulated time.
+ */
+time_t mcp7940n_emul_get_time(const struct emul *target);
+
+#endif /* CUSTOM_MODULE_RTCMCP7940_EMUL_H */
@@ -4,6 +4,8 @@
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/i2c.h>
 #include <ssd1306.h>
+#include "app_trace.h"
+#include "app_counters.h"
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/timeutil.h>
@@ -33,7 +35,7 @@ static int ssd1306_check_device_exists(const struct device *dev)
 	
    const struct ssd1306_config *cfg = dev->config;
     uint8_t dummy_data = 0;
-    int ret = i2c_write_dt(&cfg->i2c, dummy_data, sizeof(dummy_data));
+    int ret = i2c_write_dt(&cfg->i2c, &dummy_data, sizeof(dummy_data));
 	return ret;
 }
 
@@ -68,12 +70,15 @@ int ssd1306_UpdateScreen(const struct device *dev)
     //  * 32px   ==  4 pages
     //  * 64px   ==  8 pages
     //  * 128px  ==  16 pages
+    APP_TRACE_BEGIN(OLED_UPDATE, 0);
+    APP_CNT_INC(DISP_FLUSHES);
     for(uint8_t i = 0; i < SSD1306_HEIGHT/8; i++) {
         ssd1306_WriteCommand(dev,0xB0 + i); // Set the current RAM page address.
         ssd1306_WriteCommand(dev,0x00 + SSD1306_X_OFFSET_LOWER);
         ssd1306_WriteCommand(dev,0x10 + SSD1306_X_OFFSET_UPPER);
         ssd1306_WriteData(dev,&SSD1306_Buffer[SSD1306_WIDTH*i],SSD1306_WIDTH);
     }
+    APP_TRACE_END(OLED_UPDATE, 0);
 
     return 0;
 }
@@ -474,13 +479,21 @@ int ssd1306_Reset(const struct device *dev)
 int ssd1306_WriteCommand(const struct device *dev,uint8_t byte)
 {
     const struct ssd1306_config *cfg = dev->config;
+	APP_TRACE_BEGIN(OLED_I2C, 0x00u << 16 | 1u);
 	int ret = i2c_burst_write_dt(&cfg->i2c,0x00,&byte,1);
+	APP_CNT_ADD(DISP_BYTES, 1);
+	APP_TRACE_END(OLED_I2C, ret);
+	if (ret) APP_CNT_INC(I2C_ERRORS);
 	return ret;
 }
 int ssd1306_WriteData(const struct device *dev,uint8_t* buffer, size_t buff_size)
 {
    const struct ssd1306_config *cfg = dev->config;
+	APP_TRACE_BEGIN(OLED_I2C, 0x40u << 16 | buff_size);
 	int ret = i2c_burst_write_dt(&cfg->i2c,0x40,buffer,buff_size);
+	APP_CNT_ADD(DISP_BYTES, buff_size);
+	APP_TRACE_END(OLED_I2C, ret);
+	if (ret) APP_CNT_INC(I2C_ERRORS);
 	return ret;
 }
 SSD1306_Error_t ssd1306_FillBuffer(const struct device *dev,uint8_t* buf, uint32_t len)
@@ -0,0 +1,223 @@
+/**
+ * @file ssd1306_emul.c
+ * @brief I2C emulator for the SSD1306 OLED controller.
+ *
+ * Every transfer starts with a control byte: 0x00 for a command stream,
+ * 0x40 for display data. Commands that take parameters swallow the following
+ * bytes of the stream. Data is written at the current page/column and the
+ * column wraps to the next page, which covers both the page and horizontal
+ * addressing modes the driver uses.
+ */
+
+#define DT_DRV_COMPAT zephyr_ssd1306
+
+#include "ssd1306_emul.h"
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+
+#define EMUL_CTRL_DATA 0x40
+#define EMUL_PAGES     (SSD1306_HEIGHT / 8)
+
+struct ssd1306_emul_data {
+	uint8_t gddram[SSD1306_BUFFER_SIZE];
+	uint8_t page;
+	uint8_t col;
+	uint8_t cmd;      /* command waiting for parameters */
+	uint8_t pending;  /* parameter bytes still expected */
+	uint8_t contrast;
+	bool on;
+	uint32_t frames;
+	ssd1306_emul_frame_cb frame_cb;
+	void *frame_user;
+};
+
+/* Number of parameter bytes after a command opcode. */
+static uint8_t cmd_params(uint8_t cmd)
+{
+	switch (cmd) {
+	case 0x20: /* memory addressing mode */
+	case 0x81: /* contrast */
+	case 0x8D: /* charge pump */
+	case 0xA8: /* multiplex ratio */
+	case 0xD3: /* display offset */
+	case 0xD5: /* clock divide */
+	case 0xD9: /* pre-charge */
+	case 0xDA: /* COM pins */
+	case 0xDB: /* VCOMH */
+		return 1;
+	case 0x21: /* column address range */
+	case 0x22: /* page address range */
+		return 2;
+	default:
+		return 0;
+	}
+}
+
+static void emul_command(struct ssd1306_emul_data *data, uint8_t byte)
+{
+	if (data->pending) {
+		data->pending--;
+		switch (data->cmd) {
+		case 0x81:
+			data->contrast = byte;
+			break;
+		case 0x21:
+			if (data->pending) {
+				data->col = byte % SSD1306_WIDTH;
+			}
+			break;
+		case 0x22:
+			if (data->pending) {
+				data->page = byte % EMUL_PAGES;
+			}
+			break;
+		default:
+			break;
+		}
+		return;
+	}
+
+	if (byte <= 0x0F) {
+		data->col = (data->col & 0xF0) | byte;
+	} else if (byte <= 0x1F) {
+		data->col = ((byte & 0x0F) << 4) | (data->col & 0x0F);
+	} else if (byte >= 0xB0 && byte <= 0xB7) {
+		data->page = (byte & 0x07) % EMUL_PAGES;
+	} else if (byte == 0xAE || byte == 0xAF) {
+		data->on = byte == 0xAF;
+	} else {
+		data->cmd = byte;
+		data->pending = cmd_params(byte);
+	}
+}
+
+static void emul_data(const struct emul *target, struct ssd1306_emul_data *data, uint8_t byte)
+{
+	data->gddram[data->page * SSD1306_WIDTH + (data->col % SSD1306_WIDTH)] = byte;
+
+	if (++data->col < SSD1306_WIDTH) {
+		return;
+	}
+	data->col = 0;
+	data->page = (data->page + 1) % EMUL_PAGES;
+	if (data->page == 0) {
+		data->frames++;
+		if (data->frame_cb) {
+			data->frame_cb(target, data->frame_user);
+		}
+	}
+}
+
+static int ssd1306_emul_transfer(const struct emul *target, struct i2c_msg *msgs,
+				 int num_msgs, int addr)
+{
+	struct ssd1306_emul_data *data = target->data;
+	bool have_ctrl = false;
+	bool is_data = false;
+
+	ARG_UNUSED(addr);
+
+	for (int m = 0; m < num_msgs; m++) {
+		if (msgs[m].flags & I2C_MSG_READ) {
+			return -EIO; /* write-only over I2C */
+		}
+		for (uint32_t i = 0; i < msgs[m].len; i++) {
+			uint8_t byte = msgs[m].buf[i];
+
+			if (!have_ctrl) {
+				have_ctrl = true;
+				is_data = (byte & EMUL_CTRL_DATA) != 0;
+			} else if (is_data) {
+				emul_data(target, data, byte);
+			} else {
+				emul_command(data, byte);
+			}
+		}
+	}
+	return 0;
+}
+
+const uint8_t *ssd1306_emul_gddram(const struct emul *target)
+{
+	const struct ssd1306_emul_data *data = target->data;
+
+	return data->gddram;
+}
+
+bool ssd1306_emul_display_on(const struct emul *target)
+{
+	const struct ssd1306_emul_data *data = target->data;
+
+	return data->on;
+}
+
+uint8_t ssd1306_emul_contrast(const struct emul *target)
+{
+	const struct ssd1306_emul_data *data = target->data;
+
+	return data->contrast;
+}
+
+uint32_t ssd1306_emul_frames(const struct emul *target)
+{
+	const struct ssd1306_emul_data *data = target->data;
+
+	return data->frames;
+}
+
+void ssd1306_emul_set_frame_cb(const struct emul *target, ssd1306_emul_frame_cb cb, void *user)
+{
+	struct ssd1306_emul_data *data = target->data;
+
+	data->frame_user = user;
+	data->frame_cb = cb;
+}
+
+void ssd1306_emul_print(const struct emul *target)
+{
+	static const char glyph[4] = { ' ', '\'', '.', ':' };
+	const struct ssd1306_emul_data *data = target->data;
+	char line[SSD1306_WIDTH + 3];
+
+	for (int y = 0; y < SSD1306_HEIGHT; y += 2) {
+		for (int x = 0; x < SSD1306_WIDTH; x++) {
+			uint8_t col = data->gddram[(y / 8) * SSD1306_WIDTH + x];
+			int top = (col >> (y % 8)) & 1;
+			int bottom = (col >> (y % 8 + 1)) & 1;
+
+			line[x + 1] = glyph[top | (bottom << 1)];
+		}
+		line[0] = '|';
+		line[SSD1306_WIDTH + 1] = '|';
+		line[SSD1306_WIDTH + 2] = '\0';
+		printk("%s\n", line);
+	}
+}
+
+static const struct i2c_emul_api ssd1306_emul_api = {
+	.transfer = ssd1306_emul_transfer,
+};
+
+static int ssd1306_emul_init(const struct emul *target, const struct device *parent)
+{
+	struct ssd1306_emul_data *data = target->data;
+
+	ARG_UNUSED(parent);
+
+	memset(data, 0, sizeof(*data));
+	data->contrast = 0x7F; /* reset value */
+	return 0;
+}
+
+#define SSD1306_EMUL(n)                                                         \
+	static struct ssd1306_emul_data ssd1306_emul_data_##n;                  \
+	EMUL_DT_INST_DEFINE(n, ssd1306_emul_init, &ssd1306_emul_data_##n,       \
+			    NULL, &ssd1306_emul_api, NULL)
+
+DT_INST_FOREACH_STATUS_OKAY(SSD1306_EMUL)
@@ -0,0 +1,42 @@
+/**
+ * @file ssd1306_emul.h
+ * @brief I2C emulator for the SSD1306 OLED controller (native_sim).
+ *
+ * Decodes the command/data stream the driver sends and keeps the panel's
+ * GDDRAM, so the picture the firmware drew can be inspected or printed.
+ */
+
+#ifndef __SSD1306_EMUL_H__
+#define __SSD1306_EMUL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/drivers/emul.h>
+
+#include "ssd1306.h"
+
+/* Called after the last byte of the last page has been written. */
+typedef void (*ssd1306_emul_frame_cb)(const struct emul *target, void *user);
+
+/**
+ * @brief Returns the emulated GDDRAM, SSD1306_BUFFER_SIZE bytes in the
+ *        driver's layout (page-major, bit 0 = top row of the page).
+ */
+const uint8_t *ssd1306_emul_gddram(const struct emul *target);
+
+bool ssd1306_emul_display_on(const struct emul *target);
+uint8_t ssd1306_emul_contrast(const struct emul *target);
+
+/**
+ * @brief Number of full frames written since boot.
+ */
+uint32_t ssd1306_emul_frames(const struct emul *target);
+
+void ssd1306_emul_set_frame_cb(const struct emul *target, ssd1306_emul_frame_cb cb, void *user);
+
+/**
+ * @brief Prints the panel as text, two pixel rows per line.
+ */
+void ssd1306_emul_print(const struct emul *target);
+
+#endif // __SSD1306_EMUL_H__
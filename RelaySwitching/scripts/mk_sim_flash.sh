@@ -0,0 +1,36 @@
+#!/bin/sh
+# Build a flash file for the native_sim target with a FAT "SD card" in it.
+#
+#   scripts/mk_sim_flash.sh sim_flash.bin ../Azan_lookupGenerator/prayer_2025_*.bin
+#   build/zephyr/zephyr.exe --flash=sim_flash.bin --no-rt
+#
+# The layout must match boards/native_sim.overlay: 2 MiB of erased flash with
+# the 1 MiB sd_partition at 0x100000. The other partitions start erased, like
+# a freshly programmed board. Needs mkfs.fat (dosfstools) and mcopy (mtools).
+set -e
+
+FLASH_SIZE_K=2048
+SD_OFFSET_K=1024
+SD_SIZE_K=1024
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 <flash.bin> [files for the card root...]" >&2
+    exit 1
+fi
+
+out=$1
+shift
+img=$(mktemp)
+trap 'rm -f "$img"' EXIT
+
+rm -f "$img"
+mkfs.fat -C -F 12 -S 512 -n PRAYSD "$img" $SD_SIZE_K >/dev/null
+for f in "$@"; do
+    mcopy -i "$img" "$f" ::
+done
+
+# Erased NOR reads 0xFF.
+dd if=/dev/zero bs=1024 count=$FLASH_SIZE_K 2>/dev/null | tr '\000' '\377' > "$out"
+dd if="$img" of="$out" bs=1024 seek=$SD_OFFSET_K conv=notrunc 2>/dev/null
+
+echo "$out: SD image with $# file(s) at $((SD_OFFSET_K * 1024))"
@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""Worst-case stack depth of each RelaySwitching thread, checked against its size.
+
+  stack_report.py --elf build/zephyr/zephyr.elf --su-dir build \\
+      --thread main:4096:main \\
+      --thread sysworkq:1024:month_dump_handler,cfg_save_work,evlog_flush_work,calc_work_handler
+
+Normally run by the stack_report build target (CONFIG_APP_STACK_USAGE, which
+also builds with -fstack-usage): west build -t stack_report.
+
+Frame sizes come from the .su files GCC writes next to each object; the call
+graph comes from the direct calls and tail calls in 'objdump -d' of the ELF,
+as puncover does. For each thread the deepest path from its entry functions
+is printed and compared with the stack size less --headroom percent; the
+script exits 1 if any thread is over.
+
+What static analysis can't see is reported, not guessed:
+  indirect  calls through a function pointer (device APIs, fs backends,
+            callbacks): the path is a lower bound from that function on;
+  no .su    functions built without -fstack-usage (prebuilt libc, asm);
+  recursion the cycle is cut after one pass.
+tests/stack_budget measures the dynamic high-water marks for those paths.
+"""
+import argparse
+import collections
+import os
+import re
+import subprocess
+import sys
+
+# "src/xmodem.c:160:22:xmodem_handle_packet\t1064\tstatic"
+SU_LINE = re.compile(r"^(?P<loc>.*):(?P<func>[^:\s]+)\s+(?P<bytes>\d+)\s+(?P<kind>[\w,]+)\s*$")
+# "00012a4c <xmodem_receive>:"
+FUNC_LABEL = re.compile(r"^[0-9a-f]+ <(?P<func>[^>]+)>:$")
+# Direct calls and tail calls to a symbol start (no "+0x.." offset):
+#   ARM    "bl 12a4c <f>", "blx ...", "b.w 12a4c <f>"
+#   x86    "call 80491b6 <f>", "jmp 80491b6 <f>"
+DIRECT_CALL = re.compile(
+    r"\s(?P<op>bl|blx|b|b\.w|b\.n|call|calll|callq|jmp|jmpl|jmpq)\s+[0-9a-f]+\s+<(?P<func>[^>+]+)>")
+# Calls through a register or memory: "blx r3", "call *%eax", "call *0x8(%ebx)"
+INDIRECT_CALL = re.compile(r"\s(?:blx\s+(?:r\d+|ip|lr)\b|call[lq]?\s+\*)")
+
+# GCC clones keep the name before the first dot: foo.constprop.0, foo.isra.0
+CLONE = re.compile(r"\.(constprop|isra|part|cold|lto_priv)(\.\d+)?$")
+
+
+def base_name(func):
+    while True:
+        m = CLONE.search(func)
+        if not m:
+            return func
+        func = func[:m.start()]
+
+
+def load_su(su_dir):
+    """{function: (bytes, dynamic?)}; same-name static functions keep the larger frame."""
+    frames = {}
+    for root, _, files in os.walk(su_dir):
+        for name in files:
+            if not name.endswith(".su"):
+                continue
+            with open(os.path.join(root, name), encoding="utf-8", errors="replace") as f:
+                for line in f:
+                    m = SU_LINE.match(line.strip())
+                    if not m:
+                        continue
+                    func = base_name(m["func"])
+                    size = int(m["bytes"])
+                    dynamic = "dynamic" in m["kind"]
+                    old = frames.get(func)
+                    if old is None or size > old[0]:
+                        frames[func] = (size, dynamic or (old is not None and old[1]))
+    return frames
+
+
+def load_calls(objdump, elf):
+    """{function: set(callees)} and the set of functions making indirect calls."""
+    out = subprocess.run([objdump, "-d", "--no-show-raw-insn", elf], check=True,
+                         capture_output=True, text=True).stdout
+    calls = collections.defaultdict(set)
+    indirect = set()
+    current = None
+    for line in out.splitlines():
+        m = FUNC_LABEL.match(line)
+        if m:
+            current = base_name(m["func"])
+            calls.setdefault(current, set())
+            continue
+        if current is None:
+            continue
+        m = DIRECT_CALL.search(line)
+        if m:
+            calls[current].add(base_name(m["func"]))
+        elif INDIRECT_CALL.search(line):
+            indirect.add(current)
+    return calls, indirect
+
+
+class Analysis:
+    def __init__(self, frames, calls, indirect):
+        self.frames = frames
+        self.calls = calls
+        self.indirect = indirect
+        self.memo = {}
+        self.recursive = set()
+
+    def frame(self, func):
+        return self.frames.get(func, (0, False))[0]
+
+    def worst(self, func, stack=()):
+        """(bytes, path) of the deepest call chain starting at func."""
+        if func in self.memo:
+            return self.memo[func]
+        if func in stack:
+            self.recursive.add(func)
+            return 0, []
+        best = (0, [])
+        for callee in self.calls.get(func, ()):
+            depth = self.worst(callee, stack + (func,))
+            if depth[0] > best[0]:
+                best = depth
+        result = (self.frame(func) + best[0], [func] + best[1])
+        # Results below a cycle depend on where it was entered; don't reuse them.
+        if not any(f in self.recursive for f in result[1]):
+            self.memo[func] = result
+        return result
+
+    def notes(self, func):
+        out = []
+        if func in self.indirect:
+            out.append("indirect")
+        if func not in self.frames:
+            out.append("no .su")
+        elif self.frames[func][1]:
+            out.append("dynamic")
+        if func in self.recursive:
+            out.append("recursion")
+        return ", ".join(out)
+
+
+def parse_thread(arg):
+    try:
+        name, size, roots = arg.split(":", 2)
+        return name, int(size), [r for r in roots.split(",") if r]
+    except ValueError:
+        raise argparse.ArgumentTypeError(f"{arg!r}: want NAME:SIZE:ROOT[,ROOT...]")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--elf", required=True)
+    ap.add_argument("--su-dir", required=True, help="build directory holding the .su files")
+    ap.add_argument("--objdump", default="objdump")
+    ap.add_argument("--thread", type=parse_thread, action="append", required=True,
+                    metavar="NAME:SIZE:ROOTS", help="thread, stack bytes, entry functions")
+    ap.add_argument("--headroom", type=int, default=25, help="percent of each stack kept free")
+    ap.add_argument("--top", type=int, default=15, help="largest frames to list")
+    args = ap.parse_args()
+
+    frames = load_su(args.su_dir)
+    if not frames:
+        raise SystemExit(f"{args.su_dir}: no .su files; build with CONFIG_APP_STACK_USAGE=y")
+    calls, indirect = load_calls(args.objdump, args.elf)
+    an = Analysis(frames, calls, indirect)
+
+    over = 0
+    for name, size, roots in args.thread:
+        budget = size * (100 - args.headroom) // 100
+        depth, path = max((an.worst(r) for r in roots if r in calls or r in frames),
+                          default=(0, []))
+        missing = [r for r in roots if r not in calls and r not in frames]
+        status = "OK" if depth <= budget else "OVER"
+        over += status == "OVER"
+        print(f"{name}: {depth} of {size} bytes (budget {budget}, {args.headroom}% headroom) {status}")
+        for func in path:
+            note = an.notes(func)
+            print(f"  {an.frame(func):6d}  {func}" + (f"  [{note}]" if note else ""))
+        if missing:
+            print(f"  not in the image: {', '.join(missing)}")
+        if any(f in indirect for f in path):
+            print("  lower bound: the path makes indirect calls")
+        if any(f in an.recursive for f in path):
+            print("  lower bound: recursion counted once")
+        print()
+
+    print("largest frames:")
+    for func, (size, dynamic) in sorted(frames.items(), key=lambda kv: -kv[1][0])[:args.top]:
+        print(f"  {size:6d}  {func}" + ("  [dynamic]" if dynamic else ""))
+    return 1 if over else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
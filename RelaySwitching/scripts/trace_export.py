@@ -0,0 +1,302 @@
+#!/usr/bin/env python3
+"""Turn RelaySwitching traces into files Trace Compass and Perfetto can open.
+
+  trace_export.py ring /dev/ttyACM0 -o trace/   board, overlay-tracing.conf
+  trace_export.py ring dump.log -o trace/        same, from a saved console log
+  trace_export.py ctf trace/ -o trace.json       native_sim, overlay-tracing-sim.conf
+
+'ring' sends 't' and reads the "TRACE BEGIN ... TRACE END" dump of
+src/app_trace.c, then writes trace/metadata + trace/channel0_0 (CTF, for
+Trace Compass or babeltrace2) and trace/trace.json (Chrome JSON, for
+ui.perfetto.dev). 'ctf' reads the CTF that Zephyr's own tracing wrote under
+native_sim (Trace Compass opens that directly) and writes the same JSON; it
+needs the babeltrace2 Python bindings (bt2).
+
+Point names come from APP_TRACE_POINTS in src/app_trace.h, so the two can't
+drift apart.
+"""
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+APP_TRACE_H = os.path.join(HERE, "..", "src", "app_trace.h")
+
+# Record types and kinds, as in app_trace.c / app_trace.h.
+REC_THREAD_IN, REC_THREAD_OUT, REC_ISR_ENTER, REC_ISR_EXIT, REC_APP = range(5)
+K_MARK, K_BEGIN, K_END = range(3)
+
+ISR_TID = 0
+PID_KERNEL = 1
+PID_APP = 2
+
+
+def load_point_names(path=APP_TRACE_H):
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    block = text[text.index("#define APP_TRACE_POINTS"):]
+    block = block[:block.index("#define APP_TRACE_ENUM")]
+    return re.findall(r'X\(\s*\w+\s*,\s*"(\w+)"\s*\)', block)
+
+
+# ---- ring dump ----
+
+def read_dump_lines(source, timeout):
+    """Yield lines of the dump from a serial port or a text file."""
+    if os.path.isfile(source):
+        with open(source, encoding="ascii", errors="replace") as f:
+            yield from f
+        return
+
+    import serial  # pyserial, only needed for a live board
+    with serial.Serial(source, 115200, timeout=0.5) as port:
+        port.reset_input_buffer()
+        port.write(b"t")
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            line = port.readline().decode("ascii", errors="replace")
+            if line:
+                yield line
+                if line.startswith("TRACE END"):
+                    return
+    raise SystemExit(f"{source}: no TRACE END within {timeout:.0f} s")
+
+
+def parse_dump(lines):
+    hz, recs, names, lost, inside = None, [], {}, 0, False
+    for line in lines:
+        line = line.strip()
+        if line.startswith("TRACE BEGIN"):
+            fields = dict(kv.split("=") for kv in line.split()[2:])
+            hz, lost = int(fields["hz"]), int(fields["lost"])
+            recs, names, inside = [], {}, True
+        elif not inside:
+            continue
+        elif line.startswith("R "):
+            ts, typ, point, kind, arg = line.split()[1:6]
+            recs.append((int(ts, 16), int(typ), int(point), int(kind), int(arg, 16)))
+        elif line.startswith("N "):
+            _, tid, name = line.split(maxsplit=2)
+            names[int(tid, 16)] = name
+        elif line.startswith("TRACE END"):
+            return hz, recs, names, lost
+    raise SystemExit("no complete TRACE BEGIN ... TRACE END block in the input")
+
+
+def unwrap(recs):
+    """k_cycle_get_32() wraps; rebuild a monotonic 64-bit count."""
+    out, high, prev = [], 0, None
+    for ts, *rest in recs:
+        if prev is not None and ts < prev:
+            high += 1 << 32
+        prev = ts
+        out.append((high + ts, *rest))
+    return out
+
+
+CTF_METADATA = """/* CTF 1.8 */
+typealias integer {{ size = 8; align = 8; signed = false; }} := uint8_t;
+typealias integer {{ size = 32; align = 8; signed = false; }} := uint32_t;
+typealias integer {{ size = 64; align = 8; signed = false; }} := uint64_t;
+
+trace {{
+    major = 1;
+    minor = 8;
+    byte_order = le;
+}};
+
+clock {{
+    name = cycles;
+    freq = {hz};
+}};
+typealias integer {{ size = 64; align = 8; signed = false; map = clock.cycles.value; }} := cycles_t;
+
+stream {{
+    event.header := struct {{
+        uint8_t id;
+        cycles_t timestamp;
+    }};
+}};
+
+event {{ id = 0; name = "thread_switched_in";  fields := struct {{ uint32_t thread_id; string thread_name; }}; }};
+event {{ id = 1; name = "thread_switched_out"; fields := struct {{ uint32_t thread_id; string thread_name; }}; }};
+event {{ id = 2; name = "isr_enter"; fields := struct {{ }}; }};
+event {{ id = 3; name = "isr_exit";  fields := struct {{ }}; }};
+event {{ id = 4; name = "app_event"; fields := struct {{ string name; uint8_t kind; uint32_t arg; }}; }};
+"""
+
+
+def write_ctf(outdir, hz, recs, names, points):
+    with open(os.path.join(outdir, "metadata"), "w", encoding="ascii") as f:
+        f.write(CTF_METADATA.format(hz=hz))
+    with open(os.path.join(outdir, "channel0_0"), "wb") as f:
+        for ts, typ, point, kind, arg in recs:
+            f.write(struct.pack("<BQ", typ, ts))
+            if typ in (REC_THREAD_IN, REC_THREAD_OUT):
+                f.write(struct.pack("<I", arg))
+                f.write(names.get(arg, f"{arg:08x}").encode("ascii") + b"\0")
+            elif typ == REC_APP:
+                f.write(point_name(points, point).encode("ascii") + b"\0")
+                f.write(struct.pack("<BI", kind, arg))
+
+
+def point_name(points, point):
+    return points[point] if point < len(points) else f"point{point}"
+
+
+# ---- Chrome JSON (Perfetto) ----
+
+class JsonTrace:
+    """Kernel slices (thread running, ISRs) in one process, app stages in
+    another, one track per thread in each. App stages go on the thread that
+    emitted them; they stay open across switches, so they can't share the
+    track of the 'running' slices."""
+
+    def __init__(self):
+        self.events = []
+        self.threads = {}
+        self.current = None
+
+    def thread(self, tid, name=None):
+        if tid not in self.threads or name:
+            self.threads[tid] = name or self.threads.get(tid) or f"{tid:08x}"
+
+    def add(self, ph, name, us, pid, tid, args=None):
+        ev = {"ph": ph, "name": name, "ts": us, "pid": pid, "tid": tid}
+        if ph == "i":
+            ev["s"] = "t"
+        if args:
+            ev["args"] = args
+        self.events.append(ev)
+
+    def switched_in(self, us, tid, name=None):
+        self.thread(tid, name)
+        self.current = tid
+        self.add("B", "running", us, PID_KERNEL, tid)
+
+    def switched_out(self, us, tid, name=None):
+        self.thread(tid, name)
+        self.add("E", "running", us, PID_KERNEL, tid)
+        self.current = None
+
+    def isr(self, us, enter):
+        self.add("B" if enter else "E", "isr", us, PID_KERNEL, ISR_TID)
+
+    def app(self, us, name, kind, arg):
+        tid = self.current if self.current is not None else ISR_TID
+        ph = {K_BEGIN: "B", K_END: "E"}.get(kind, "i")
+        self.add(ph, name, us, PID_APP, tid, {"arg": f"0x{arg:x}"})
+
+    def dump(self, path):
+        meta = [
+            {"ph": "M", "name": "process_name", "pid": PID_KERNEL, "args": {"name": "kernel"}},
+            {"ph": "M", "name": "process_name", "pid": PID_APP, "args": {"name": "app"}},
+        ]
+        for pid in (PID_KERNEL, PID_APP):
+            meta.append({"ph": "M", "name": "thread_name", "pid": pid, "tid": ISR_TID,
+                         "args": {"name": "isr"}})
+            for tid, name in self.threads.items():
+                meta.append({"ph": "M", "name": "thread_name", "pid": pid, "tid": tid,
+                             "args": {"name": name}})
+        with open(path, "w", encoding="utf-8") as f:
+            json.dump({"traceEvents": meta + self.events, "displayTimeUnit": "ms"}, f)
+
+
+def ring_to_json(hz, recs, names, points):
+    jt = JsonTrace()
+    for tid, name in names.items():
+        jt.thread(tid, name)
+    for ts, typ, point, kind, arg in recs:
+        us = ts * 1e6 / hz
+        if typ == REC_THREAD_IN:
+            jt.switched_in(us, arg)
+        elif typ == REC_THREAD_OUT:
+            jt.switched_out(us, arg)
+        elif typ in (REC_ISR_ENTER, REC_ISR_EXIT):
+            jt.isr(us, typ == REC_ISR_ENTER)
+        elif typ == REC_APP:
+            jt.app(us, point_name(points, point), kind, arg)
+    return jt
+
+
+def cmd_ring(args):
+    points = load_point_names()
+    hz, recs, names, lost = parse_dump(read_dump_lines(args.source, args.timeout))
+    recs = unwrap(recs)
+    if recs:
+        base = recs[0][0]
+        recs = [(ts - base, *rest) for ts, *rest in recs]
+
+    os.makedirs(args.output, exist_ok=True)
+    write_ctf(args.output, hz, recs, names, points)
+    ring_to_json(hz, recs, names, points).dump(os.path.join(args.output, "trace.json"))
+    print(f"{args.output}: {len(recs)} records at {hz} Hz"
+          + (f", {lost} older ones overwritten" if lost else ""))
+
+
+# ---- Zephyr CTF from native_sim ----
+
+def ctf_str(field):
+    """Zephyr's metadata stores names as fixed char arrays, NUL padded."""
+    if isinstance(field, str) or not hasattr(field, "__len__"):
+        return str(field)
+    return bytes(int(c) for c in field).split(b"\0")[0].decode("ascii", "replace")
+
+
+def cmd_ctf(args):
+    try:
+        import bt2
+    except ImportError:
+        raise SystemExit("needs the babeltrace2 Python bindings (python3-bt2)")
+
+    jt = JsonTrace()
+    n = 0
+    for msg in bt2.TraceCollectionMessageIterator(args.source):
+        if type(msg) is not bt2._EventMessageConst:
+            continue
+        ev = msg.event
+        us = msg.default_clock_snapshot.ns_from_origin / 1000.0
+        name = ev.name
+        if name in ("thread_switched_in", "thread_switched_out"):
+            tid = int(ev.payload_field["thread_id"])
+            tname = ctf_str(ev.payload_field["name"]) if "name" in ev.payload_field else None
+            (jt.switched_in if name.endswith("_in") else jt.switched_out)(us, tid, tname)
+        elif name in ("isr_enter", "isr_exit"):
+            jt.isr(us, name == "isr_enter")
+        elif name == "named_event":
+            # app_trace.c: arg0 = kind, arg1 = value
+            jt.app(us, ctf_str(ev.payload_field["name"]), int(ev.payload_field["arg0"]),
+                   int(ev.payload_field["arg1"]))
+        else:
+            continue
+        n += 1
+
+    jt.dump(args.output)
+    print(f"{args.output}: {n} events")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    r = sub.add_parser("ring", help="board RAM ring dump -> CTF + JSON")
+    r.add_argument("source", help="serial port, or a file holding the dump")
+    r.add_argument("-o", "--output", default="trace", help="output directory")
+    r.add_argument("--timeout", type=float, default=30.0, help="serial read timeout (s)")
+    r.set_defaults(func=cmd_ring)
+
+    c = sub.add_parser("ctf", help="native_sim CTF directory -> JSON")
+    c.add_argument("source", help="directory with metadata and channel0_0")
+    c.add_argument("-o", "--output", default="trace.json")
+    c.set_defaults(func=cmd_ctf)
+
+    args = ap.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
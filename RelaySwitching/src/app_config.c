@@ -0,0 +1,327 @@
+// app_config.c
+#include "app_config.h"
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern void print_uart(char *buf);
+
+struct app_config app_cfg = {
+    .relay_ms = 5000,
+    .splash_ms = 3000,
+    .mode = APP_MODE_SWITCH,
+    .contrast = 0xFF,
+    .library = APP_LIB_FLASH,
+    .month_dump = 0,
+    .calc = 0,
+    .lat_udeg = 30033000,  // the generator's reference file (Azan_lookupGenerator)
+    .lon_udeg = 40550000,
+    .utc_offset_min = 300,
+    .calc_method = 1,      // PRAY_METHOD_KARACHI
+    .asr_shadow = 1,
+};
+
+struct cfg_field {
+    const char *name;
+    uint16_t off;
+    uint8_t size;
+    bool sgn;  // signed field: sign-extended when read
+    int64_t min, max;
+};
+
+#define CFG_FIELD(f, lo, hi) \
+    { #f, offsetof(struct app_config, f), sizeof(((struct app_config *)0)->f), false, lo, hi }
+#define CFG_FIELD_SIGNED(f, lo, hi) \
+    { #f, offsetof(struct app_config, f), sizeof(((struct app_config *)0)->f), true, lo, hi }
+
+// Order is the bit position in cfg_dirty; append only.
+static const struct cfg_field cfg_fields[] = {
+    CFG_FIELD(relay_ms, 0, 10 * 60 * 1000),
+    CFG_FIELD(splash_ms, 0, 10000),
+    CFG_FIELD(mode, APP_MODE_SWITCH, APP_MODE_MANUAL),
+    CFG_FIELD(contrast, 0, 255),
+    CFG_FIELD(library, APP_LIB_FLASH, APP_LIB_SD),
+    CFG_FIELD(month_dump, 0, 1),
+    CFG_FIELD(calc, 0, 1),
+    CFG_FIELD_SIGNED(lat_udeg, -90000000, 90000000),
+    CFG_FIELD_SIGNED(lon_udeg, -180000000, 180000000),
+    CFG_FIELD_SIGNED(utc_offset_min, -12 * 60, 14 * 60),
+    CFG_FIELD(calc_method, 1, 6),  // PRAY_METHOD_KARACHI..NORTH_AMERICA; CUSTOM needs angles
+    CFG_FIELD(asr_shadow, 1, 2),
+};
+
+// cfg_dirty bit of the weekday rules, saved together as "app/weekly"
+#define CFG_DIRTY_WEEKLY BIT(31)
+BUILD_ASSERT(ARRAY_SIZE(cfg_fields) < 31, "cfg_dirty has no bit left for a field");
+
+static atomic_t cfg_dirty;
+
+static const char *const weekday_keys[7] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+static const char *const prayer_names[5] = {"Fajr", "Dhuhr", "Asr", "Maghrib", "Isha"};
+
+// Stored in the struct's own (native) byte order.
+static int64_t field_decode(const struct cfg_field *f, const void *p)
+{
+    switch (f->size) {
+    case 1: return f->sgn ? *(const int8_t *)p : *(const uint8_t *)p;
+    case 2: return f->sgn ? *(const int16_t *)p : *(const uint16_t *)p;
+    default: return f->sgn ? *(const int32_t *)p : *(const uint32_t *)p;
+    }
+}
+
+static int64_t field_get(const struct cfg_field *f)
+{
+    return field_decode(f, (const uint8_t *)&app_cfg + f->off);
+}
+
+static void field_put(const struct cfg_field *f, int64_t v)
+{
+    uint8_t *p = (uint8_t *)&app_cfg + f->off;
+    switch (f->size) {
+    case 1: *p = (uint8_t)v; break;
+    case 2: *(uint16_t *)p = (uint16_t)v; break;
+    default: *(uint32_t *)p = v; break;
+    }
+}
+
+static const struct cfg_field *field_find(const char *name)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(cfg_fields); ++i) {
+        const char *next;
+        if (settings_name_steq(name, cfg_fields[i].name, &next) && !next) {
+            return &cfg_fields[i];
+        }
+    }
+    return NULL;
+}
+
+// ---- weekday rules ----
+
+static int weekday_find(const char *name)
+{
+    for (int i = 0; i < 7; ++i) {
+        const char *next;
+        if (settings_name_steq(name, weekday_keys[i], &next) && !next) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool weekly_valid(const struct app_weekly_rule *r)
+{
+    const int lo = r->mode ? 0 : -1439;
+    return r->mask <= 0x1F && r->mode <= 1 && r->value >= lo && r->value <= 1439 &&
+           r->on_sec <= 36000;
+}
+
+// s[0..len) is name, in any case
+static bool word_eq(const char *s, size_t len, const char *name)
+{
+    if (strlen(name) != len) return false;
+    for (size_t i = 0; i < len; ++i) {
+        if (tolower((unsigned char)s[i]) != tolower((unsigned char)name[i])) return false;
+    }
+    return true;
+}
+
+// "<prayers> <change> [<relay seconds>]" as a line of the generator's rules
+// file without its dates, or "off"
+static int weekly_parse(const char *s, struct app_weekly_rule *r)
+{
+    char prayers[40], change[8], c;
+    int len = 0, hh, mm;
+    char *end;
+
+    *r = (struct app_weekly_rule){0};
+    if (!strcmp(s, "off")) return 0;
+    if (sscanf(s, "%39s %7s%n", prayers, change, &len) != 2) return -EINVAL;
+
+    if (!strcmp(prayers, "all")) {
+        r->mask = 0x1F;
+    } else {
+        for (char *p = prayers, *comma; p; p = comma ? comma + 1 : NULL) {
+            comma = strchr(p, ',');
+            size_t n = comma ? (size_t)(comma - p) : strlen(p);
+            int i = 0;
+            while (i < 5 && !word_eq(p, n, prayer_names[i])) i++;
+            if (i == 5) return -EINVAL;
+            r->mask |= BIT(i);
+        }
+    }
+
+    if (change[0] == '=') {
+        if (sscanf(change, "=%d:%d%c", &hh, &mm, &c) != 2 || hh < 0 || hh > 23 || mm < 0 || mm > 59) {
+            return -EINVAL;
+        }
+        r->mode = 1;
+        r->value = (int16_t)(hh * 60 + mm);
+    } else {
+        long v = strtol(change, &end, 10);
+        if (end == change || *end || v < -1439 || v > 1439) return -EINVAL;
+        r->value = (int16_t)v;
+    }
+
+    const char *rest = s + len;
+    while (*rest == ' ') rest++;
+    if (*rest) {
+        unsigned long v = strtoul(rest, &end, 10);
+        if (end == rest || *end || v > 36000) return -EINVAL;
+        r->on_sec = (uint16_t)v;
+    }
+    return weekly_valid(r) ? 0 : -EINVAL;
+}
+
+static void weekly_format(const struct app_weekly_rule *r, char *out, size_t size)
+{
+    size_t n = 0;
+
+    if (r->mask == 0) {
+        snprintf(out, size, "off");
+        return;
+    }
+    if (r->mask == 0x1F) {
+        n = snprintf(out, size, "all");
+    }
+    for (int i = 0; i < 5 && r->mask != 0x1F; ++i) {
+        if (r->mask & BIT(i)) {
+            n += snprintf(out + n, size - n, "%s%s", n ? "," : "", prayer_names[i]);
+        }
+    }
+    if (r->mode) {
+        n += snprintf(out + n, size - n, " =%02d:%02d", r->value / 60, r->value % 60);
+    } else {
+        n += snprintf(out + n, size - n, " %s%d", r->value > 0 ? "+" : "", r->value);
+    }
+    if (r->on_sec) {
+        snprintf(out + n, size - n, " %u", r->on_sec);
+    }
+}
+
+// ---- settings backend ----
+
+static int cfg_settings_set(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+    const char *next;
+    if (settings_name_steq(key, "weekly", &next) && !next) {
+        struct app_weekly_rule w[7];
+        if (len != sizeof(w)) return -EINVAL;
+        if (read_cb(cb_arg, w, len) != (ssize_t)len) return -EIO;
+        for (int i = 0; i < 7; ++i) {
+            if (!weekly_valid(&w[i])) return -EINVAL;
+        }
+        memcpy(app_cfg.weekly, w, sizeof(w));
+        return 0;
+    }
+
+    const struct cfg_field *f = field_find(key);
+    if (!f) return -ENOENT;
+    if (len != f->size) return -EINVAL;
+
+    union { uint8_t u8; uint16_t u16; uint32_t u32; } v = {0};
+    if (read_cb(cb_arg, &v, len) != (ssize_t)len) return -EIO;
+    int64_t val = field_decode(f, &v);
+
+    // Keep the default rather than load a value a newer build would reject.
+    if (val < f->min || val > f->max) return -EINVAL;
+    field_put(f, val);
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(app, "app", NULL, cfg_settings_set, NULL, NULL);
+
+static void cfg_save_work(struct k_work *work)
+{
+    ARG_UNUSED(work);
+    atomic_val_t dirty = atomic_clear(&cfg_dirty);
+
+    for (size_t i = 0; i < ARRAY_SIZE(cfg_fields); ++i) {
+        if (!(dirty & BIT(i))) continue;
+        const struct cfg_field *f = &cfg_fields[i];
+        char key[32];
+        snprintf(key, sizeof(key), "app/%s", f->name);
+        if (settings_save_one(key, (const uint8_t *)&app_cfg + f->off, f->size) != 0) {
+            atomic_or(&cfg_dirty, BIT(i));  // picked up again by the next change
+        }
+    }
+    if ((dirty & CFG_DIRTY_WEEKLY) &&
+        settings_save_one("app/weekly", app_cfg.weekly, sizeof(app_cfg.weekly)) != 0) {
+        atomic_or(&cfg_dirty, CFG_DIRTY_WEEKLY);
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(cfg_save, cfg_save_work);
+
+static int weekly_set(int wd, const char *value)
+{
+    struct app_weekly_rule r;
+    int rc = weekly_parse(value, &r);
+    if (rc) return rc;
+
+    if (memcmp(&app_cfg.weekly[wd], &r, sizeof(r)) != 0) {
+        app_cfg.weekly[wd] = r;
+        atomic_or(&cfg_dirty, CFG_DIRTY_WEEKLY);
+        (void)k_work_reschedule(&cfg_save, K_MSEC(APP_CFG_SAVE_DELAY_MS));
+    }
+    return 0;
+}
+
+int app_config_init(void)
+{
+    int rc = settings_subsys_init();
+    if (rc) return rc;
+    return settings_load_subtree("app");
+}
+
+int app_config_set(const char *key, const char *value)
+{
+    const int wd = weekday_find(key);
+    if (wd >= 0) return weekly_set(wd, value);
+
+    const struct cfg_field *f = field_find(key);
+    if (!f) return -ENOENT;
+
+    char *end;
+    long long v = strtoll(value, &end, 0);
+    if (end == value || *end != '\0' || v < f->min || v > f->max) return -EINVAL;
+
+    if (field_get(f) != v) {
+        field_put(f, v);
+        atomic_or(&cfg_dirty, BIT(f - cfg_fields));
+        (void)k_work_reschedule(&cfg_save, K_MSEC(APP_CFG_SAVE_DELAY_MS));
+    }
+    return 0;
+}
+
+int app_config_set_line(const char *line)
+{
+    char key[24];
+    const char *eq = strchr(line, '=');
+    if (!eq || eq == line || (size_t)(eq - line) >= sizeof(key)) return -EINVAL;
+
+    memcpy(key, line, (size_t)(eq - line));
+    key[eq - line] = '\0';
+    return app_config_set(key, eq + 1);
+}
+
+void app_config_print(void)
+{
+    char line[48];
+    for (size_t i = 0; i < ARRAY_SIZE(cfg_fields); ++i) {
+        // Every range fits a long; no %lld in the minimal printf
+        snprintf(line, sizeof(line), "%s=%ld\r\n", cfg_fields[i].name,
+                 (long)field_get(&cfg_fields[i]));
+        print_uart(line);
+    }
+    for (int i = 0; i < 7; ++i) {
+        char rule[40];
+        weekly_format(&app_cfg.weekly[i], rule, sizeof(rule));
+        snprintf(line, sizeof(line), "%s=%s\r\n", weekday_keys[i], rule);
+        print_uart(line);
+    }
+}
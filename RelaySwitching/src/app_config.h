@@ -0,0 +1,70 @@
+// app_config.h — runtime configuration stored under "app/" in Zephyr settings
+//
+// Loaded once at boot into app_cfg; read it directly from anywhere (plain
+// struct, no locking). Changes go through app_config_set(), which updates RAM
+// at once and writes the changed fields to flash after APP_CFG_SAVE_DELAY_MS of
+// quiet, so a burst of edits costs one settings write per field.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+enum app_mode {
+    APP_MODE_SWITCH = 0,  // follow the auto/manual switch
+    APP_MODE_AUTO,
+    APP_MODE_MANUAL,
+};
+
+enum app_library {
+    APP_LIB_FLASH = 0,    // LittleFS on internal flash, SD as import/export
+    APP_LIB_SD,           // read the library straight from the card
+};
+
+// One weekday's rule, as a PRAY3 WEEKLY entry (pray3_weekly_t): the prayers
+// in mask (bit0 Fajr .. bit4 Isha) move by value minutes, or to minute value
+// of the day with mode 1; on_sec, if not 0, replaces their relay time. mask 0
+// leaves the day to the file's rule.
+struct app_weekly_rule {
+    uint8_t  mask;
+    uint8_t  mode;
+    int16_t  value;
+    uint16_t on_sec;
+};
+
+struct app_config {
+    uint32_t relay_ms;    // relay pulse; 0 = per-prayer on_sec from the file. A weekday
+                          // rule's or date override's on_sec always applies.
+    uint16_t splash_ms;   // startup image time
+    uint8_t  mode;        // enum app_mode
+    uint8_t  contrast;    // SSD1306 contrast 0..255
+    uint8_t  library;     // enum app_library; applied at next boot
+    uint8_t  month_dump;  // print the month table after each load (background)
+    // Times computed on the device (CONFIG_APP_PRAY_CALC, calc_schedule.h)
+    uint8_t  calc;        // 1: every day from pray_calc, the file only gives durations; next boot
+    int32_t  lat_udeg;    // location, micro-degrees, north positive
+    int32_t  lon_udeg;    // east positive
+    int16_t  utc_offset_min;  // local time minus UTC, no DST
+    uint8_t  calc_method; // enum pray_calc_method, the generator's METHOD_CODE
+    uint8_t  asr_shadow;  // 1 Shafi'i (the generator's), 2 Hanafi
+    // Keys "sun".."sat", value "<prayers> <change> [<relay seconds>]" as a
+    // line of the generator's rules file ("fri=Dhuhr =13:30 300"), or "off";
+    // stored together as "app/weekly". Used from the next day change.
+    struct app_weekly_rule weekly[7];  // Sunday first
+};
+
+extern struct app_config app_cfg;
+
+#define APP_CFG_SAVE_DELAY_MS 2000
+
+// Init the settings subsystem and load "app/*" over the defaults.
+int app_config_init(void);
+
+// Set one field from text ("relay_ms", "5000"), or a weekday rule ("fri",
+// "Dhuhr =13:30 300"). Returns 0, -ENOENT for an unknown key or -EINVAL for a
+// value out of range.
+int app_config_set(const char *key, const char *value);
+
+// Parse and apply a "key=value" line.
+int app_config_set_line(const char *line);
+
+// Print every field as key=value over UART.
+void app_config_print(void);
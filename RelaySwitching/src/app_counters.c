@@ -0,0 +1,96 @@
+// app_counters.c
+#include "app_counters.h"
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/sys/sys_heap.h>
+#include <stdio.h>
+
+atomic_t app_counters[APP_CNT_COUNT];
+
+#define APP_COUNTER_NAME(id, name) name,
+static const char *const counter_names[] = { APP_COUNTERS(APP_COUNTER_NAME) };
+BUILD_ASSERT(ARRAY_SIZE(counter_names) == APP_CNT_COUNT);
+
+#if defined(CONFIG_SYS_HEAP_RUNTIME_STATS) && CONFIG_HEAP_MEM_POOL_SIZE > 0
+extern struct k_heap _system_heap;
+#endif
+
+struct stack_min {
+    size_t unused;
+    const struct k_thread *thread;
+};
+
+#if defined(CONFIG_THREAD_STACK_INFO) && defined(CONFIG_INIT_STACKS) && \
+    defined(CONFIG_THREAD_MONITOR)
+static void stack_min_cb(const struct k_thread *thread, void *user_data)
+{
+    struct stack_min *m = user_data;
+    size_t unused;
+
+    if (k_thread_stack_space_get(thread, &unused) == 0 && unused < m->unused) {
+        m->unused = unused;
+        m->thread = thread;
+    }
+}
+#endif
+
+void app_counters_print(void (*out)(char *line))
+{
+    char field[40];
+
+    out("#H,uptime_s");
+    for (size_t i = 0; i < ARRAY_SIZE(counter_names); ++i) {
+        snprintf(field, sizeof(field), ",%s", counter_names[i]);
+        out(field);
+    }
+    out(",stack_main_free,stack_min_free,stack_min_thread,heap_max_used\r\n");
+
+    snprintf(field, sizeof(field), "H,%u", (unsigned)(k_uptime_get() / 1000));
+    out(field);
+    for (size_t i = 0; i < ARRAY_SIZE(app_counters); ++i) {
+        snprintf(field, sizeof(field), ",%u", (unsigned)(uint32_t)atomic_get(&app_counters[i]));
+        out(field);
+    }
+
+    // Scans the painted stacks, so only here and not on the hot path. Empty
+    // columns when the kernel keeps no high-water data.
+    struct stack_min m = { SIZE_MAX, NULL };
+    size_t main_unused = SIZE_MAX;
+#if defined(CONFIG_THREAD_STACK_INFO) && defined(CONFIG_INIT_STACKS)
+    (void)k_thread_stack_space_get(k_current_get(), &main_unused);  // 'h' runs on main
+#endif
+#if defined(CONFIG_THREAD_STACK_INFO) && defined(CONFIG_INIT_STACKS) && \
+    defined(CONFIG_THREAD_MONITOR)
+    k_thread_foreach_unlocked(stack_min_cb, &m);
+#endif
+    if (main_unused != SIZE_MAX) {
+        snprintf(field, sizeof(field), ",%u", (unsigned)main_unused);
+    } else {
+        snprintf(field, sizeof(field), ",");
+    }
+    out(field);
+    if (m.thread) {
+        const char *name = k_thread_name_get((k_tid_t)m.thread);
+        snprintf(field, sizeof(field), ",%u,%s", (unsigned)m.unused,
+                 (name && name[0]) ? name : "?");
+    } else {
+        snprintf(field, sizeof(field), ",,");
+    }
+    out(field);
+
+    // Peak k_malloc() use since boot, against CONFIG_HEAP_MEM_POOL_SIZE
+    size_t heap_max = SIZE_MAX;
+#if defined(CONFIG_SYS_HEAP_RUNTIME_STATS) && CONFIG_HEAP_MEM_POOL_SIZE > 0
+    struct sys_memory_stats hs;
+    if (sys_heap_runtime_stats_get(&_system_heap.heap, &hs) == 0) {
+        heap_max = hs.max_allocated_bytes;
+    }
+#endif
+    if (heap_max != SIZE_MAX) {
+        snprintf(field, sizeof(field), ",%u\r\n", (unsigned)heap_max);
+    } else {
+        snprintf(field, sizeof(field), ",\r\n");
+    }
+    out(field);
+}
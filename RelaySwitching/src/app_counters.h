@@ -0,0 +1,86 @@
+// app_counters.h — runtime counters for monitoring units in the field
+//
+// One atomic_t per counter, bumped where the event happens and never reset;
+// the 'h' command prints them all as one CSV record (app_counters_print()),
+// so a script takes deltas between two snapshots. The SoC has a single CPU,
+// so one atomic per counter is already the per-CPU slot: an increment is an
+// LDREX/STREX pair with no lock and no IRQ masking.
+// Without CONFIG_APP_COUNTERS every macro is empty, including host builds of
+// pray2_reader.h.
+#pragma once
+#include <stdint.h>
+
+// Counters, in CSV column order. Append only: monitoring scripts read the
+// columns by name from the header line, but old scripts may still use index.
+#define APP_COUNTERS(X)                                                          \
+    X(LOOPS,          "loops")          /* main loop passes */                   \
+    X(TICK_MAX_US,    "tick_max_us")    /* longest pass after the UART wait */   \
+    X(RTC_READS,      "rtc_reads")                                               \
+    X(I2C_ERRORS,     "i2c_errors")     /* RTC and OLED transfers */             \
+    X(DISP_FLUSHES,   "disp_flushes")                                            \
+    X(DISP_BYTES,     "disp_bytes")     /* I2C payload, commands included */     \
+    X(FRAMES_SKIPPED, "frames_skipped") /* text unchanged, no flush */           \
+    X(XM_PACKETS,     "xm_packets")     /* ACKed blocks */                       \
+    X(XM_RETRIES,     "xm_retries")     /* NAKs, timeouts included */            \
+    X(XM_CRC_FAIL,    "xm_crc_fail")                                             \
+    X(SD_READS,       "sd_reads")       /* whole files and raw sector runs */    \
+    X(SD_READ_BYTES,  "sd_read_bytes")                                           \
+    X(SD_READ_US,     "sd_read_us")     /* total; mean = sd_read_us/sd_reads */  \
+    X(SD_READ_MAX_US, "sd_read_max_us")                                          \
+    X(RELAY_FAJR,     "relay_fajr")     /* relay fires, one per prayer */        \
+    X(RELAY_DHUHR,    "relay_dhuhr")                                             \
+    X(RELAY_ASR,      "relay_asr")                                               \
+    X(RELAY_MAGHRIB,  "relay_maghrib")                                           \
+    X(RELAY_ISHA,     "relay_isha")                                              \
+    X(MISSED_EVENTS,  "missed_events")  /* passed by a clock jump, not fired */  \
+    X(LATE_FIRES,     "late_fires")     /* fired after their own minute */       \
+    X(CALC_DAYS,      "calc_days")      /* days computed by pray_calc */         \
+    X(CALC_MAX_US,    "calc_max_us")    /* slowest of them */                    \
+    X(SPAN_FALLBACK,  "span_fallback")  /* days computed after a file's span */
+
+#define APP_COUNTER_ENUM(id, name) APP_CNT_##id,
+enum app_counter {
+    APP_COUNTERS(APP_COUNTER_ENUM)
+    APP_CNT_COUNT
+};
+#undef APP_COUNTER_ENUM
+
+#if defined(CONFIG_APP_COUNTERS)
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+extern atomic_t app_counters[APP_CNT_COUNT];
+
+static inline void app_counters_max(enum app_counter c, uint32_t v)
+{
+    atomic_val_t old;
+    do {
+        old = atomic_get(&app_counters[c]);
+        if ((uint32_t)old >= v) return;
+    } while (!atomic_cas(&app_counters[c], old, (atomic_val_t)v));
+}
+
+#define APP_CNT_INC(c)       ((void)atomic_inc(&app_counters[APP_CNT_##c]))
+#define APP_CNT_INC_AT(c, i) ((void)atomic_inc(&app_counters[APP_CNT_##c + (i)]))
+#define APP_CNT_ADD(c, n)    ((void)atomic_add(&app_counters[APP_CNT_##c], (atomic_val_t)(n)))
+#define APP_CNT_MAX(c, v)    app_counters_max(APP_CNT_##c, (uint32_t)(v))
+
+// Elapsed time for the *_US counters: t = APP_CNT_STAMP(); ...; APP_CNT_US_SINCE(t)
+#define APP_CNT_STAMP()      k_cycle_get_32()
+#define APP_CNT_US_SINCE(t)  k_cyc_to_us_floor32(k_cycle_get_32() - (t))
+
+#else
+
+#define APP_CNT_INC(c)       ((void)0)
+#define APP_CNT_INC_AT(c, i) ((void)(i))
+#define APP_CNT_ADD(c, n)    ((void)(n))
+#define APP_CNT_MAX(c, v)    ((void)(v))
+#define APP_CNT_STAMP()      0u
+#define APP_CNT_US_SINCE(t)  ((void)(t), 0u)
+
+#endif
+
+// Print "#H,<names>" then "H,<values>": uptime, every counter, the stack
+// high-water marks (free bytes left in main's stack and in the tightest thread)
+// and the peak system heap use (CONFIG_SYS_HEAP_RUNTIME_STATS).
+void app_counters_print(void (*out)(char *line));
@@ -0,0 +1,129 @@
+// app_trace.c
+#include "app_trace.h"
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/tracing/tracing.h>
+#include <stdio.h>
+
+#if defined(CONFIG_TRACING_CTF)
+
+#define APP_TRACE_NAME(id, name) name,
+static const char *const point_names[] = { APP_TRACE_POINTS(APP_TRACE_NAME) };
+
+void app_trace_emit(uint8_t kind, uint8_t point, uint32_t arg)
+{
+    sys_trace_named_event(point_names[point], kind, arg);
+}
+
+void app_trace_dump(void (*out)(char *line))
+{
+    out("trace: CTF stream is written by the tracing backend\r\n");
+}
+
+#else  // CONFIG_TRACING_USER
+
+// Record types; scripts/trace_export.py has the same list.
+enum {
+    REC_THREAD_IN = 0,
+    REC_THREAD_OUT,
+    REC_ISR_ENTER,
+    REC_ISR_EXIT,
+    REC_APP,
+};
+
+struct trace_rec {
+    uint32_t ts;     // k_cycle_get_32()
+    uint8_t  type;
+    uint8_t  point;  // REC_APP: enum app_trace_point
+    uint8_t  kind;   // REC_APP: enum app_trace_kind
+    uint8_t  pad;
+    uint32_t arg;    // REC_APP: value; thread records: thread id
+};
+BUILD_ASSERT(sizeof(struct trace_rec) == 12);
+
+// Fixed-size records so the oldest one is dropped whole when the ring wraps.
+static struct trace_rec ring[CONFIG_APP_TRACE_RING_SIZE / sizeof(struct trace_rec)];
+static uint32_t ring_head;  // records ever written; next slot is head % size
+static atomic_t paused;
+
+static void put(uint8_t type, uint8_t point, uint8_t kind, uint32_t arg)
+{
+    if (atomic_get(&paused)) return;
+
+    // Called from the scheduler and from ISRs; a lock keeps slots and
+    // timestamps in the same order.
+    unsigned int key = irq_lock();
+    struct trace_rec *r = &ring[ring_head++ % ARRAY_SIZE(ring)];
+    r->ts = k_cycle_get_32();
+    r->type = type;
+    r->point = point;
+    r->kind = kind;
+    r->arg = arg;
+    irq_unlock(key);
+}
+
+void app_trace_emit(uint8_t kind, uint8_t point, uint32_t arg)
+{
+    put(REC_APP, point, kind, arg);
+}
+
+// TRACING_USER hooks, called by the kernel's tracing layer.
+void sys_trace_thread_switched_in_user(void)
+{
+    put(REC_THREAD_IN, 0, 0, (uint32_t)(uintptr_t)k_current_get());
+}
+
+void sys_trace_thread_switched_out_user(void)
+{
+    put(REC_THREAD_OUT, 0, 0, (uint32_t)(uintptr_t)k_current_get());
+}
+
+void sys_trace_isr_enter_user(void)
+{
+    put(REC_ISR_ENTER, 0, 0, 0);
+}
+
+void sys_trace_isr_exit_user(void)
+{
+    put(REC_ISR_EXIT, 0, 0, 0);
+}
+
+#if defined(CONFIG_THREAD_MONITOR) && defined(CONFIG_THREAD_NAME)
+static void dump_thread_name(const struct k_thread *thread, void *user_data)
+{
+    void (*out)(char *line) = user_data;
+    char line[48];
+    const char *name = k_thread_name_get((k_tid_t)thread);
+
+    snprintf(line, sizeof(line), "N %08x %s\r\n", (unsigned)(uintptr_t)thread,
+             (name && name[0]) ? name : "?");
+    out(line);
+}
+#endif
+
+void app_trace_dump(void (*out)(char *line))
+{
+    char line[48];
+
+    atomic_set(&paused, 1);
+    uint32_t head = ring_head;
+    uint32_t n = MIN(head, (uint32_t)ARRAY_SIZE(ring));
+
+    snprintf(line, sizeof(line), "TRACE BEGIN hz=%u recs=%u lost=%u\r\n",
+             (unsigned)sys_clock_hw_cycles_per_sec(), (unsigned)n, (unsigned)(head - n));
+    out(line);
+    for (uint32_t i = head - n; i != head; ++i) {
+        const struct trace_rec *r = &ring[i % ARRAY_SIZE(ring)];
+        snprintf(line, sizeof(line), "R %08x %u %u %u %08x\r\n", (unsigned)r->ts,
+                 r->type, r->point, r->kind, (unsigned)r->arg);
+        out(line);
+    }
+#if defined(CONFIG_THREAD_MONITOR) && defined(CONFIG_THREAD_NAME)
+    k_thread_foreach_unlocked(dump_thread_name, out);
+#endif
+    out("TRACE END\r\n");
+    atomic_set(&paused, 0);
+}
+
+#endif
@@ -0,0 +1,68 @@
+// app_trace.h — application trace points on the tracing timeline
+//
+// APP_TRACE_BEGIN/END bracket a stage, APP_TRACE_MARK records an instant (a
+// relay edge, a fire). With CONFIG_APP_TRACE they land next to the kernel's
+// thread switches and ISRs:
+//  - TRACING_CTF (overlay-tracing-sim.conf, native_sim): Zephyr named events in
+//    the CTF file, arg0 = enum app_trace_kind, arg1 = the value.
+//  - TRACING_USER (overlay-tracing.conf, target): a RAM ring that keeps the
+//    newest CONFIG_APP_TRACE_RING_SIZE bytes, sent over UART by app_trace_dump()
+//    ('t' command) and turned into CTF by scripts/trace_export.py.
+// Otherwise every macro is empty, including host builds of pray2_reader.h.
+#pragma once
+#include <stdint.h>
+
+enum app_trace_kind {
+    APP_TRACE_K_MARK = 0,
+    APP_TRACE_K_BEGIN,
+    APP_TRACE_K_END,
+};
+
+// Trace points. Append only: the ids are in every ring dump, and
+// scripts/trace_export.py reads the names from this list.
+#define APP_TRACE_POINTS(X)                                                   \
+    X(TICK,         "tick")          /* main loop pass; end: 1 if fired */    \
+    X(RELAY,        "relay")         /* begin: prayer, end: 1 if cut, mark */ \
+    X(FILE_LOAD,    "file_load")     /* handle_new_pray2_file; end: ok */     \
+    X(LIB_LOAD,     "lib_load")      /* library lookup + read; end: rc */     \
+    X(PRAY2_PARSE,  "pray2_parse")   /* begin: len, end: pray2_status_t */    \
+    X(PRAY2_DAY,    "pray2_day")     /* scheduler day index change */         \
+    X(PRAY2_FIRE,   "pray2_fire")    /* prayer << 16 | table minute */        \
+    X(XMODEM_RX,    "xmodem_rx")     /* end: bytes received */                \
+    X(XMODEM_BLOCK, "xmodem_block")  /* packet number */                      \
+    X(SD_LOOKUP,    "sd_lookup")     /* end: rc */                            \
+    X(SD_READ_FILE, "sd_read_file")  /* begin: max len, end: rc */            \
+    X(SD_STORE,     "sd_store")      /* begin: len, end: rc */                \
+    X(SD_SECTORS,   "sd_sectors")    /* begin: lba << 8 | count, end: rc */   \
+    X(OLED_UPDATE,  "oled_update")   /* full frame */                         \
+    X(OLED_I2C,     "oled_i2c")      /* begin: ctl << 16 | len, end: rc */    \
+    X(RTC_I2C,      "rtc_i2c")       /* begin: reg << 16 | len, end: rc */    \
+    X(PRAY_CALC,    "pray_calc")     /* begin: days since 1970, end: ok */    \
+    X(PRAY2_OVR,    "pray2_ovr")     /* weekday rule + overrides: n */
+
+#define APP_TRACE_ENUM(id, name) APP_TP_##id,
+enum app_trace_point {
+    APP_TRACE_POINTS(APP_TRACE_ENUM)
+    APP_TP_COUNT
+};
+#undef APP_TRACE_ENUM
+
+#if defined(CONFIG_APP_TRACE)
+
+void app_trace_emit(uint8_t kind, uint8_t point, uint32_t arg);
+
+#define APP_TRACE_BEGIN(p, arg) app_trace_emit(APP_TRACE_K_BEGIN, APP_TP_##p, (uint32_t)(arg))
+#define APP_TRACE_END(p, arg)   app_trace_emit(APP_TRACE_K_END, APP_TP_##p, (uint32_t)(arg))
+#define APP_TRACE_MARK(p, arg)  app_trace_emit(APP_TRACE_K_MARK, APP_TP_##p, (uint32_t)(arg))
+
+#else
+
+#define APP_TRACE_BEGIN(p, arg) ((void)(arg))
+#define APP_TRACE_END(p, arg)   ((void)(arg))
+#define APP_TRACE_MARK(p, arg)  ((void)(arg))
+
+#endif
+
+// Send the ring over UART as "TRACE BEGIN ... TRACE END" hex lines; recording
+// pauses while it runs. With the CTF format it only says where the trace is.
+void app_trace_dump(void (*out)(char *line));
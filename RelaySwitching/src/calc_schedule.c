@@ -0,0 +1,199 @@
+// calc_schedule.c
+#include "calc_schedule.h"
+#include "app_config.h"
+#include "app_counters.h"
+#include "app_trace.h"
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <string.h>
+
+#define WINDOW CONFIG_APP_PRAY_CALC_WINDOW
+#define DST_MAX 24  // a PRAY3 file's DST transitions beyond these are ignored
+
+// Computed rows, slot = date % WINDOW. day is the date a slot holds (days since
+// 1970), INT32_MIN while it is being written, and gen the parameters it was
+// computed with; the scheduler copies the row and checks day again, so a copy
+// that raced a rewrite is not used.
+static struct {
+    atomic_t day;
+    atomic_t gen;
+    uint16_t min[5];
+} window[WINDOW];
+
+// Written by calc_schedule_day_fn() on the main thread only. gen moves on with
+// every change, which retires the whole window at once.
+static struct pray_calc_params params;
+static atomic_t gen;
+static bool active;                   // a day_fn is installed
+static bool fallback;                 // params are a file's location section
+static int32_t span_first, span_end;  // the file's table, [first, end)
+static pray3_dst_t dst[DST_MAX];      // the file's DST section, by date
+static int n_dst;
+
+static int next_y, next_m, next_d;  // first day to fill, set before the work is submitted
+
+void calc_schedule_params(struct pray_calc_params *p)
+{
+    *p = (struct pray_calc_params){
+        .lat = (float)app_cfg.lat_udeg * 1e-6f,
+        .lon = (float)app_cfg.lon_udeg * 1e-6f,
+        .utc_offset_min = app_cfg.utc_offset_min,
+        .method = app_cfg.calc_method,
+        .asr_shadow = app_cfg.asr_shadow,
+    };
+}
+
+// H's location section, with its METHOD section for PRAY_METHOD_CUSTOM; false
+// if it has not got them.
+static bool location_params(const pray2_header_t *H, struct pray_calc_params *p)
+{
+    pray2_location_t loc;
+    pray3_method_t m;
+
+    if (H->method_code >= PRAY_METHOD_COUNT || !pray2_get_location(H, &loc)) {
+        return false;
+    }
+    *p = (struct pray_calc_params){
+        .lat = (float)loc.lat_udeg * 1e-6f,
+        .lon = (float)loc.lon_udeg * 1e-6f,
+        .utc_offset_min = loc.utc_offset_min,
+        .method = H->method_code,
+        .asr_shadow = loc.asr_shadow,
+    };
+    memcpy(p->offset_min, loc.offset_min, sizeof(p->offset_min));
+    if (H->method_code == PRAY_METHOD_CUSTOM) {
+        if (!pray3_get_method(H, &m)) {
+            return false;
+        }
+        p->fajr_angle = (float)m.fajr_cdeg * 0.01f;
+        p->isha_angle = (float)m.isha_cdeg * 0.01f;
+        p->isha_interval_min = m.isha_interval_min;
+    }
+    return true;
+}
+
+// The UTC offset on date: the last DST transition on or before it, else the
+// location section's.
+static int16_t utc_offset_on(const struct pray_calc_params *p, int32_t date)
+{
+    int16_t off = p->utc_offset_min;
+
+    for (int i = 0; i < n_dst && dst[i].day <= date; i++) {
+        off = dst[i].utc_offset_min;
+    }
+    return off;
+}
+
+static bool calc_day(const struct pray_calc_params *params, int year, int month, int day, uint16_t out[5])
+{
+    const int32_t date = (int32_t)pray2_days_from_civil(year, (unsigned)month, (unsigned)day);
+    struct pray_calc_params p = *params;
+
+    p.utc_offset_min = utc_offset_on(params, date);
+    APP_TRACE_BEGIN(PRAY_CALC, date);
+    uint32_t t = APP_CNT_STAMP();
+    bool ok = pray_calc_day(&p, year, month, day, out);
+    APP_CNT_MAX(CALC_MAX_US, APP_CNT_US_SINCE(t));
+    APP_CNT_INC(CALC_DAYS);
+    APP_TRACE_END(PRAY_CALC, ok);
+    return ok;
+}
+
+static bool window_get(int32_t date, uint16_t out[5])
+{
+    const size_t i = (uint32_t)date % WINDOW;
+
+    if (atomic_get(&window[i].day) != date || atomic_get(&window[i].gen) != atomic_get(&gen)) {
+        return false;
+    }
+    memcpy(out, window[i].min, sizeof(window[i].min));
+    return atomic_get(&window[i].day) == date;
+}
+
+static bool calc_schedule_day(int year, int month, int day, uint16_t out_minutes[5])
+{
+    const int32_t date = (int32_t)pray2_days_from_civil(year, (unsigned)month, (unsigned)day);
+
+    // Not in the window: the first day, or Isha was skipped
+    bool ok = window_get(date, out_minutes) || calc_day(&params, year, month, day, out_minutes);
+
+    if (ok && fallback) {
+        APP_CNT_INC(SPAN_FALLBACK);
+        print_uart("Warning: date outside the file's span, times computed from its location\r\n");
+    }
+    return ok;
+}
+
+pray2_day_fn calc_schedule_day_fn(const pray2_header_t *H)
+{
+    struct pray_calc_params p;
+
+    if (calc_schedule_enabled()) {
+        calc_schedule_params(&p);
+        fallback = false;
+        n_dst = 0;
+    } else if (location_params(H, &p)) {
+        fallback = true;
+        n_dst = pray3_get_dst(H, dst, DST_MAX);
+    } else {
+        active = false;
+        return NULL;
+    }
+    span_first = (int32_t)pray2_days_from_civil(H->year, H->start_month, H->start_day);
+    span_end = span_first + H->days;
+    params = p;
+    atomic_inc(&gen);
+    active = true;
+    return calc_schedule_day;
+}
+
+void calc_schedule_header(pray2_header_t *H)
+{
+    static const uint16_t default_on_sec[5] = {60, 45, 45, 45, 45};  // get_default_durations()
+
+    memset(H, 0, sizeof(*H));
+    memcpy(H->default_on_sec, default_on_sec, sizeof(default_on_sec));
+}
+
+static void calc_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+    // A params copy torn by a concurrent change is harmless: gen has moved on
+    // too, so the rows are never read.
+    const atomic_val_t g = atomic_get(&gen);
+    const struct pray_calc_params p = params;
+    int y = next_y, m = next_m, d = next_d;
+    int32_t date = (int32_t)pray2_days_from_civil(y, (unsigned)m, (unsigned)d);
+
+    for (int n = 0; n < WINDOW; n++, date++, advance_one_day(&y, &m, &d)) {
+        const size_t i = (uint32_t)date % WINDOW;
+        uint16_t row[5];
+
+        if ((date >= span_first && date < span_end) ||
+            (atomic_get(&window[i].day) == date && atomic_get(&window[i].gen) == g) ||
+            !calc_day(&p, y, m, d, row)) {
+            continue;  // in the table, already cached, or no times that day
+        }
+        atomic_set(&window[i].day, INT32_MIN);
+        memcpy(window[i].min, row, sizeof(row));
+        atomic_set(&window[i].gen, g);
+        atomic_set(&window[i].day, date);
+    }
+}
+
+static K_WORK_DEFINE(calc_work, calc_work_handler);
+
+void calc_schedule_prefetch(const char *rtc)
+{
+    int hh, mm, ss, DD, MO, YYYY;
+
+    if (!active || k_work_busy_get(&calc_work) != 0 ||
+        !pray2_parse_rtc_ascii(rtc, &hh, &mm, &ss, &DD, &MO, &YYYY)) {
+        return;
+    }
+    advance_one_day(&YYYY, &MO, &DD);
+    next_y = YYYY;
+    next_m = MO;
+    next_d = DD;
+    k_work_submit(&calc_work);
+}
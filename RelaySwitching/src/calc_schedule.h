@@ -0,0 +1,49 @@
+// calc_schedule.h — scheduler days computed on the device (CONFIG_APP_PRAY_CALC)
+//
+// With app_cfg.calc set, pray2_sched takes every day from pray_calc for the
+// location and method in app_cfg instead of a file's table; a loaded file only
+// gives the relay durations (and its one-shot RTC time). Without it, a file
+// with a location section falls back to pray_calc for the days after its span
+// (and before it), with the file's location, method and offsets, and for a
+// PRAY3 file its METHOD angles and DST transitions.
+//
+// Today's row is computed when the scheduler starts. After Isha
+// (calc_schedule_prefetch()) the system work queue fills a window of
+// CONFIG_APP_PRAY_CALC_WINDOW days from tomorrow on, so the day change at
+// midnight only copies five numbers; a day missing from the window is
+// computed in place.
+#pragma once
+#include <stdbool.h>
+#include "app_config.h"
+#include "pray2_reader.h"
+#include "pray_calc.h"
+
+#if defined(CONFIG_APP_PRAY_CALC)
+
+static inline bool calc_schedule_enabled(void)
+{
+    return app_cfg.calc != 0;
+}
+
+// app_cfg's location and method as pray_calc parameters
+void calc_schedule_params(struct pray_calc_params *p);
+
+// pray2_day_fn for pray2_sched_init_ex() on header H: app_cfg's parameters in
+// calc mode, else H's location section; NULL if neither applies. Empties the
+// window when the parameters change.
+pray2_day_fn calc_schedule_day_fn(const pray2_header_t *H);
+
+// Header for running with no file: no table, the generator's default durations
+void calc_schedule_header(pray2_header_t *H);
+
+// Isha has fired at rtc ("HH:MM:SS|DD/MM/YY"): fill the window in the background
+void calc_schedule_prefetch(const char *rtc);
+
+#else
+
+static inline bool calc_schedule_enabled(void) { return false; }
+static inline pray2_day_fn calc_schedule_day_fn(const pray2_header_t *H) { (void)H; return NULL; }
+static inline void calc_schedule_header(pray2_header_t *H) { memset(H, 0, sizeof(*H)); }
+static inline void calc_schedule_prefetch(const char *rtc) { (void)rtc; }
+
+#endif
@@ -0,0 +1,243 @@
+// event_log.c
+#include "event_log.h"
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fcb.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+#include <stdio.h>
+
+extern void print_uart(char *buf);
+
+#define EVLOG_FCB_MAGIC   0x474C5645u  // "EVLG"
+#define EVLOG_FCB_VERSION 1
+#define EVLOG_MAX_SECTORS 8
+
+K_MSGQ_DEFINE(evlog_q, sizeof(struct event_log_rec), EVLOG_QUEUE_LEN, 4);
+K_MUTEX_DEFINE(evlog_lock);
+
+static struct fcb evlog_fcb;
+static struct flash_sector evlog_sectors[EVLOG_MAX_SECTORS];
+static bool evlog_ready;
+static atomic_t evlog_dropped;
+
+// Wall-clock reference: epoch at the last set_time() and the uptime then.
+static uint32_t evlog_epoch_base;
+static int64_t evlog_uptime_base;
+
+static void evlog_flush_work(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(evlog_work, evlog_flush_work);
+
+static int evlog_fcb_open(void)
+{
+    uint32_t cnt = ARRAY_SIZE(evlog_sectors);
+    int rc = flash_area_get_sectors(FIXED_PARTITION_ID(eventlog_partition), &cnt, evlog_sectors);
+    if (rc) return rc;
+
+    memset(&evlog_fcb, 0, sizeof(evlog_fcb));
+    evlog_fcb.f_magic = EVLOG_FCB_MAGIC;
+    evlog_fcb.f_version = EVLOG_FCB_VERSION;
+    evlog_fcb.f_sectors = evlog_sectors;
+    evlog_fcb.f_sector_cnt = (uint8_t)cnt;
+    evlog_fcb.f_scratch_cnt = 0;  // pure ring: the oldest sector is dropped when full
+    return fcb_init(FIXED_PARTITION_ID(eventlog_partition), &evlog_fcb);
+}
+
+int event_log_init(void)
+{
+    k_mutex_lock(&evlog_lock, K_FOREVER);
+    int rc = evlog_fcb_open();
+    if (rc) {
+        // Foreign data or a different record version: start a fresh ring.
+        const struct flash_area *fa;
+        if (flash_area_open(FIXED_PARTITION_ID(eventlog_partition), &fa) == 0) {
+            (void)flash_area_erase(fa, 0, fa->fa_size);
+            flash_area_close(fa);
+            rc = evlog_fcb_open();
+        }
+    }
+    evlog_ready = (rc == 0);
+    k_mutex_unlock(&evlog_lock);
+    return rc;
+}
+
+void event_log_set_time(uint32_t epoch)
+{
+    unsigned int key = irq_lock();
+    evlog_epoch_base = epoch;
+    evlog_uptime_base = k_uptime_get();
+    irq_unlock(key);
+}
+
+static uint32_t evlog_now(void)
+{
+    unsigned int key = irq_lock();
+    uint32_t base = evlog_epoch_base;
+    int64_t up = evlog_uptime_base;
+    irq_unlock(key);
+    return base + (uint32_t)((k_uptime_get() - up) / 1000);
+}
+
+void event_log_post(enum event_log_type type, uint8_t arg0, uint16_t arg1)
+{
+    struct event_log_rec rec = {
+        .epoch = evlog_now(),
+        .type = (uint8_t)type,
+        .arg0 = arg0,
+        .arg1 = arg1,
+    };
+    if (k_msgq_put(&evlog_q, &rec, K_NO_WAIT) != 0) {
+        atomic_inc(&evlog_dropped);
+        return;
+    }
+    // A full batch goes out right away; otherwise wait for more to pile up.
+    // k_work_schedule() leaves an already pending deadline alone.
+    if (k_msgq_num_used_get(&evlog_q) >= EVLOG_BATCH) {
+        (void)k_work_reschedule(&evlog_work, K_NO_WAIT);
+    } else {
+        (void)k_work_schedule(&evlog_work, K_MSEC(EVLOG_FLUSH_DELAY_MS));
+    }
+}
+
+// Write one batch as a single FCB entry. Caller holds evlog_lock.
+static int evlog_append(const struct event_log_rec *batch, int n)
+{
+    struct fcb_entry loc;
+    uint16_t len = (uint16_t)(n * sizeof(*batch));
+
+    int rc = fcb_append(&evlog_fcb, len, &loc);
+    if (rc == -ENOSPC) {
+        // Ring full: drop the oldest sector and retry once.
+        rc = fcb_rotate(&evlog_fcb);
+        if (rc == 0) rc = fcb_append(&evlog_fcb, len, &loc);
+    }
+    if (rc) return rc;
+
+    rc = flash_area_write(evlog_fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), batch, len);
+    if (rc) return rc;
+    return fcb_append_finish(&evlog_fcb, &loc);
+}
+
+static void evlog_drain(void)
+{
+    struct event_log_rec batch[EVLOG_BATCH];
+
+    k_mutex_lock(&evlog_lock, K_FOREVER);
+    for (;;) {
+        int n = 0;
+        while (n < EVLOG_BATCH && k_msgq_get(&evlog_q, &batch[n], K_NO_WAIT) == 0) {
+            n++;
+        }
+        if (n == 0) break;
+        if (!evlog_ready || evlog_append(batch, n) != 0) {
+            atomic_add(&evlog_dropped, n);
+        }
+    }
+    k_mutex_unlock(&evlog_lock);
+}
+
+static void evlog_flush_work(struct k_work *work)
+{
+    ARG_UNUSED(work);
+    evlog_drain();
+}
+
+void event_log_flush(void)
+{
+    (void)k_work_cancel_delayable(&evlog_work);
+    evlog_drain();
+}
+
+struct evlog_walk_ctx {
+    event_log_cb cb;
+    void *user;
+};
+
+static int evlog_walk_entry(struct fcb_entry_ctx *loc_ctx, void *arg)
+{
+    struct evlog_walk_ctx *ctx = arg;
+    struct event_log_rec batch[EVLOG_BATCH];
+    uint16_t len = loc_ctx->loc.fe_data_len;
+
+    // Anything that is not a whole number of records is not ours; skip it.
+    if (len == 0 || len > sizeof(batch) || (len % sizeof(batch[0])) != 0) return 0;
+    if (flash_area_read(loc_ctx->fap, FCB_ENTRY_FA_DATA_OFF(loc_ctx->loc), batch, len) != 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < len / sizeof(batch[0]); ++i) {
+        ctx->cb(&batch[i], ctx->user);
+    }
+    return 0;
+}
+
+int event_log_walk(event_log_cb cb, void *user)
+{
+    if (!cb) return -EINVAL;
+    if (!evlog_ready) return -ENODEV;
+
+    struct evlog_walk_ctx ctx = { .cb = cb, .user = user };
+    k_mutex_lock(&evlog_lock, K_FOREVER);
+    int rc = fcb_walk(&evlog_fcb, NULL, evlog_walk_entry, &ctx);
+    k_mutex_unlock(&evlog_lock);
+    return rc;
+}
+
+static void evlog_count(const struct event_log_rec *rec, void *user)
+{
+    struct event_log_summary *s = user;
+    if (s->total == 0) s->first_epoch = rec->epoch;
+    s->last_epoch = rec->epoch;
+    s->total++;
+    if (rec->type < EVLOG_TYPE_COUNT) s->per_type[rec->type]++;
+}
+
+int event_log_summary(struct event_log_summary *out)
+{
+    if (!out) return -EINVAL;
+    memset(out, 0, sizeof(*out));
+    out->dropped = (uint32_t)atomic_get(&evlog_dropped);
+    return event_log_walk(evlog_count, out);
+}
+
+static void evlog_print(const struct event_log_rec *rec, void *user)
+{
+    char line[48];
+    ARG_UNUSED(user);
+    snprintf(line, sizeof(line), "%u,%u,%u,%u\r\n",
+             (unsigned)rec->epoch, (unsigned)rec->type, (unsigned)rec->arg0, (unsigned)rec->arg1);
+    print_uart(line);
+}
+
+void event_log_export_uart(void)
+{
+    static const char *const names[EVLOG_TYPE_COUNT] = {
+        [EVLOG_RESET] = "reset",
+        [EVLOG_RELAY_FIRE] = "relay",
+        [EVLOG_MODE_CHANGE] = "mode",
+        [EVLOG_SCHED_LOAD] = "load",
+        [EVLOG_RTC_SET] = "rtc",
+    };
+    struct event_log_summary s;
+    char line[96];
+
+    event_log_flush();
+
+    print_uart("epoch,type,arg0,arg1\r\n");
+    int rc = event_log_walk(evlog_print, NULL);
+    if (rc == 0) rc = event_log_summary(&s);
+    if (rc) {
+        snprintf(line, sizeof(line), "Event log unavailable (rc=%d)\r\n", rc);
+        print_uart(line);
+        return;
+    }
+
+    snprintf(line, sizeof(line), "# %u records, epoch %u..%u, dropped %u\r\n",
+             (unsigned)s.total, (unsigned)s.first_epoch, (unsigned)s.last_epoch,
+             (unsigned)s.dropped);
+    print_uart(line);
+    for (int t = 1; t < EVLOG_TYPE_COUNT; ++t) {
+        snprintf(line, sizeof(line), "# %-6s %u\r\n", names[t], (unsigned)s.per_type[t]);
+        print_uart(line);
+    }
+}
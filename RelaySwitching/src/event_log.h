@@ -0,0 +1,65 @@
+// event_log.h — append-only binary event log in an FCB ring on internal flash
+//
+// event_log_post() only queues the record and returns; a work item packs
+// queued records into one FCB entry per batch, so the relay path never
+// touches flash and erase cycles stay low. The oldest sector is recycled
+// when the ring is full.
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+enum event_log_type {
+    EVLOG_RESET = 1,      // arg1: hwinfo reset cause (low 16 bits)
+    EVLOG_RELAY_FIRE,     // arg0: prayer 0..4, arg1: on seconds
+    EVLOG_MODE_CHANGE,    // arg0: 1 = auto, 0 = manual
+    EVLOG_SCHED_LOAD,     // arg0: 1 = ok, 0 = failed, arg1: days in span
+    EVLOG_RTC_SET,        // arg0: source (EVLOG_RTC_SRC_*)
+    EVLOG_TYPE_COUNT
+};
+
+#define EVLOG_RTC_SRC_FILE 1  // one-shot time in a PRAY2 header
+
+// One fixed-size record; stored little-endian exactly as laid out here.
+struct event_log_rec {
+    uint32_t epoch;  // seconds since 1970-01-01, device local time
+    uint8_t  type;   // enum event_log_type
+    uint8_t  arg0;
+    uint16_t arg1;
+};
+
+// Records are written once this many are queued, or EVLOG_FLUSH_DELAY_MS
+// after the first unflushed one, whichever comes first.
+#define EVLOG_BATCH          16
+#define EVLOG_QUEUE_LEN      32
+#define EVLOG_FLUSH_DELAY_MS (60 * 1000)
+
+struct event_log_summary {
+    uint32_t total;
+    uint32_t per_type[EVLOG_TYPE_COUNT];
+    uint32_t first_epoch;
+    uint32_t last_epoch;
+    uint32_t dropped;     // posts lost to a full queue since boot
+};
+
+typedef void (*event_log_cb)(const struct event_log_rec *rec, void *user);
+
+// Open the FCB on eventlog_partition (erased and re-created if unreadable).
+int event_log_init(void);
+
+// Wall-clock reference used to stamp records; call after each RTC read.
+void event_log_set_time(uint32_t epoch);
+
+// Queue one record. Never blocks; safe from any thread or ISR.
+void event_log_post(enum event_log_type type, uint8_t arg0, uint16_t arg1);
+
+// Write out anything queued now (used before reading the log back).
+void event_log_flush(void);
+
+// Stream every stored record, oldest first. Returns 0 or a negative errno.
+int event_log_walk(event_log_cb cb, void *user);
+
+// Totals over the stored log. Returns 0 or a negative errno.
+int event_log_summary(struct event_log_summary *out);
+
+// Print the log as CSV ("epoch,type,arg0,arg1") followed by the summary.
+void event_log_export_uart(void);
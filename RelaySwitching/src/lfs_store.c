@@ -0,0 +1,99 @@
+// lfs_store.c
+#include "lfs_store.h"
+#include "sd_pray2_io.h"
+#include <zephyr/fs/fs.h>
+#include <zephyr/fs/littlefs.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/kernel.h>
+#include <string.h>
+#include <stdio.h>
+
+extern void print_uart(char *buf);
+
+FS_LITTLEFS_DECLARE_DEFAULT_CONFIG(lfs_data);
+static struct fs_mount_t lfs_mp = {
+    .type = FS_LITTLEFS,
+    .fs_data = &lfs_data,
+    .storage_dev = (void *)FIXED_PARTITION_ID(storage_partition),
+    .mnt_point = LFS_STORE_ROOT,
+};
+static bool lfs_mounted;
+
+int lfs_store_mount(void)
+{
+    if (lfs_mounted) return 0;
+
+    // LittleFS formats the partition itself if it finds no valid superblock.
+    int rc = fs_mount(&lfs_mp);
+    if (rc) {
+        char line[64];
+        snprintf(line, sizeof(line), "LittleFS mount failed (rc=%d)\r\n", rc);
+        print_uart(line);
+        return rc;
+    }
+    lfs_mounted = true;
+    return 0;
+}
+
+bool lfs_store_is_mounted(void)
+{
+    return lfs_mounted;
+}
+
+int lfs_store_sync_from_sd(const char *sd_root, int *out_copied)
+{
+    // Static: the list is 1 KiB and only used here.
+    static struct sd_index_entry sd_list[SD_INDEX_MAX_ENTRIES];
+    int copied = 0;
+
+    if (out_copied) *out_copied = 0;
+    if (!lfs_mounted) return -ENODEV;
+
+    int n = sd_index_list(sd_root, sd_list, SD_INDEX_MAX_ENTRIES);
+    if (n < 0) return n;
+
+    for (int i = 0; i < n; ++i) {
+        const struct sd_index_entry *e = &sd_list[i];
+        struct sd_index_entry have = {0};
+
+        // Already imported and identical?
+        if (sd_index_lookup(LFS_STORE_ROOT, e->start_day, &have, NULL, 0) == 0 &&
+            have.start_day == e->start_day && have.crc == e->crc && have.days == e->days) {
+            continue;
+        }
+
+        // Checked as an upload is; a bad file stays on the card only
+        char src[64];
+        snprintf(src, sizeof(src), "%s/%s", sd_root, e->name);
+        int rc = sd_import_pray2(src, LFS_STORE_ROOT, e->name);
+        if (rc == -EINVAL) {
+            char line[64];
+            snprintf(line, sizeof(line), "SD file %s failed its checks; not imported\r\n", e->name);
+            print_uart(line);
+            continue;
+        }
+        if (rc) return rc;
+        copied++;
+    }
+
+    if (out_copied) *out_copied = copied;
+    return 0;
+}
+
+void lfs_store_log(const char *line)
+{
+    if (!lfs_mounted) return;
+
+    struct fs_dirent st;
+    if (fs_stat(LFS_STORE_LOG, &st) == 0 && st.size >= LFS_STORE_LOG_MAX) {
+        (void)fs_unlink(LFS_STORE_ROOT "/device.old");
+        (void)fs_rename(LFS_STORE_LOG, LFS_STORE_ROOT "/device.old");
+    }
+
+    struct fs_file_t f;
+    fs_file_t_init(&f);
+    if (fs_open(&f, LFS_STORE_LOG, FS_O_CREATE | FS_O_WRITE | FS_O_APPEND) != 0) return;
+    (void)fs_write(&f, line, strlen(line));
+    (void)fs_write(&f, "\r\n", 2);
+    fs_close(&f);
+}
@@ -0,0 +1,30 @@
+// lfs_store.h — LittleFS on the internal storage_partition
+//
+// Primary home of the schedule library (same index/file layout as on the SD
+// card, see sd_pray2_io.h) and of the device log. The SD card is only an
+// import/export medium: lfs_store_sync_from_sd() pulls new files in on insert.
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LFS_STORE_ROOT "/lfs"
+#define LFS_STORE_LOG  LFS_STORE_ROOT "/device.log"
+
+// Log file is rotated to device.old once it grows past this many bytes.
+#define LFS_STORE_LOG_MAX (8 * 1024)
+
+// Mount LittleFS on storage_partition (formatted on first use).
+// Returns 0 on success; negative errno otherwise.
+int lfs_store_mount(void);
+
+bool lfs_store_is_mounted(void);
+
+// Copy every library file from sd_root that is missing in internal flash or
+// differs from it (by trailing CRC), and index it; one that fails the checks of
+// sd_import_pray2() is left out. Sets *out_copied if given.
+// Returns 0 on success; negative errno/FS error otherwise.
+int lfs_store_sync_from_sd(const char *sd_root, int *out_copied);
+
+// Append one line ("\r\n" added) to the device log; never fails loudly.
+void lfs_store_log(const char *line);
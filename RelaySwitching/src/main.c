@@ -16,6 +16,15 @@
 #include "sys_flash.h"
 #include "pray2_reader.h"
 #include "sd_pray2_io.h"
+#include "sd_service.h"
+#include "lfs_store.h"
+#include "event_log.h"
+#include "app_config.h"
+#include "rtc_oneshot.h"
+#include "calc_schedule.h"
+#include "app_trace.h"
+#include "app_counters.h"
+#include <zephyr/drivers/hwinfo.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
@@ -24,8 +33,6 @@
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(app);
 
-extern void run_pray2_tests(void);
-
 /* 1000 msec = 1 sec */
 #define SLEEP_TIME_MS 1000
 
@@ -57,6 +64,8 @@ const struct device *SSD1306;
 char buffer[50];
 char timebuff[50];
 char datebuff[50];
+char shown_timebuff[50]; /* what the display holds; unchanged text is not sent again */
+char shown_datebuff[50];
 
 char TxBuffer[100];
 char RxBuffer[100];
@@ -76,11 +85,14 @@ K_MSGQ_DEFINE(uart_msgq, 1, 10, 4);
 
 pray2_sched_t sched;
 
-uint8_t trigger_relay = 0;
-uint32_t relay_start_time = 0;
-uint32_t relay_timeout_set = 5000;
+uint32_t relay_timeout_set = 0; // ms for the pulse in progress, see app_cfg.relay_ms
+
+/* Schedule library lives in internal flash; the SD card is import/export only */
+const char *library_root = LFS_STORE_ROOT;
+bool library_in_flash = true;
 
 uint8_t auto_relay_once = 0;
+uint8_t manual_relay_once = 0;
 uint8_t manual_auto_config = 0; // manual = 0 auto = 1
 
 const unsigned char startup_image_[] = {
@@ -172,6 +184,27 @@ void ledfasttoggle_with_speed(uint8_t toggling, uint16_t togglingspeed)
 	}
 }
 
+/*
+ * End of a relay pulse. Runs from a timer so the pulse lasts exactly
+ * relay_timeout_set; the main loop would only notice on its next pass, up to
+ * a second late. Manual mode stops the timer before holding the relay.
+ */
+static void relay_pulse_end(struct k_timer *timer)
+{
+	ARG_UNUSED(timer);
+	gpio_pin_set(relay.port, relay.pin, 1);
+	APP_TRACE_END(RELAY, 0);
+}
+
+/* Pulse cut short by manual mode; the relay stays held */
+static void relay_pulse_stop(struct k_timer *timer)
+{
+	ARG_UNUSED(timer);
+	APP_TRACE_END(RELAY, 1);
+}
+
+static K_TIMER_DEFINE(relay_timer, relay_pulse_end, relay_pulse_stop);
+
 void print_uart(char *buf)
 {
 	int msg_len = strlen(buf);
@@ -190,30 +223,236 @@ void print_dataBuffer(uint8_t *buf)
 	}
 }
 
-void handle_new_pray2_file(void)
+/*
+ * Month table dump (app_cfg.month_dump). The rows are copied when the schedule
+ * starts, since an upload may overwrite DataBuffer meanwhile, and printed from
+ * the system work queue MONTH_DUMP_CHUNK at a time so neither loading nor the
+ * queue's other items wait on the UART.
+ */
+#define MONTH_DUMP_CHUNK 4
+static struct
 {
-	pray2_header_t H;
-	pray2_status_t st = pray2_validate_and_parse_no_crc(DataBuffer, DataBufferTotalSize, &H);
-	if (st != PRAY2_OK)
+	uint8_t day;
+	uint16_t min[5];
+} month_dump_rows[31];
+static int month_dump_count;
+static int month_dump_next;
+static int month_dump_year;
+static int month_dump_month;
+
+static void month_dump_handler(struct k_work *work)
+{
+	char line[96];
+
+	if (month_dump_next == 0)
 	{
-		print_uart("\r\nError in bin file\r\n");
+		snprintf(line, sizeof(line), "Month %04d-%02d:\r\n", month_dump_year, month_dump_month);
+		print_uart(line);
+	}
+	for (int n = 0; n < MONTH_DUMP_CHUNK && month_dump_next < month_dump_count; n++, month_dump_next++)
+	{
+		const uint16_t *t = month_dump_rows[month_dump_next].min;
+		snprintf(line, sizeof(line),
+				 "%04d-%02d-%02d  Fajr %02d:%02d  Dhuhr %02d:%02d  Asr %02d:%02d  Maghrib %02d:%02d  Isha %02d:%02d\r\n",
+				 month_dump_year, month_dump_month, month_dump_rows[month_dump_next].day,
+				 t[0] / 60, t[0] % 60, t[1] / 60, t[1] % 60, t[2] / 60, t[2] % 60,
+				 t[3] / 60, t[3] % 60, t[4] / 60, t[4] % 60);
+		print_uart(line);
+	}
+	if (month_dump_next < month_dump_count)
+	{
+		(void)k_work_submit(work); /* the rest after the queue's other items */
 		return;
 	}
+	snprintf(line, sizeof(line), "Printed %d day(s) from the table.\r\n", month_dump_count);
+	print_uart(line);
+}
+
+static K_WORK_DEFINE(month_dump_work, month_dump_handler);
 
-	// If one-shot flag is set, set RTC and then clear the flag in the stored blob
-	if (H.flags & PRAY2_FLAG_RTC_ONE_SHOT)
+/* Copy H's rows for now's month and queue their dump; one dump at a time */
+static void month_dump_start(const pray2_header_t *H, const pray2_time_t *now)
+{
+	if (k_work_busy_get(&month_dump_work) != 0)
+	{
+		return; /* still printing the last one, from these rows */
+	}
+	month_dump_year = now->YYYY;
+	month_dump_month = now->MO;
+	month_dump_count = 0;
+	month_dump_next = 0;
+	for (int d = 1; d <= days_in_month(now->YYYY, now->MO); d++)
 	{
-		int hh, mm, ss, DD, MMh, YYYY;
-		if (pray2_parse_rtc_ascii(H.rtc_ascii, &hh, &mm, &ss, &DD, &MMh, &YYYY))
+		int idx = pray2_compute_day_index(H, now->YYYY, now->MO, d);
+		if (idx >= 0 && pray2_get_day_minutes(H, (uint16_t)idx, month_dump_rows[month_dump_count].min))
 		{
-			sprintf(buffer, "%02d:%02d:%02d|%02d/%02d/%02d", hh, mm, ss, DD, MMh, YYYY % 100);
-			print_uart(buffer);
-			RTCmcp7940_set_datetime(RTC_MCP, buffer);
-
-			// Clear the one-shot flag in the stored header byte (offset 14)
-			DataBuffer[14] = (uint8_t)(DataBuffer[14] & ~(PRAY2_FLAG_RTC_ONE_SHOT));
-			H.flags &= ~(PRAY2_FLAG_RTC_ONE_SHOT);
-			print_uart("\r\nRTC set from file (one-shot). Flag cleared.\r\n");
+			month_dump_rows[month_dump_count++].day = (uint8_t)d;
+		}
+	}
+	(void)k_work_submit(&month_dump_work);
+}
+
+/*
+ * Overrides-only file (SD_OVERRIDE_NAME in the library, or an 'f' upload with
+ * no days): its OVERRIDES and WEEKLY rules apply to whichever schedule runs, in
+ * place of the schedule file's own, so a Ramadan or special-day change is a
+ * small upload.
+ */
+static uint8_t override_buf[1024];
+static uint8_t override_next[sizeof(override_buf)]; /* override_load()'s read, kept only if it differs */
+static size_t override_len;
+static pray2_header_t override_hdr;
+static bool have_override;
+
+static bool is_override_file(const pray2_header_t *H)
+{
+	return H->days == 0 && (H->sec_size[PRAY3_SEC_OVERRIDES] != 0 || H->sec_size[PRAY3_SEC_WEEKLY] != 0);
+}
+
+/*
+ * Bytes of the overrides-only file at data, without the XMODEM padding after
+ * it; 0 if it is not one.
+ */
+static size_t override_size(const uint8_t *data, size_t len)
+{
+	pray2_header_t H;
+
+	if (pray2_validate_and_parse_no_crc(data, len, &H) != PRAY2_OK || !is_override_file(&H))
+	{
+		return 0;
+	}
+	size_t n = pray2_payload_size(data, len) + (H.sec_size[PRAY3_SEC_CRC] ? 4u : 0u);
+	return n <= len ? n : 0;
+}
+
+/*
+ * Make the n bytes at data (0: none) the override set. A change unhooks the
+ * scheduler from the old set before it is overwritten; the caller restarts it.
+ * Returns true if the set changed.
+ */
+static bool override_set(const uint8_t *data, size_t n)
+{
+	if (n == override_len && memcmp(override_buf, data, n) == 0)
+	{
+		return false;
+	}
+	if (sched.ovr == &override_hdr)
+	{
+		sched.ovr = NULL;
+	}
+	memcpy(override_buf, data, n);
+	override_len = n;
+	have_override = n != 0 &&
+					pray2_validate_and_parse_no_crc(override_buf, n, &override_hdr) == PRAY2_OK;
+	return true;
+}
+
+/*
+ * (Re)read the library's override file; none leaves the schedule's own overrides.
+ * Returns true if the set changed.
+ */
+static bool override_load(void)
+{
+	char path[64];
+	size_t len;
+	enum sd_pray2_crc crc;
+
+	snprintf(path, sizeof(path), "%s/%s", library_root, SD_OVERRIDE_NAME);
+	int rc = sd_load_entire_file(path, override_next, sizeof(override_next), &len, &crc);
+	size_t n = (rc == 0 && crc != SD_PRAY2_CRC_MISMATCH) ? override_size(override_next, len) : 0;
+	bool changed = override_set(override_next, n);
+	if (n != 0)
+	{
+		print_uart("Date overrides loaded\r\n");
+	}
+	else if (rc != 0 && rc != -ENOENT)
+	{
+		print_uart("Date overrides unreadable; none applied\r\n");
+	}
+	return changed;
+}
+
+/* app_cfg's weekday rules as the scheduler reads them at each day change */
+static pray3_weekly_t weekly_dev[7];
+
+static void weekly_from_cfg(void)
+{
+	for (int i = 0; i < 7; i++)
+	{
+		const struct app_weekly_rule *r = &app_cfg.weekly[i];
+		weekly_dev[i] = (pray3_weekly_t){.mask = r->mask, .mode = r->mode, .value = r->value, .on_sec = r->on_sec};
+	}
+}
+
+/*
+ * Start the scheduler on a file's header. With app_cfg.calc the table is left
+ * out and every day is computed; the file still gives the relay durations.
+ * Otherwise a file with a location section is computed past its span.
+ */
+static bool sched_start(const pray2_header_t *H, const pray2_time_t *now)
+{
+	pray2_header_t h = *H;
+
+	if (calc_schedule_enabled())
+	{
+		h.days = 0;
+	}
+	weekly_from_cfg();
+	return pray2_sched_init_ex(&sched, &h, now, calc_schedule_day_fn(&h),
+							   have_override ? &override_hdr : NULL, weekly_dev);
+}
+
+/* No file for today: computed times alone, with the generator's default durations */
+static void sched_start_calc_only(const char *rtc)
+{
+	pray2_header_t H;
+	pray2_time_t now;
+
+	calc_schedule_header(&H);
+	if (pray2_time_parse(rtc, &now) && sched_start(&H, &now))
+	{
+		print_uart("Computed schedule started\r\n");
+	}
+}
+
+/*
+ * Start the scheduler on a parsed file, in DataBuffer or read in place. key is
+ * the file's payload CRC (rtc_oneshot_key()). rtc is the caller's fresh RTC
+ * reading; it is the only time source used (the RTC is not re-read). Returns
+ * true if the scheduler started.
+ */
+static bool start_pray2_file(const pray2_header_t *file, uint32_t key, const char *rtc)
+{
+	pray2_header_t H = *file;
+	pray2_time_t now;
+	bool have_time = pray2_time_parse(rtc, &now);
+
+	// One-shot RTC time: applied once per file (by CRC), the file itself is never rewritten
+	if (!(H.flags & PRAY2_FLAG_RTC_ONE_SHOT))
+	{
+		key = 0;
+	}
+	if (key != 0 && rtc_oneshot_applied(key))
+	{
+		print_uart("\r\nRTC one-shot already applied for this file.\r\n");
+	}
+	else if (key != 0)
+	{
+		pray2_time_t set;
+		if (pray2_time_parse(H.rtc_ascii, &set))
+		{
+			char setbuf[24];
+			snprintf(setbuf, sizeof(setbuf), "%02d:%02d:%02d|%02d/%02d/%02d",
+					 set.hh, set.mm, set.ss, set.DD, set.MO, set.YYYY % 100);
+			print_uart(setbuf);
+			RTCmcp7940_set_datetime(RTC_MCP, setbuf);
+			event_log_post(EVLOG_RTC_SET, EVLOG_RTC_SRC_FILE, 0);
+			(void)rtc_oneshot_mark(key);
+			print_uart("\r\nRTC set from file (one-shot).\r\n");
+
+			/* The clock now reads what we just wrote */
+			now = set;
+			have_time = true;
 		}
 		else
 		{
@@ -225,24 +464,91 @@ void handle_new_pray2_file(void)
 		print_uart("\r\nRTC one-shot flag not set; leaving RTC unchanged.\r\n");
 	}
 
-	// Read RTC back and init scheduler with the actual device time
-	RTCmcp7940_get_datetime(RTC_MCP, buffer); // "HH:MM:SS|DD/MM/YY"
-	bool ok = pray2_sched_init_from_ram(&sched, DataBuffer, DataBufferTotalSize, buffer);
+	bool ok = have_time && sched_start(&H, &now);
+	event_log_post(EVLOG_SCHED_LOAD, ok ? 1 : 0, H.days);
 
 	if (ok)
 	{
 		print_uart("\r\nPray2 Init success\r\n");
-		int hh2, mm2, ss2, DD2, MM2, YYYY2;
-		if (pray2_parse_rtc_ascii(buffer, &hh2, &mm2, &ss2, &DD2, &MM2, &YYYY2))
+		if (IS_ENABLED(CONFIG_APP_SD_RAW_SCHEDULE) && H.base == DataBuffer)
+		{
+			(void)sd_raw_store(DataBuffer, DataBufferTotalSize); /* no-op if unchanged */
+		}
+		if (app_cfg.month_dump)
 		{
-			debug_print_month_any_year(DataBuffer, DataBufferTotalSize, MM2);
-			// sys_flash_write(0, DataBuffer, sizeof(DataBuffer));
+			month_dump_start(&H, &now);
 		}
 	}
 	else
 	{
 		print_uart("\r\nPray2 Init failed (date out of span or parse error)\r\n");
 	}
+	return ok;
+}
+
+/*
+ * Validate DataBuffer once and start the scheduler on it (see start_pray2_file()).
+ * Returns the validation status: PRAY2_OK for a file that may be kept, even if
+ * it has no day for today.
+ */
+pray2_status_t handle_new_pray2_file(const char *rtc)
+{
+	pray2_header_t H;
+	APP_TRACE_BEGIN(FILE_LOAD, DataBufferTotalSize);
+	pray2_status_t st = pray2_validate_and_parse_no_crc(DataBuffer, DataBufferTotalSize, &H);
+	if (st != PRAY2_OK)
+	{
+		print_uart("\r\nError in bin file\r\n");
+		APP_TRACE_END(FILE_LOAD, 0);
+		return st;
+	}
+	if (H.days == 0)
+	{
+		/* Overrides only (upload_pray2_file() keeps those): no schedule in it */
+		print_uart("\r\nError: bin file has no days\r\n");
+		APP_TRACE_END(FILE_LOAD, 0);
+		return st;
+	}
+	bool ok = start_pray2_file(&H, rtc_oneshot_key(DataBuffer, DataBufferTotalSize), rtc);
+	APP_TRACE_END(FILE_LOAD, ok);
+	return st;
+}
+
+/* The library file read in place when it does not fit DataBuffer */
+static pray_src_t library_src;
+
+/*
+ * A library file bigger than DataBuffer: only its header and directory are
+ * read now, its rows as the days come.
+ */
+static int library_load_in_place(const char *path, const char *rtc)
+{
+	pray2_header_t H;
+	enum sd_pray2_crc crc;
+	uint32_t key;
+
+	int rc = sd_pray_src_open(path, &library_src, &crc, &key);
+	if (rc == 0 && crc == SD_PRAY2_CRC_MISMATCH)
+	{
+		sd_pray_src_close();
+		rc = -EBADMSG;
+	}
+	if (rc)
+	{
+		return rc;
+	}
+	print_uart(crc == SD_PRAY2_CRC_OK ? "CRC OK (read in place)\r\n" : "No CRC in file (read in place)\r\n");
+
+	APP_TRACE_BEGIN(FILE_LOAD, library_src.size);
+	if (pray_open(&library_src, &H) != PRAY2_OK)
+	{
+		print_uart("\r\nError in bin file\r\n");
+		APP_TRACE_END(FILE_LOAD, 0);
+		return -EINVAL;
+	}
+	bool ok = start_pray2_file(&H, key, rtc);
+	APP_TRACE_END(FILE_LOAD, ok);
+	return 0;
 }
 
 void serial_cb(const struct device *dev, void *user_data)
@@ -312,49 +618,178 @@ static uint8_t APPuart_tx(uint8_t byte, uint32_t timeout)
 	return 0;
 }
 
-static void APPuart_process()
-{
-	APPuart_rx(RxBuffer, 1, 1000);
-	// print_uart(RxBuffer);
-	// print_uart("\n");
-
-	// k_msleep(1000);
+/*
+ * The 'c' line: one character is taken per APPuart_process() pass, like the
+ * commands, so the relay keeps switching while it is typed. A line left idle
+ * for LINE_TIMEOUT_MS is dropped.
+ */
+#define LINE_TIMEOUT_MS 10000
+static char config_line[48];
+static int config_len = -1; /* -1: not collecting */
+static uint32_t config_last_ms;
 
-	if (RxBuffer[0] == 'f')
+static void config_line_end(void)
+{
+	config_line[config_len] = '\0';
+	print_uart("\r\n");
+	if (config_len > 0)
 	{
+		int rc = app_config_set_line(config_line);
+		print_uart(rc == 0 ? "ok\r\n" : (rc == -ENOENT ? "unknown key\r\n" : "bad value\r\n"));
+		ssd1306_SetContrast(SSD1306, app_cfg.contrast);
+		weekly_from_cfg(); /* weekday rules: from the next day change */
+	}
+	app_config_print();
+	config_len = -1;
+}
 
-		xmodem_receive(DataBuffer, APPuart_rx, APPuart_tx);
-		print_uart("\r\n");
-		print_uart("\r\n");
-		//  for (int i = 0; i < 3968; i++) {
-		// 	sprintf(DataBuffer_HEX,"%02x ",DataBuffer[i]);
-		// 	print_uart(DataBuffer_HEX);
-		// }
-
-		sprintf(DataBuffer_HEX, "%ld ", DataBufferTotalSize);
-		print_uart(DataBuffer_HEX);
-		handle_new_pray2_file();
-		RxBuffer[0] = '\0';
-
-		char saved_path[128];
-		int rc = sd_store_pray2_from_ram("/SD:", DataBuffer, DataBufferTotalSize,
-										 saved_path, sizeof(saved_path));
-		char msg[200];
-		if (rc == 0)
+/* got: c was just received (else the pass timed out) */
+static void config_line_poll(bool got, char c)
+{
+	if (!got)
+	{
+		if (k_uptime_get_32() - config_last_ms >= LINE_TIMEOUT_MS)
 		{
-			snprintf(msg, sizeof(msg), "Saved PRAY2 to %s (%u bytes)\r\n",
-					 saved_path, (unsigned)DataBufferTotalSize);
+			config_len = 0; /* as an empty line: list the fields */
+			config_line_end();
 		}
-		else if (rc == -EEXIST)
+		return;
+	}
+	config_last_ms = k_uptime_get_32();
+	if (c == '\r' || c == '\n')
+	{
+		config_line_end();
+	}
+	else if (config_len + 1 < (int)sizeof(config_line))
+	{
+		uart_poll_out(uart, c);
+		config_line[config_len++] = c;
+	}
+}
+
+void load_pray2_from_sd_and_init(const char *rtc, bool allow_nearest);
+
+/*
+ * 'f': receive a PRAY2 file over XMODEM into DataBuffer, start the scheduler
+ * on it and save it to the library (a file with no days: see override_size()). The deepest path on the main stack
+ * (tests/stack_budget runs it with a fake link).
+ */
+void upload_pray2_file(uint8_t (*rx)(uint8_t *, uint16_t, uint32_t), uint8_t (*tx)(uint8_t, uint32_t))
+{
+	xmodem_receive(DataBuffer, rx, tx);
+	print_uart("\r\n");
+	print_uart("\r\n");
+	//  for (int i = 0; i < 3968; i++) {
+	// 	sprintf(DataBuffer_HEX,"%02x ",DataBuffer[i]);
+	// 	print_uart(DataBuffer_HEX);
+	// }
+
+	sprintf(DataBuffer_HEX, "%ld ", DataBufferTotalSize);
+	print_uart(DataBuffer_HEX);
+	RTCmcp7940_get_datetime(RTC_MCP, buffer);
+
+	/* No days: overrides only. Save them and restart today's schedule with them */
+	pray2_header_t H;
+	if (pray2_validate_and_parse_no_crc(DataBuffer, DataBufferTotalSize, &H) == PRAY2_OK && H.days == 0)
+	{
+		size_t n = override_size(DataBuffer, DataBufferTotalSize);
+		int rc = (n == 0 || n > sizeof(override_buf)) ? -EINVAL : sd_overrides_store(library_root, DataBuffer, n);
+		char msg[80];
+		if (n == 0 || n > sizeof(override_buf))
 		{
-			snprintf(msg, sizeof(msg),
-					 "Error: multiple .bin files present on SD. Keep only one.\r\n");
+			snprintf(msg, sizeof(msg), "Error: no days and not an overrides file of up to %u bytes\r\n",
+					 (unsigned)sizeof(override_buf));
 		}
 		else
 		{
-			snprintf(msg, sizeof(msg), "Save failed (rc=%d)\r\n", rc);
+			snprintf(msg, sizeof(msg), "Date overrides %s (rc=%d)\r\n", rc ? "not saved" : "saved", rc);
 		}
 		print_uart(msg);
+		load_pray2_from_sd_and_init(buffer, true); /* DataBuffer no longer holds the schedule */
+		return;
+	}
+	/* Only a file the scheduler accepted is kept; store_pray2() checks its CRC too */
+	if (handle_new_pray2_file(buffer) != PRAY2_OK || H.days == 0)
+	{
+		print_uart("Not saved\r\n");
+		return;
+	}
+
+	char saved_path[128];
+	int rc = sd_store_pray2_from_ram(library_root, DataBuffer, DataBufferTotalSize,
+									 saved_path, sizeof(saved_path));
+	char msg[200];
+	if (rc == -EINVAL)
+	{
+		snprintf(msg, sizeof(msg), "Error: CRC mismatch, not saved\r\n");
+	}
+	else if (rc == 0)
+	{
+		snprintf(msg, sizeof(msg), "Saved PRAY2 to %s (%u bytes)\r\n",
+				 saved_path, (unsigned)DataBufferTotalSize);
+		lfs_store_log(msg);
+	}
+	else if (rc == -ENOSPC)
+	{
+		snprintf(msg, sizeof(msg),
+				 "Error: schedule library is full (%d files)\r\n", SD_INDEX_MAX_ENTRIES);
+	}
+	else
+	{
+		snprintf(msg, sizeof(msg), "Save failed (rc=%d)\r\n", rc);
+	}
+	print_uart(msg);
+
+	/* Export a copy to the card so it can be carried to other units */
+	if (rc == 0 && sd_service_is_mounted() && library_in_flash)
+	{
+		rc = sd_store_pray2_from_ram("/SD:", DataBuffer, DataBufferTotalSize,
+									 saved_path, sizeof(saved_path));
+		snprintf(msg, sizeof(msg), rc ? "SD export failed (rc=%d)\r\n" : "Exported to SD\r\n", rc);
+		print_uart(msg);
+	}
+}
+
+static void APPuart_process()
+{
+	bool got = APPuart_rx(RxBuffer, 1, 1000) == 0;
+	// print_uart(RxBuffer);
+	// print_uart("\n");
+
+	// k_msleep(1000);
+
+	if (config_len >= 0)
+	{
+		config_line_poll(got, (char)RxBuffer[0]);
+		RxBuffer[0] = '\0';
+	}
+	else if (RxBuffer[0] == 'c')
+	{
+		/* "c" then "key=value" sets a field; an empty line just lists them */
+		RxBuffer[0] = '\0';
+		print_uart("config> ");
+		config_len = 0;
+		config_last_ms = k_uptime_get_32();
+	}
+	else if (RxBuffer[0] == 'l')
+	{
+		RxBuffer[0] = '\0';
+		event_log_export_uart();
+	}
+	else if (RxBuffer[0] == 't' && IS_ENABLED(CONFIG_APP_TRACE))
+	{
+		RxBuffer[0] = '\0';
+		app_trace_dump(print_uart);
+	}
+	else if (RxBuffer[0] == 'h' && IS_ENABLED(CONFIG_APP_COUNTERS))
+	{
+		RxBuffer[0] = '\0';
+		app_counters_print(print_uart);
+	}
+	else if (RxBuffer[0] == 'f')
+	{
+		RxBuffer[0] = '\0';
+		upload_pray2_file(APPuart_rx, APPuart_tx);
 	}
 }
 
@@ -427,41 +862,176 @@ bool split_timestamp_HHMMSS_bar_DDMMYY(const char *in,
 }
 
 char outputBuffersdcardprint[255];
-void load_pray2_from_sd_and_init(void)
+int32_t library_day = INT32_MIN; /* date of the last library lookup (days since 1970) */
+
+/*
+ * Open the library file whose span covers the date in rtc ("HH:MM:SS|DD/MM/YY")
+ * and init the scheduler from it. With allow_nearest (boot) a file that does not
+ * cover the date is still loaded so its one-shot RTC set can fix a wrong clock.
+ */
+static int library_load(const char *rtc, bool allow_nearest)
 {
 	char bin_path[128];
-	int rc = sd_find_single_bin("/SD:", bin_path, sizeof(bin_path));
+	struct sd_index_entry entry = {0};
+	int hh, mm, ss, DD, MO, YYYY;
+	int32_t day = 0;
+
+	if (pray2_parse_rtc_ascii(rtc, &hh, &mm, &ss, &DD, &MO, &YYYY))
+	{
+		day = (int32_t)pray2_days_from_civil(YYYY, (unsigned)MO, (unsigned)DD);
+	}
+	library_day = day;
+
+	if (!library_in_flash && !sd_service_is_mounted())
+	{
+		/* Retried on SD_EVT_NEW_SCHEDULE once the card is up */
+		sd_service_request();
+		print_uart("Waiting for SD card\r\n");
+		return -EAGAIN;
+	}
+
+	override_load();
+	int rc = sd_index_lookup(library_root, day, &entry, bin_path, sizeof(bin_path));
+	if (rc == -ENOENT && allow_nearest && entry.days != 0)
+	{
+		print_uart("No schedule covers today; loading nearest span\r\n");
+		rc = 0;
+	}
 	if (rc)
 	{
-		sprintf(outputBuffersdcardprint, "No single .bin on SD (rc=%d)\r\n", rc);
+		sprintf(outputBuffersdcardprint, "No schedule for today in %s (rc=%d)\r\n", library_root, rc);
 		print_uart(outputBuffersdcardprint);
 
 		ledfasttoggle_with_speed(10, 200);
 
-		return;
+		return rc;
 	}
 
 	sprintf(outputBuffersdcardprint, "\r\n%s\r\n", bin_path);
 
 	print_uart(outputBuffersdcardprint);
 
-	rc = sd_load_entire_file(bin_path, DataBuffer, sizeof(DataBuffer), &DataBufferTotalSize_);
+	enum sd_pray2_crc crc;
+	rc = sd_load_entire_file(bin_path, DataBuffer, sizeof(DataBuffer), &DataBufferTotalSize_, &crc);
+	if (rc == -EFBIG)
+	{
+		rc = library_load_in_place(bin_path, rtc);
+		if (rc == -EBADMSG)
+		{
+			print_uart("CRC mismatch; stored schedule is corrupt\r\n");
+		}
+		else if (rc)
+		{
+			sprintf(outputBuffersdcardprint, "Read failed (rc=%d)\r\n", rc);
+			print_uart(outputBuffersdcardprint);
+		}
+		ledfasttoggle_with_speed(rc ? 10 : 5, 200);
+		return rc;
+	}
 	if (rc)
 	{
 
 		sprintf(outputBuffersdcardprint, "Read failed (rc=%d)\r\n", rc);
 		print_uart(outputBuffersdcardprint);
 		ledfasttoggle_with_speed(10, 200);
-		return;
+		return rc;
 	}
 
-	// Parse + handle one-shot inside your existing handler
-	handle_new_pray2_file(); // this sets RTC if needed and clears DataBuffer[14]
+	if (crc == SD_PRAY2_CRC_MISMATCH)
+	{
+		print_uart("CRC mismatch; stored schedule is corrupt\r\n");
+		ledfasttoggle_with_speed(10, 200);
+		return -EBADMSG;
+	}
+	print_uart(crc == SD_PRAY2_CRC_OK ? "CRC OK\r\n" : "No CRC in file\r\n");
+	DataBufferTotalSize = (uint16_t)DataBufferTotalSize_;
 
-	// Persist the cleared flag back to SD (so it remains cleared next boot)
-	(void)sd_clear_oneshot_flag_in_file(bin_path);
+	// Parse + handle one-shot inside your existing handler
+	handle_new_pray2_file(rtc); // sets the RTC if this file's one-shot time is new
 
 	ledfasttoggle_with_speed(5, 200);
+	return 0;
+}
+
+void load_pray2_from_sd_and_init(const char *rtc, bool allow_nearest)
+{
+	APP_TRACE_BEGIN(LIB_LOAD, allow_nearest);
+	int rc = library_load(rtc, allow_nearest);
+	APP_TRACE_END(LIB_LOAD, rc);
+}
+
+/* Runs on the SD service queue each time a card is mounted */
+static bool on_sd_mount(void)
+{
+	if (!library_in_flash)
+	{
+		return true; /* the library is the card itself */
+	}
+
+	char line[64];
+	int copied = 0;
+	int rc = lfs_store_sync_from_sd("/SD:", &copied);
+	snprintf(line, sizeof(line), "SD sync: %d new file(s) (rc=%d)", copied, rc);
+	lfs_store_log(line);
+	return copied > 0;
+}
+
+static void library_mount(void)
+{
+	/* Internal flash holds the schedule; the card is optional and only synced from */
+	if (app_cfg.library == APP_LIB_SD || lfs_store_mount() != 0)
+	{
+		library_root = "/SD:";
+		library_in_flash = false;
+	}
+	/* The card mounts in the background; SD_EVT_NEW_SCHEDULE reports new files */
+	sd_service_start(on_sd_mount);
+}
+
+/*
+ * Boot fast path (CONFIG_APP_SD_RAW_SCHEDULE): the active schedule from the raw
+ * sectors ahead of the FAT volume, two sector reads and no mount. Returns true
+ * if the scheduler is running for today.
+ */
+static bool load_pray2_from_raw_and_init(const char *rtc)
+{
+	int rc = sd_raw_load(DataBuffer, sizeof(DataBuffer), &DataBufferTotalSize_);
+	if (rc)
+	{
+		sprintf(outputBuffersdcardprint, "No raw boot copy (rc=%d)\r\n", rc);
+		print_uart(outputBuffersdcardprint);
+		return false;
+	}
+	DataBufferTotalSize = (uint16_t)DataBufferTotalSize_;
+	handle_new_pray2_file(rtc);
+	return sched.valid && sched.have_today;
+}
+
+/*
+ * After the raw boot copy started the schedule: the library's date overrides
+ * were not read with it. A card library is reloaded whole once it mounts; one in
+ * flash is read now, and today's schedule restarted if they apply.
+ */
+static void override_load_after_raw(void)
+{
+	pray2_time_t now;
+
+	if (!(library_in_flash || sd_service_is_mounted()) || !override_load())
+	{
+		return;
+	}
+	RTCmcp7940_get_datetime(RTC_MCP, buffer); /* the file's one-shot time may have set it */
+	if (pray2_time_parse(buffer, &now) && sched_start(&sched.H, &now))
+	{
+		print_uart("Schedule restarted with the date overrides\r\n");
+	}
+}
+
+/* 1 = manual: the switch (switch low = auto), or app_cfg.mode when it overrides it */
+static uint8_t mode_read(void)
+{
+	return (app_cfg.mode == APP_MODE_SWITCH) ? (uint8_t)gpio_pin_get_dt(&auto_btn)
+											 : (app_cfg.mode == APP_MODE_MANUAL);
 }
 
 int main(void)
@@ -473,7 +1043,22 @@ int main(void)
 
 	// sys_flash_read(0, DataBuffer, sizeof(DataBuffer));
 
-	mount_sd_card();
+	(void)app_config_init();
+	(void)rtc_oneshot_init();
+
+	/* With the raw boot copy the mounts wait until the schedule is running */
+	if (!IS_ENABLED(CONFIG_APP_SD_RAW_SCHEDULE))
+	{
+		library_mount();
+	}
+
+	if (event_log_init() != 0)
+	{
+		lfs_store_log("Event log unavailable");
+	}
+	uint32_t reset_cause = 0;
+	(void)hwinfo_get_reset_cause(&reset_cause);
+	(void)hwinfo_clear_reset_cause();
 
 	if (!gpio_is_ready_dt(&led))
 	{
@@ -531,46 +1116,65 @@ int main(void)
 		LOG_ERR("ssd1306 device not ready or not found");
 	}
 
+	ssd1306_SetContrast(SSD1306, app_cfg.contrast);
 	ssd1306_DrawBitmap(SSD1306, 0, 0, startup_image_, 128, 64, White);
 	ssd1306_UpdateScreen(SSD1306);
-	k_msleep(3000);
+	k_msleep(app_cfg.splash_ms);
 
 	APPuart_init();
 
-	/*
-		RTCmcp7940_get_datetime(RTC_MCP, buffer);
-		bool ok = pray2_sched_init_from_ram(&sched, DataBuffer, sizeof(DataBuffer), buffer);
+	RTCmcp7940_get_datetime(RTC_MCP, buffer);
+	uint32_t epoch;
+	if (pray2_rtc_to_epoch(buffer, &epoch))
+	{
+		event_log_set_time(epoch);
+	}
+	event_log_post(EVLOG_RESET, 0, (uint16_t)reset_cause);
 
-		if (ok == true)
-		{
-			print_uart("\r\nPray2 Init success\r\n\r\n");
-			int hh2, mm2, ss2, DD2, MM2, YYYY2;
-			if (pray2_parse_rtc_ascii(buffer, &hh2, &mm2, &ss2, &DD2, &MM2, &YYYY2))
-			{
-				debug_print_month_any_year(DataBuffer, sizeof(DataBuffer), MM2);
-			}
-		}
-		else
+	bool loaded = IS_ENABLED(CONFIG_APP_SD_RAW_SCHEDULE) && sd_service_card_present() &&
+				  load_pray2_from_raw_and_init(buffer);
+	if (IS_ENABLED(CONFIG_APP_SD_RAW_SCHEDULE))
+	{
+		library_mount();
+		if (loaded)
 		{
-			print_uart("\r\nPray2 Init failed\r\n");
+			override_load_after_raw();
 		}
-			*/
+	}
+	if (!loaded)
+	{
+		RTCmcp7940_get_datetime(RTC_MCP, buffer);
+		load_pray2_from_sd_and_init(buffer, true);
+	}
+	if (!sched.have_today && calc_schedule_enabled())
+	{
+		sched_start_calc_only(buffer);
+	}
 
-	load_pray2_from_sd_and_init();
+	/* The mode at boot is not a change: only later ones are logged */
+	manual_auto_config = mode_read();
 
 	while (1)
 	{
+		APP_CNT_INC(LOOPS);
 
-		manual_auto_config = gpio_pin_get_dt(&auto_btn);
+		uint8_t mode = mode_read();
+		if (mode != manual_auto_config)
+		{
+			event_log_post(EVLOG_MODE_CHANGE, mode ? 0 : 1, 0); // switch low = auto
+		}
+		manual_auto_config = mode;
 
 		if (!manual_auto_config)
 		{ /*Auto*/
 			// gpio_pin_set(led.port, led.pin, 1);
+			manual_relay_once = 0;
 			if (!auto_relay_once)
 			{
 				print_uart("auto config");
 				auto_relay_once = 1;
 				gpio_pin_set(relay.port, relay.pin, 1);
+				APP_TRACE_MARK(RELAY, 1);
 			}
 		}
 		else
@@ -578,45 +1182,88 @@ int main(void)
 
 			// gpio_pin_set(led.port, led.pin, 0);
 			auto_relay_once = 0;
+			k_timer_stop(&relay_timer); /* a pulse in progress must not release the hold */
 			gpio_pin_set(relay.port, relay.pin, 0);
+			if (!manual_relay_once)
+			{
+				manual_relay_once = 1;
+				APP_TRACE_MARK(RELAY, 0); /* once per switch to manual, not per pass */
+			}
 		}
 
 		APPuart_process();
 
+		APP_TRACE_BEGIN(TICK, 0);
+		uint32_t tick_start = APP_CNT_STAMP();
+		bool fired = false;
 		RTCmcp7940_get_datetime(RTC_MCP, buffer);
+		if (pray2_rtc_to_epoch(buffer, &epoch))
+		{
+			event_log_set_time(epoch);
+		}
 
 		split_timestamp_HHMMSS_bar_DDMMYY(buffer, timebuff, sizeof(timebuff), datebuff, sizeof(datebuff));
 		gpio_pin_toggle_dt(&led);
 		int prayer;
-		uint16_t onsec;
-		if (pray2_sched_tick(&sched, buffer, &prayer, &onsec) && !manual_auto_config)
+		bool due = pray2_sched_tick(&sched, buffer, &prayer, NULL);
+		if (due && prayer == 4)
+		{
+			calc_schedule_prefetch(buffer); /* tomorrow's times, on the work queue */
+		}
+		if (due && !manual_auto_config)
 		{
 			// prayer: 0=Fajr, 1=Dhuhr, 2=Asr, 3=Maghrib, 4=Isha
 			gpio_pin_set(relay.port, relay.pin, 0);
-			trigger_relay = 1;
-			relay_start_time = k_uptime_get_32();
+			APP_TRACE_BEGIN(RELAY, prayer);
+			APP_CNT_INC_AT(RELAY_FAJR, prayer);
+			fired = true;
+			relay_timeout_set = pray2_sched_relay_ms(&sched, prayer, app_cfg.relay_ms);
+			k_timer_start(&relay_timer, K_MSEC(relay_timeout_set), K_NO_WAIT);
+			event_log_post(EVLOG_RELAY_FIRE, (uint8_t)prayer, (uint16_t)(relay_timeout_set / 1000u));
 
 			char line[96];
 			static const char *name[5] = {"Fajr", "Dhuhr", "Asr", "Maghrib", "Isha"};
-			snprintf(line, sizeof(line), "Relay ON: %s for %us\r\n", name[prayer], (unsigned)onsec);
+			snprintf(line, sizeof(line), "Relay ON: %s for %ums\r\n", name[prayer], (unsigned)relay_timeout_set);
 			print_uart(line);
 		}
 
-		if (trigger_relay)
+		/* New files imported from (or found on) the card */
+		if (k_event_test(&sd_events, SD_EVT_NEW_SCHEDULE))
 		{
-			if (k_uptime_get_32() - relay_start_time >= relay_timeout_set)
+			k_event_clear(&sd_events, SD_EVT_NEW_SCHEDULE);
+			load_pray2_from_sd_and_init(buffer, !sched.valid);
+		}
+
+		/* Span ended (or nothing loaded): switch to the library file for today, once per day.
+		 * A file computed past its span keeps firing meanwhile. */
+		if (!sched.valid || (sched.cur_day_idx < 0 && !calc_schedule_enabled()))
+		{
+			int hh, mm, ss, DD, MO, YYYY;
+			if (pray2_parse_rtc_ascii(buffer, &hh, &mm, &ss, &DD, &MO, &YYYY) &&
+				pray2_days_from_civil(YYYY, (unsigned)MO, (unsigned)DD) != library_day)
 			{
-				gpio_pin_set(relay.port, relay.pin, 1);
-				trigger_relay = 0;
+				load_pray2_from_sd_and_init(buffer, false);
 			}
 		}
 
-		ssd1306_Fill(SSD1306, Black);
-		ssd1306_SetCursor(SSD1306, 0, 0);
-		ssd1306_WriteString(SSD1306, timebuff, Font_16x24, White);
-		ssd1306_SetCursor(SSD1306, 0, 34);
-		ssd1306_WriteString(SSD1306, datebuff, Font_16x24, White);
-		ssd1306_UpdateScreen(SSD1306);
+		/* A key press ends the UART wait early; the same second is not redrawn */
+		if (strcmp(timebuff, shown_timebuff) != 0 || strcmp(datebuff, shown_datebuff) != 0)
+		{
+			ssd1306_Fill(SSD1306, Black);
+			ssd1306_SetCursor(SSD1306, 0, 0);
+			ssd1306_WriteString(SSD1306, timebuff, Font_16x24, White);
+			ssd1306_SetCursor(SSD1306, 0, 34);
+			ssd1306_WriteString(SSD1306, datebuff, Font_16x24, White);
+			ssd1306_UpdateScreen(SSD1306);
+			strcpy(shown_timebuff, timebuff);
+			strcpy(shown_datebuff, datebuff);
+		}
+		else
+		{
+			APP_CNT_INC(FRAMES_SKIPPED);
+		}
+		APP_CNT_MAX(TICK_MAX_US, APP_CNT_US_SINCE(tick_start));
+		APP_TRACE_END(TICK, fired);
 	}
 	return 0;
 }
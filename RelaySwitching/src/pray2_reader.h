@@ -8,12 +8,13 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdio.h>
 
+#include "app_trace.h"     // empty macros unless CONFIG_APP_TRACE
+#include "app_counters.h"  // empty macros unless CONFIG_APP_COUNTERS
 
 extern void print_uart(char *buf);
 
-extern const struct device *RTC_MCP;
-
 // ====== PRAY2 v2 header spec (64 bytes) ======
 //  0  char[5]  magic = "PRAY2"
 //  5  u8       version = 2
@@ -22,7 +23,7 @@ extern const struct device *RTC_MCP;
 // 10  u16      days (count of days in table)
 // 12  u8       start_month (1..12)
 // 13  u8       start_day   (1..31)
-// 14  u8       flags (bit0: per-day durations present; currently 0 in our generator)
+// 14  u8       flags (bit0: per-day durations present; bit1: location section; bit4: RTC one-shot)
 // 15  u8       method_code (0..6; informational)
 // 16  char[17] rtc_str_local = "HH:MM:SS|DD/MM/YY"  (or "...|DD:MM:YY"; no NUL)
 // 33  u8       pad = 0
@@ -33,13 +34,121 @@ extern const struct device *RTC_MCP;
 // 56  u32      durations_size   (0 if none)
 // 60  u16      reserved1 = 0
 // 62  u16      reserved2 = 0
+// Then, with flags bit1, the location section (16 bytes) the table was computed for:
+// 64  i32      lat_udeg  (micro-degrees, north positive)
+// 68  i32      lon_udeg  (east positive)
+// 72  i16      utc_offset_min (local minus UTC the day after the span)
+// 74  u8       asr_shadow (1 Shafi'i, 2 Hanafi)
+// 75  i8[5]    offset_min (Fajr..Isha, as added to the table)
+// table_offset is then >= 80; readers that predate it skip the gap.
 // Then: times table (days × 5 × u16 minutes).  (CRC may be present in file, but ignored here.)
 
+// ====== PRAY3 sectioned container ======
+//  0  char[5]  magic = "PRAY3"
+//  5  u8       version = 3
+//  6  u16      header_size = 48 (the section directory follows)
+//  8..43       as PRAY2: year, days, start_month, start_day, flags (bit4 only),
+//              method_code, rtc_str_local, section_count (at 33, PRAY2's pad),
+//              default_on_sec
+// 44  u32      payload_size: bytes covered by the trailing CRC32
+// 48  directory, section_count × 12 bytes: u16 type, u16 reserved = 0, u32 offset, u32 size
+// Sections sit anywhere after the directory, in any order. Unknown types are
+// skipped, so a section can be added without a new version. TIMES is required
+// when days > 0; CRC, if listed, is the trailing CRC32 at payload_size.
+// The parser reads the header and directory only; pray2_get_day_minutes() and
+// the section getters fetch what they need, from RAM or through a pray_src_t.
+
 #define PRAY2_HEADER_SIZE 64
 #define PRAY2_MAGIC "PRAY2"
 #define PRAY2_VERSION 2
 
+#define PRAY2_FLAG_LOCATION     0x02  // header flags bit1
 #define PRAY2_FLAG_RTC_ONE_SHOT 0x10  // header flags bit4
+#define PRAY2_LOCATION_SIZE     16
+
+#define PRAY3_MAGIC        "PRAY3"
+#define PRAY3_VERSION      3
+#define PRAY3_HEADER_SIZE  48
+#define PRAY3_DIR_ENTRY    12
+#define PRAY3_MAX_SECTIONS 16
+// Header and directory of the largest PRAY3 file; also covers PRAY2's location section.
+#define PRAY_HEAD_MAX      (PRAY3_HEADER_SIZE + PRAY3_MAX_SECTIONS * PRAY3_DIR_ENTRY)
+
+enum pray3_section {
+    PRAY3_SEC_TIMES = 1,      // days × 5 × u16 minutes, PRAY2's table
+    PRAY3_SEC_DURATIONS = 2,  // days × 5 × u16 seconds
+    PRAY3_SEC_LOCATION = 3,   // PRAY2's location section, 16 bytes
+    PRAY3_SEC_METHOD = 4,     // PRAY_METHOD_CUSTOM: u16 fajr, u16 isha (centidegrees), u8 isha_interval_min, u8[3] 0
+    PRAY3_SEC_DST = 5,        // u16 count, u16 0, count × {i32 day since 1970, i16 utc_offset_min, u16 0}, rising
+    PRAY3_SEC_OVERRIDES = 6,  // u16 count, u16 0, count × pray3_override_t (12 bytes), see below
+    PRAY3_SEC_CRC = 7,        // u32 CRC32 of every byte before it
+    PRAY3_SEC_WEEKLY = 8,     // 7 × pray3_weekly_t (8 bytes), Sunday first, see below
+    PRAY3_SEC_TYPES
+};
+
+#define PRAY3_METHOD_SIZE 8
+#define PRAY3_DST_ENTRY   8
+#define PRAY3_OVR_ENTRY   12
+#define PRAY3_OVR_MAX     8   // entries that can apply to one day
+#define PRAY3_WEEKLY_ENTRY 8
+#define PRAY3_WEEKLY_SIZE  (7 * PRAY3_WEEKLY_ENTRY)
+
+// METHOD section
+typedef struct {
+    uint16_t fajr_cdeg;
+    uint16_t isha_cdeg;
+    uint8_t  isha_interval_min;
+} pray3_method_t;
+
+// One DST section entry: utc_offset_min applies from local date `day` on
+typedef struct {
+    int32_t day;
+    int16_t utc_offset_min;
+} pray3_dst_t;
+
+// One OVERRIDES entry, 12 bytes on file: i32 first_day, u16 days, u8 mask,
+// u8 mode, i16 value, u16 on_sec. The prayers in mask (bit0 Fajr .. bit4 Isha)
+// move by value minutes, or to minute value of the day with PRAY3_OVR_ABSOLUTE;
+// on_sec, if not 0, replaces their relay time. Entries are sorted by
+// first_day. Entries with the same first_day share days and apply together;
+// entries with different ones do not overlap. The generator's
+// compile_overrides() writes them so.
+#define PRAY3_OVR_ABSOLUTE 0x01
+typedef struct {
+    int32_t  first_day;  // days since 1970
+    uint16_t days;
+    uint8_t  mask;
+    uint8_t  mode;
+    int16_t  value;
+    uint16_t on_sec;
+} pray3_override_t;
+
+// One WEEKLY rule, 8 bytes on file: u8 mask, u8 mode, i16 value, u16 on_sec,
+// u16 0. An OVERRIDES entry without the dates, for every such weekday; mask 0
+// is no rule. Applied before the day's OVERRIDES.
+typedef struct {
+    uint8_t  mask;
+    uint8_t  mode;
+    int16_t  value;
+    uint16_t on_sec;
+} pray3_weekly_t;
+
+// Where a file's bytes come from when it is not held in RAM (flash, SD).
+// read() returns 0 once len bytes at off are in buf, else a negative errno.
+typedef struct pray_src {
+    int (*read)(const struct pray_src* src, uint32_t off, void* buf, uint32_t len);
+    uint32_t size;  // file size
+    void* ctx;
+} pray_src_t;
+
+// Location section: what the device computes from once the span has ended.
+typedef struct {
+    int32_t lat_udeg;
+    int32_t lon_udeg;
+    int16_t utc_offset_min;
+    uint8_t asr_shadow;
+    int8_t  offset_min[5];
+} pray2_location_t;
 
 typedef struct {
     // header fields
@@ -55,7 +164,14 @@ typedef struct {
     uint32_t table_size;
     uint32_t durations_offset;
     uint32_t durations_size;
-    // derived pointers into the supplied buffer
+    bool     has_location;        // location section present: pray2_get_location()
+    uint8_t  version;             // 2 or 3
+    uint32_t file_size;
+    uint32_t sec_off[PRAY3_SEC_TYPES];   // by enum pray3_section; size 0 if absent
+    uint32_t sec_size[PRAY3_SEC_TYPES];
+    const uint8_t* base;          // whole file in RAM, or NULL
+    const pray_src_t* src;        // else read through this; not owned
+    // derived pointers into the supplied buffer (NULL unless in RAM)
     const uint8_t* table_ptr;     // not owned
     const uint8_t* durations_ptr; // NULL if not present
 } pray2_header_t;
@@ -85,7 +201,7 @@ static inline void advance_one_day(int *y, int *m, int *d) {
 }
 
 // Days-from-civil (Hinnant), for robust index math across leap years.
-static int64_t pray2_days_from_civil(int y, unsigned m, unsigned d) {
+static inline int64_t pray2_days_from_civil(int y, unsigned m, unsigned d) {
     y -= m <= 2;
     const int era = (y >= 0 ? y : y - 399) / 400;
     const unsigned yoe = (unsigned)(y - era * 400);
@@ -93,7 +209,7 @@ static int64_t pray2_days_from_civil(int y, unsigned m, unsigned d) {
     const unsigned doe = yoe * 365 + yoe/4 - yoe/100 + doy;
     return era * 146097 + (int)doe - 719468; // days since 1970-01-01
 }
-static int pray2_days_between(int y1,int m1,int d1, int y2,int m2,int d2){
+static inline int pray2_days_between(int y1,int m1,int d1, int y2,int m2,int d2){
     int64_t a = pray2_days_from_civil(y1,(unsigned)m1,(unsigned)d1);
     int64_t b = pray2_days_from_civil(y2,(unsigned)m2,(unsigned)d2);
     int64_t diff = b - a;
@@ -103,16 +219,25 @@ static int pray2_days_between(int y1,int m1,int d1, int y2,int m2,int d2){
 }
 
 // Parse "HH:MM:SS|DD/MM/YY"  (also accepts "DD:MM:YY")
-static bool pray2_parse_rtc_ascii(const char* s17,
+static inline bool pray2_parse_rtc_ascii(const char* s17,
                                   int* out_h, int* out_m, int* out_s,
                                   int* out_D, int* out_M, int* out_Y_full)
 {
     if (!s17) return false;
     // expected positions:  01234567890123456
     //                      HH:MM:SS|DD/MM/YY
-    if (!(s17[2]==':' && s17[5]==':' && s17[8]=='|')) return false;
-    char sep1 = s17[11], sep2 = s17[14];
-    if (!((sep1=='/'||sep1==':') && (sep2=='/'||sep2==':'))) return false;
+    // Checked left to right so a short or NUL-terminated string stops at its end.
+    static const char pat[] = "dd:dd:dd|dd/dd/dd";
+    for (int i = 0; i < 17; ++i) {
+        const char c = s17[i];
+        if (pat[i] == 'd') {
+            if (c < '0' || c > '9') return false;
+        } else if (pat[i] == '/') {
+            if (c != '/' && c != ':') return false;
+        } else if (c != pat[i]) {
+            return false;
+        }
+    }
 
     int HH = (s17[0]-'0')*10 + (s17[1]-'0');
     int MM = (s17[3]-'0')*10 + (s17[4]-'0');
@@ -121,7 +246,7 @@ static bool pray2_parse_rtc_ascii(const char* s17,
     int MO = (s17[12]-'0')*10 + (s17[13]-'0');
     int YY = (s17[15]-'0')*10 + (s17[16]-'0');
 
-    if (HH<0||HH>23||MM<0||MM>59||SS<0||SS>59) return false;
+    if (HH>23||MM>59||SS>59) return false;
     if (MO<1||MO>12||DD<1||DD>31) return false;
 
     int Y_full = 2000 + YY;  // tweak if you want a different century rule
@@ -134,6 +259,26 @@ static bool pray2_parse_rtc_ascii(const char* s17,
     return true;
 }
 
+// One parsed RTC reading: taken once per load and passed down, never re-read.
+typedef struct {
+    int hh, mm, ss;
+    int DD, MO, YYYY;
+} pray2_time_t;
+
+static inline bool pray2_time_parse(const char* s17, pray2_time_t* t) {
+    return pray2_parse_rtc_ascii(s17, &t->hh, &t->mm, &t->ss, &t->DD, &t->MO, &t->YYYY);
+}
+
+// Seconds since 1970-01-01 00:00 (device local time) for an RTC string.
+static inline bool pray2_rtc_to_epoch(const char* s17, uint32_t* out_epoch)
+{
+    int hh, mm, ss, DD, MO, YYYY;
+    if (!pray2_parse_rtc_ascii(s17, &hh, &mm, &ss, &DD, &MO, &YYYY)) return false;
+    int64_t day = pray2_days_from_civil(YYYY, (unsigned)MO, (unsigned)DD);
+    if (out_epoch) *out_epoch = (uint32_t)(day * 86400 + hh * 3600 + mm * 60 + ss);
+    return true;
+}
+
 // ===== Validation without CRC (XMODEM padding tolerated) =====
 typedef enum {
     PRAY2_OK = 0,
@@ -144,97 +289,419 @@ typedef enum {
     PRAY2_ERR_TABLE_RANGE,
     PRAY2_ERR_TABLE_SIZE,
     PRAY2_ERR_DUR_SIZE,
-    PRAY2_ERR_DUR_RANGE
+    PRAY2_ERR_DUR_RANGE,
+    PRAY2_ERR_START_DATE,
+    PRAY2_ERR_LOCATION,
+    PRAY2_ERR_SECTION
 } pray2_status_t;
 
-// Validates sizes/ranges, fills header struct & pointers. No CRC used.
-static pray2_status_t pray2_validate_and_parse_no_crc(const uint8_t* buf, size_t len, pray2_header_t* out) {
-    if (!buf || len < PRAY2_HEADER_SIZE) {
-    print_uart("pray2 err: too small");
-      
-        return PRAY2_ERR_TOO_SMALL;
-    
-    }
-    if (memcmp(buf, PRAY2_MAGIC, 5) != 0) {
-       print_uart("pray2 err: magic");
-        return PRAY2_ERR_MAGIC;
-    }
-    if (buf[5] != PRAY2_VERSION) {
-      print_uart("pray2 err: version");   
-        return PRAY2_ERR_VERSION;
+static inline void pray2_decode_location(const uint8_t* q, pray2_location_t* loc) {
+    loc->lat_udeg       = (int32_t)pray2_rd_u32le(q);
+    loc->lon_udeg       = (int32_t)pray2_rd_u32le(q + 4);
+    loc->utc_offset_min = (int16_t)pray2_rd_u16le(q + 8);
+    loc->asr_shadow     = q[10];
+    for (int i = 0; i < 5; ++i) loc->offset_min[i] = (int8_t)q[11 + i];
+}
+
+static inline bool pray2_location_valid(const pray2_location_t* loc) {
+    return loc->lat_udeg >= -90000000 && loc->lat_udeg <= 90000000 &&
+           loc->lon_udeg >= -180000000 && loc->lon_udeg <= 180000000 &&
+           loc->utc_offset_min >= -720 && loc->utc_offset_min <= 840 &&
+           loc->asr_shadow >= 1 && loc->asr_shadow <= 2;
+}
+
+// Offsets 8..43, the same in PRAY2 and PRAY3, and the start date check.
+static inline pray2_status_t pray_parse_common(const uint8_t* buf, pray2_header_t* h) {
+    h->year        = pray2_rd_u16le(buf + 8);
+    h->days        = pray2_rd_u16le(buf + 10);
+    h->start_month = buf[12];
+    h->start_day   = buf[13];
+    h->flags       = buf[14];
+    h->method_code = buf[15];
+    memcpy(h->rtc_ascii, buf + 16, 17);
+    h->rtc_ascii[17] = '\0';
+
+    const uint8_t* p = buf + 34;
+    for (int i = 0; i < 5; ++i) h->default_on_sec[i] = pray2_rd_u16le(p + i*2);
+
+    // Every date helper indexes by month; a bad start date would walk off the end.
+    if (h->start_month < 1 || h->start_month > 12 ||
+        h->start_day < 1 || h->start_day > days_in_month(h->year, h->start_month)) {
+        print_uart("pray2 err: start_date");
+        return PRAY2_ERR_START_DATE;
     }
+    return PRAY2_OK;
+}
+
+// PRAY2: buf holds the first head_len bytes of a len-byte file.
+static inline pray2_status_t pray2_parse_v2(const uint8_t* buf, size_t head_len, size_t len, pray2_header_t* h) {
     uint16_t header_size = pray2_rd_u16le(buf + 6);
     if (header_size != PRAY2_HEADER_SIZE) {
       print_uart("pray2 err: header size");
         return PRAY2_ERR_HEADER_SIZE;
     }
-    pray2_header_t h;
-    h.year        = pray2_rd_u16le(buf + 8);
-    h.days        = pray2_rd_u16le(buf + 10);
-    h.start_month = buf[12];
-    h.start_day   = buf[13];
-    h.flags       = buf[14];
-    h.method_code = buf[15];
-    memcpy(h.rtc_ascii, buf + 16, 17);
-    h.rtc_ascii[17] = '\0';
+    pray2_status_t st = pray_parse_common(buf, h);
+    if (st != PRAY2_OK) return st;
 
-    const uint8_t* p = buf + 34;
-    for (int i = 0; i < 5; ++i) h.default_on_sec[i] = pray2_rd_u16le(p + i*2);
+    h->table_offset     = pray2_rd_u32le(buf + 44);
+    h->table_size       = pray2_rd_u32le(buf + 48);
+    h->durations_offset = pray2_rd_u32le(buf + 52);
+    h->durations_size   = pray2_rd_u32le(buf + 56);
 
-    h.table_offset     = pray2_rd_u32le(buf + 44);
-    h.table_size       = pray2_rd_u32le(buf + 48);
-    h.durations_offset = pray2_rd_u32le(buf + 52);
-    h.durations_size   = pray2_rd_u32le(buf + 56);
+    h->has_location = (h->flags & PRAY2_FLAG_LOCATION) != 0;
+    if (h->has_location) {
+        pray2_location_t loc;
+        if (h->table_offset < PRAY2_HEADER_SIZE + PRAY2_LOCATION_SIZE ||
+            head_len < PRAY2_HEADER_SIZE + PRAY2_LOCATION_SIZE) {
+            print_uart("pray2 err: location");
+            return PRAY2_ERR_LOCATION;
+        }
+        pray2_decode_location(buf + PRAY2_HEADER_SIZE, &loc);
+        if (!pray2_location_valid(&loc)) {
+            print_uart("pray2 err: location");
+            return PRAY2_ERR_LOCATION;
+        }
+        h->sec_off[PRAY3_SEC_LOCATION]  = PRAY2_HEADER_SIZE;
+        h->sec_size[PRAY3_SEC_LOCATION] = PRAY2_LOCATION_SIZE;
+    }
 
     // Basic sanity: table must lie within provided buffer (XMODEM padding may make len much larger).
-    if (h.table_offset < PRAY2_HEADER_SIZE || h.table_offset > len) {
+    if (h->table_offset < PRAY2_HEADER_SIZE || h->table_offset > len) {
          print_uart("pray2 err: table_range");
         return PRAY2_ERR_TABLE_RANGE;
     }
-    if (h.table_size != (uint32_t)h.days * 5u * 2u) {
+    if (h->table_size != (uint32_t)h->days * 5u * 2u) {
        print_uart("pray2 err: table_size");
         return PRAY2_ERR_TABLE_SIZE;
     }
-    if ((uint64_t)h.table_offset + (uint64_t)h.table_size > (uint64_t)len) {
+    if ((uint64_t)h->table_offset + (uint64_t)h->table_size > (uint64_t)len) {
          print_uart("pray2 err: table_range");
         return PRAY2_ERR_TABLE_RANGE;
     }
-    if (h.flags & 0x01u) {
-        if (h.durations_offset == 0 || h.durations_size != (uint32_t)h.days * 5u * 2u)
+    if (h->flags & 0x01u) {
+        if (h->durations_offset == 0 || h->durations_size != (uint32_t)h->days * 5u * 2u)
            {
              print_uart("pray2 err: dur_size");
               return PRAY2_ERR_DUR_SIZE;
            }
-        if ((uint64_t)h.durations_offset + (uint64_t)h.durations_size > (uint64_t)len)
+        if ((uint64_t)h->durations_offset + (uint64_t)h->durations_size > (uint64_t)len)
             {
                  print_uart("pray2 err: dur_range");
                 return PRAY2_ERR_DUR_RANGE;
             }
     } else {
-        if (h.durations_offset != 0 || h.durations_size != 0)
+        if (h->durations_offset != 0 || h->durations_size != 0)
             {
                  print_uart("pray2 err: dur_range");
                 return PRAY2_ERR_DUR_RANGE;
             }
     }
+    return PRAY2_OK;
+}
+
+// PRAY3: header and directory, which must lie within the head_len bytes in buf.
+static inline pray2_status_t pray3_parse(const uint8_t* buf, size_t head_len, size_t len, pray2_header_t* h) {
+    if (pray2_rd_u16le(buf + 6) != PRAY3_HEADER_SIZE) {
+        print_uart("pray2 err: header size");
+        return PRAY2_ERR_HEADER_SIZE;
+    }
+    pray2_status_t st = pray_parse_common(buf, h);
+    if (st != PRAY2_OK) return st;
+
+    const unsigned count = buf[33];
+    const uint32_t dir_end = PRAY3_HEADER_SIZE + count * PRAY3_DIR_ENTRY;
+    const uint32_t payload = pray2_rd_u32le(buf + 44);
+    if (count < 1 || count > PRAY3_MAX_SECTIONS || head_len < dir_end) {
+        print_uart("pray2 err: section");
+        return count > PRAY3_MAX_SECTIONS || count < 1 ? PRAY2_ERR_SECTION : PRAY2_ERR_TOO_SMALL;
+    }
+    // The CRC check reads this many bytes, CRC section or not
+    if (payload < dir_end || payload > len) {
+        print_uart("pray2 err: payload size");
+        return PRAY2_ERR_SECTION;
+    }
+    for (unsigned i = 0; i < count; ++i) {
+        const uint8_t* e = buf + PRAY3_HEADER_SIZE + i * PRAY3_DIR_ENTRY;
+        const uint16_t type = pray2_rd_u16le(e);
+        const uint32_t off = pray2_rd_u32le(e + 4);
+        const uint32_t size = pray2_rd_u32le(e + 8);
+        if (off < dir_end || (uint64_t)off + size > (uint64_t)len) {
+            print_uart("pray2 err: section");
+            return PRAY2_ERR_SECTION;
+        }
+        if (type == 0 || type >= PRAY3_SEC_TYPES) continue;  // newer than this reader
+        if (h->sec_size[type] != 0 || size == 0) {
+            print_uart("pray2 err: section");
+            return PRAY2_ERR_SECTION;
+        }
+        switch (type) {
+        case PRAY3_SEC_TIMES:
+            if (size != (uint32_t)h->days * 5u * 2u) { print_uart("pray2 err: table_size"); return PRAY2_ERR_TABLE_SIZE; }
+            break;
+        case PRAY3_SEC_DURATIONS:
+            if (size != (uint32_t)h->days * 5u * 2u) { print_uart("pray2 err: dur_size"); return PRAY2_ERR_DUR_SIZE; }
+            break;
+        case PRAY3_SEC_LOCATION:
+            if (size != PRAY2_LOCATION_SIZE) { print_uart("pray2 err: location"); return PRAY2_ERR_LOCATION; }
+            break;
+        case PRAY3_SEC_METHOD:
+            if (size != PRAY3_METHOD_SIZE) { print_uart("pray2 err: section"); return PRAY2_ERR_SECTION; }
+            break;
+        case PRAY3_SEC_DST:
+            if (size < 4 || (size - 4u) % PRAY3_DST_ENTRY) { print_uart("pray2 err: section"); return PRAY2_ERR_SECTION; }
+            break;
+        case PRAY3_SEC_OVERRIDES:
+            if (size < 4 || (size - 4u) % PRAY3_OVR_ENTRY) { print_uart("pray2 err: section"); return PRAY2_ERR_SECTION; }
+            break;
+        case PRAY3_SEC_WEEKLY:
+            if (size != PRAY3_WEEKLY_SIZE) { print_uart("pray2 err: section"); return PRAY2_ERR_SECTION; }
+            break;
+        case PRAY3_SEC_CRC:
+            if (size != 4 || off != payload) { print_uart("pray2 err: section"); return PRAY2_ERR_SECTION; }
+            break;
+        default:
+            break;
+        }
+        h->sec_off[type] = off;
+        h->sec_size[type] = size;
+    }
+    if (h->days > 0 && h->sec_size[PRAY3_SEC_TIMES] == 0) {
+        print_uart("pray2 err: table_range");
+        return PRAY2_ERR_TABLE_RANGE;
+    }
+    h->table_offset     = h->sec_off[PRAY3_SEC_TIMES];
+    h->table_size       = h->sec_size[PRAY3_SEC_TIMES];
+    h->durations_offset = h->sec_off[PRAY3_SEC_DURATIONS];
+    h->durations_size   = h->sec_size[PRAY3_SEC_DURATIONS];
+    h->has_location     = h->sec_size[PRAY3_SEC_LOCATION] != 0;
+    return PRAY2_OK;
+}
+
+// Either format. head is the file's first head_len bytes (the whole file when
+// base is set); len is the file size. Rows and sections are read from base if
+// given, else through src, which must then outlive the header and its copies.
+static inline pray2_status_t pray2_parse_header(const uint8_t* head, size_t head_len, size_t len,
+                                                const uint8_t* base, const pray_src_t* src,
+                                                pray2_header_t* out) {
+    if (!head || head_len < PRAY3_HEADER_SIZE || len < PRAY2_HEADER_SIZE) {
+    print_uart("pray2 err: too small");
+      
+        return PRAY2_ERR_TOO_SMALL;
+    
+    }
+    pray2_header_t h;
+    pray2_status_t st;
+    memset(&h, 0, sizeof(h));
+    if (memcmp(head, PRAY2_MAGIC, 5) == 0) {
+        if (head[5] != PRAY2_VERSION) {
+          print_uart("pray2 err: version");   
+            return PRAY2_ERR_VERSION;
+        }
+        if (head_len < PRAY2_HEADER_SIZE) return PRAY2_ERR_TOO_SMALL;
+        st = pray2_parse_v2(head, head_len, len, &h);
+    } else if (memcmp(head, PRAY3_MAGIC, 5) == 0) {
+        if (head[5] != PRAY3_VERSION) {
+            print_uart("pray2 err: version");
+            return PRAY2_ERR_VERSION;
+        }
+        st = pray3_parse(head, head_len, len, &h);
+    } else {
+       print_uart("pray2 err: magic");
+        return PRAY2_ERR_MAGIC;
+    }
+    if (st != PRAY2_OK) return st;
 
-    h.table_ptr     = buf + h.table_offset;
-    h.durations_ptr = (h.flags & 0x01u) ? (buf + h.durations_offset) : NULL;
+    h.version   = head[5];
+    h.file_size = (uint32_t)len;
+    h.base      = base;
+    h.src       = base ? NULL : src;
+    if (h.version == PRAY2_VERSION) {
+        h.sec_off[PRAY3_SEC_TIMES]  = h.table_offset;
+        h.sec_size[PRAY3_SEC_TIMES] = h.table_size;
+        if (h.flags & 0x01u) {
+            h.sec_off[PRAY3_SEC_DURATIONS]  = h.durations_offset;
+            h.sec_size[PRAY3_SEC_DURATIONS] = h.durations_size;
+        }
+    }
+    h.table_ptr     = (base && h.table_size) ? (base + h.table_offset) : NULL;
+    h.durations_ptr = (base && h.durations_size) ? (base + h.durations_offset) : NULL;
 
     if (out) *out = h;
     return PRAY2_OK;
 }
 
+// Validates sizes/ranges, fills header struct & pointers. No CRC used.
+static inline pray2_status_t pray2_validate_and_parse_no_crc(const uint8_t* buf, size_t len, pray2_header_t* out) {
+    APP_TRACE_BEGIN(PRAY2_PARSE, len);
+    pray2_status_t st = pray2_parse_header(buf, len, len, buf, NULL, out);
+    APP_TRACE_END(PRAY2_PARSE, st);
+    return st;
+}
+
+// The same for a file behind src (flash, SD): reads the header and directory
+// only. Rows and sections are fetched through src when asked for.
+static inline pray2_status_t pray_open(const pray_src_t* src, pray2_header_t* out) {
+    uint8_t head[PRAY_HEAD_MAX];
+    const uint32_t n = src->size < sizeof(head) ? src->size : (uint32_t)sizeof(head);
+
+    APP_TRACE_BEGIN(PRAY2_PARSE, src->size);
+    pray2_status_t st = (src->read(src, 0, head, n) == 0)
+                            ? pray2_parse_header(head, n, src->size, NULL, src, out)
+                            : PRAY2_ERR_TOO_SMALL;
+    APP_TRACE_END(PRAY2_PARSE, st);
+    return st;
+}
+
+// Bytes covered by the trailing CRC32 the generator appends (header + table + optional
+// durations); the CRC itself sits right after them as u32 LE. Only looks at the header
+// fields, so it can be called on the first chunk of a file. Returns 0 if not a PRAY2/3 header.
+static inline uint32_t pray2_payload_size(const uint8_t* buf, size_t len) {
+    if (buf && len >= PRAY3_HEADER_SIZE && memcmp(buf, PRAY3_MAGIC, 5) == 0) {
+        return pray2_rd_u32le(buf + 44);
+    }
+    if (!buf || len < PRAY2_HEADER_SIZE || memcmp(buf, PRAY2_MAGIC, 5) != 0) return 0;
+    uint64_t end = (uint64_t)pray2_rd_u32le(buf + 44) + pray2_rd_u32le(buf + 48);
+    if (buf[14] & 0x01u) {
+        uint64_t dur_end = (uint64_t)pray2_rd_u32le(buf + 52) + pray2_rd_u32le(buf + 56);
+        if (dur_end > end) end = dur_end;
+    }
+    return (end > UINT32_MAX) ? 0 : (uint32_t)end;
+}
+
+// len bytes at off of the file behind h: from RAM, else through h->src.
+static inline bool pray_read(const pray2_header_t* h, uint32_t off, void* buf, uint32_t len) {
+    if (!h || (uint64_t)off + len > h->file_size) return false;
+    if (h->base) {
+        memcpy(buf, h->base + off, len);
+        return true;
+    }
+    return h->src && h->src->read(h->src, off, buf, len) == 0;
+}
+
 // Read one day's 5 times (minutes since local midnight). Returns false if out-of-range.
-static bool pray2_get_day_minutes(const pray2_header_t* h, uint16_t day_index, uint16_t out_minutes[5]) {
-    if (!h || !h->table_ptr || day_index >= h->days) return false;
-    const uint8_t* rec = h->table_ptr + (size_t)day_index * 5u * 2u;
+static inline bool pray2_get_day_minutes(const pray2_header_t* h, uint16_t day_index, uint16_t out_minutes[5]) {
+    if (!h || day_index >= h->days) return false;
+    const uint8_t* rec;
+    uint8_t fetched[10];
+    if (h->table_ptr) {
+        rec = h->table_ptr + (size_t)day_index * 5u * 2u;
+    } else if (pray_read(h, h->table_offset + (uint32_t)day_index * 10u, fetched, sizeof(fetched))) {
+        rec = fetched;
+    } else {
+        return false;
+    }
     for (int i = 0; i < 5; ++i) out_minutes[i] = pray2_rd_u16le(rec + i*2);
     return true;
 }
 
+// The location section, checked; false if there is none or it is out of range.
+static inline bool pray2_get_location(const pray2_header_t* h, pray2_location_t* out) {
+    uint8_t q[PRAY2_LOCATION_SIZE];
+    if (!h || !h->has_location || !pray_read(h, h->sec_off[PRAY3_SEC_LOCATION], q, sizeof(q))) return false;
+    pray2_decode_location(q, out);
+    return pray2_location_valid(out);
+}
+
+// The METHOD section (PRAY3 only); false if there is none.
+static inline bool pray3_get_method(const pray2_header_t* h, pray3_method_t* out) {
+    uint8_t q[PRAY3_METHOD_SIZE];
+    if (!h || !h->sec_size[PRAY3_SEC_METHOD] || !pray_read(h, h->sec_off[PRAY3_SEC_METHOD], q, sizeof(q))) return false;
+    out->fajr_cdeg = pray2_rd_u16le(q);
+    out->isha_cdeg = pray2_rd_u16le(q + 2);
+    out->isha_interval_min = q[4];
+    return true;
+}
+
+// Up to max DST entries (PRAY3 only). Returns how many were read, 0 if none.
+static inline int pray3_get_dst(const pray2_header_t* h, pray3_dst_t* out, int max) {
+    uint8_t q[PRAY3_DST_ENTRY];
+    if (!h || !h->sec_size[PRAY3_SEC_DST] || !pray_read(h, h->sec_off[PRAY3_SEC_DST], q, 4)) return 0;
+    int n = pray2_rd_u16le(q);
+    if ((uint32_t)n > (h->sec_size[PRAY3_SEC_DST] - 4u) / PRAY3_DST_ENTRY) return 0;
+    if (n > max) n = max;
+    for (int i = 0; i < n; ++i) {
+        if (!pray_read(h, h->sec_off[PRAY3_SEC_DST] + 4u + (uint32_t)i * PRAY3_DST_ENTRY, q, sizeof(q))) return i;
+        out[i].day = (int32_t)pray2_rd_u32le(q);
+        out[i].utc_offset_min = (int16_t)pray2_rd_u16le(q + 4);
+    }
+    return n;
+}
+
+static inline bool pray3_read_override(const pray2_header_t* h, uint32_t i, pray3_override_t* o) {
+    uint8_t q[PRAY3_OVR_ENTRY];
+    if (!pray_read(h, h->sec_off[PRAY3_SEC_OVERRIDES] + 4u + i * PRAY3_OVR_ENTRY, q, sizeof(q))) return false;
+    o->first_day = (int32_t)pray2_rd_u32le(q);
+    o->days      = pray2_rd_u16le(q + 4);
+    o->mask      = q[6];
+    o->mode      = q[7];
+    o->value     = (int16_t)pray2_rd_u16le(q + 8);
+    o->on_sec    = pray2_rd_u16le(q + 10);
+    return true;
+}
+
+// The OVERRIDES entries covering date, up to max of them: a binary search for
+// the last entry starting on or before date, then back over the entries that
+// start with it. Returns how many, 0 if none (or no section).
+static inline int pray3_find_overrides(const pray2_header_t* h, int32_t date, pray3_override_t* out, int max) {
+    uint8_t q[4];
+    if (!h || !h->sec_size[PRAY3_SEC_OVERRIDES] || !pray_read(h, h->sec_off[PRAY3_SEC_OVERRIDES], q, 4)) return 0;
+    uint32_t count = pray2_rd_u16le(q);
+    if (count > (h->sec_size[PRAY3_SEC_OVERRIDES] - 4u) / PRAY3_OVR_ENTRY) return 0;
+
+    uint32_t lo = 0, hi = count;  // first entry starting after date
+    pray3_override_t o;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2u;
+        if (!pray3_read_override(h, mid, &o)) return 0;
+        if (o.first_day <= date) lo = mid + 1u; else hi = mid;
+    }
+    int n = 0;
+    int32_t first = 0;
+    for (uint32_t i = lo; i-- > 0 && n < max; ) {
+        if (!pray3_read_override(h, i, &o) || (i + 1u < lo && o.first_day != first)) break;
+        first = o.first_day;
+        if (date - o.first_day < (int32_t)o.days) out[n++] = o;
+    }
+    return n;
+}
+
+// Apply n overrides to one day's times and relay seconds. Times stay within
+// the day and rising, as the generator's compute_minutes_table() leaves them.
+static inline void pray3_apply_overrides(const pray3_override_t* o, int n, uint16_t minutes[5], uint16_t on_sec[5]) {
+    for (int k = 0; k < n; ++k) {
+        for (int i = 0; i < 5; ++i) {
+            if (!(o[k].mask & (1u << i))) continue;
+            int32_t t = (o[k].mode & PRAY3_OVR_ABSOLUTE) ? o[k].value : (int32_t)minutes[i] + o[k].value;
+            minutes[i] = (uint16_t)(t < 0 ? 0 : t > 1439 ? 1439 : t);
+            if (o[k].on_sec) on_sec[i] = o[k].on_sec;
+        }
+    }
+    for (int i = 1; i < 5; ++i) {
+        if (minutes[i] <= minutes[i - 1]) minutes[i] = minutes[i - 1] < 1439 ? minutes[i - 1] + 1u : 1439u;
+    }
+}
+
+// The WEEKLY rules, Sunday first; false (out untouched) if there are none.
+static inline bool pray3_get_weekly(const pray2_header_t* h, pray3_weekly_t out[7]) {
+    uint8_t q[PRAY3_WEEKLY_SIZE];
+    if (!h || !h->sec_size[PRAY3_SEC_WEEKLY] || !pray_read(h, h->sec_off[PRAY3_SEC_WEEKLY], q, sizeof(q))) return false;
+    for (int i = 0; i < 7; ++i) {
+        const uint8_t* e = q + i * PRAY3_WEEKLY_ENTRY;
+        out[i].mask   = e[0];
+        out[i].mode   = e[1];
+        out[i].value  = (int16_t)pray2_rd_u16le(e + 2);
+        out[i].on_sec = pray2_rd_u16le(e + 4);
+    }
+    return true;
+}
+
+// Day of the week of a date (days since 1970, a Thursday): 0 Sunday .. 6 Saturday
+static inline int pray2_weekday(int32_t date) {
+    return (int)(((date % 7) + 11) % 7);
+}
+
 // Compute day index (0..days-1) from a local Y/M/D, or -1 if outside span.
-static int pray2_compute_day_index(const pray2_header_t* h, int year, int month, int day) {
+static inline int pray2_compute_day_index(const pray2_header_t* h, int year, int month, int day) {
     if (!h) return -1;
     int delta = pray2_days_between(h->year, h->start_month, h->start_day, year, month, day);
     if (delta < 0 || delta >= (int)h->days) return -1;
@@ -242,92 +709,140 @@ static int pray2_compute_day_index(const pray2_header_t* h, int year, int month,
 }
 
 // ===== Scheduler context =====
+
+// Times for a day the table does not hold (pray_calc on the device); false if
+// there are none. Called from pray2_sched_init_ex() and at each day change.
+typedef bool (*pray2_day_fn)(int year, int month, int day, uint16_t out_minutes[5]);
+
 typedef struct {
     bool           valid;        // parsed OK
     pray2_header_t H;            // header copy
     int            cur_day_idx;  // -1 if out of range / invalid
-    uint16_t       today_min[5]; // Fajr..Isha (minutes since midnight)
+    int32_t        cur_day;      // date of today_min, days since 1970
+    bool           have_today;   // today_min is set (table or day_fn)
+    pray2_day_fn   day_fn;       // days outside the table, or NULL
+    const pray2_header_t* ovr;   // OVERRIDES to apply: another file's (not owned), else H's own
+    pray3_weekly_t weekly[7];    // the file's WEEKLY rules (ovr's, else H's), all 0 if none
+    const pray3_weekly_t* weekly_dev;  // the device's seven rules (not owned), or NULL
+    uint16_t       today_min[5]; // Fajr..Isha (minutes since midnight), overrides applied
+    uint16_t       today_on[5];  // relay seconds for today_min
+    uint8_t        today_on_set; // prayers whose today_on a rule or override set (bit 0 Fajr)
     uint8_t        next_cursor;  // 0..5 (next prayer to watch)
     int            prev_min;     // last minutes since midnight (-1 initially)
 } pray2_sched_t;
 
-// Initialize scheduler from RAM blob + current RTC string.
-// Returns true if valid & in-range; false if file invalid (scheduler will no-op).
-static bool pray2_sched_init_from_ram(pray2_sched_t* ctx,
-                                      const uint8_t* buf, size_t len,
-                                      const char rtc_str17[17])
+// Load today's times (table, else day_fn) with the weekday's rule and the
+// day's overrides, and watch the first prayer >= now. The only place rules and
+// overrides are looked up: a tick costs the same with or without them.
+static inline void pray2_sched_load_day(pray2_sched_t* ctx, int year, int month, int day, int now_min)
+{
+    const int idx = pray2_compute_day_index(&ctx->H, year, month, day);
+    ctx->cur_day_idx = idx;
+    ctx->cur_day = (int32_t)pray2_days_from_civil(year, (unsigned)month, (unsigned)day);
+    APP_TRACE_MARK(PRAY2_DAY, idx);
+    ctx->next_cursor = 5; // default (no upcoming)
+
+    if (idx >= 0) {
+        ctx->have_today = pray2_get_day_minutes(&ctx->H, (uint16_t)idx, ctx->today_min);
+    } else {
+        ctx->have_today = ctx->day_fn && ctx->day_fn(year, month, day, ctx->today_min);
+    }
+    memcpy(ctx->today_on, ctx->H.default_on_sec, sizeof(ctx->today_on));
+    ctx->today_on_set = 0;
+    if (ctx->have_today) {
+        // The device's rule for the weekday, else the file's; then the dates'
+        const int wd = pray2_weekday(ctx->cur_day);
+        const pray3_weekly_t* w = ctx->weekly_dev && ctx->weekly_dev[wd].mask ? &ctx->weekly_dev[wd]
+                                                                               : &ctx->weekly[wd];
+        pray3_override_t o[1 + PRAY3_OVR_MAX];
+        int n = 0;
+        if (w->mask) {
+            o[n++] = (pray3_override_t){ .mask = w->mask, .mode = w->mode, .value = w->value, .on_sec = w->on_sec };
+        }
+        n += pray3_find_overrides(ctx->ovr ? ctx->ovr : &ctx->H, ctx->cur_day, o + n, PRAY3_OVR_MAX);
+        if (n > 0) {
+            APP_TRACE_MARK(PRAY2_OVR, (uint32_t)n);
+            pray3_apply_overrides(o, n, ctx->today_min, ctx->today_on);
+        }
+        for (int k = 0; k < n; ++k) {
+            if (o[k].on_sec) ctx->today_on_set |= o[k].mask & 0x1Fu;
+        }
+
+        // Choose the first prayer >= now
+        uint8_t nc = 5;
+        for (uint8_t i = 0; i < 5; ++i) {
+            if ((int)ctx->today_min[i] >= now_min) { nc = i; break; }
+        }
+        ctx->next_cursor = nc;
+    }
+}
+
+// Initialize scheduler from an already validated header and a time snapshot.
+// No parsing and no RTC access. day_fn (may be NULL) supplies the days outside
+// the span; ovr (may be NULL) is an overrides-only file to use instead of H's
+// own OVERRIDES (and WEEKLY, if it has them) and must outlive the scheduler.
+// weekly_dev (may be NULL) is seven weekday rules, Sunday first; a rule with a
+// mask replaces the file's for that weekday. It is read at each day change, so
+// it must outlive the scheduler too and edits apply from the next day. Returns
+// true if the scheduler has times for today.
+static inline bool pray2_sched_init_ex(pray2_sched_t* ctx, const pray2_header_t* H,
+                                       const pray2_time_t* now, pray2_day_fn day_fn,
+                                       const pray2_header_t* ovr, const pray3_weekly_t* weekly_dev)
 {
     if (!ctx) return false;
     memset(ctx, 0, sizeof(*ctx));
     ctx->prev_min = -1;
+    ctx->cur_day_idx = -1;
+    if (!H || !now) return false;
 
-    pray2_status_t st = pray2_validate_and_parse_no_crc(buf, len, &ctx->H);
-    if (st != PRAY2_OK) {
-        ctx->valid = false;
-        ctx->cur_day_idx = -1;
-        print_uart("pray2 err: parse\r\n");
-        return false;
-    }
+    ctx->H = *H;
     ctx->valid = true;
+    ctx->day_fn = day_fn;
+    ctx->ovr = ovr;
+    ctx->weekly_dev = weekly_dev;
+    if (!pray3_get_weekly(ovr, ctx->weekly)) (void)pray3_get_weekly(H, ctx->weekly);
 
-    // If one-shot flag set, set RTC from header ascii and clear the flag in the stored blob.
-    if (ctx->H.flags & PRAY2_FLAG_RTC_ONE_SHOT) {
-        int hh, mm, ss, DD, MO, YYYY;
-        if (pray2_parse_rtc_ascii(ctx->H.rtc_ascii, &hh,&mm,&ss,&DD,&MO,&YYYY)) {
-            char setbuf[18];
-            // Ensure slash format exactly: "HH:MM:SS|DD/MM/YY"
-            snprintf(setbuf, sizeof(setbuf), "%02d:%02d:%02d|%02d/%02d/%02d",
-                     hh, mm, ss, DD, MO, YYYY % 100);
-            RTCmcp7940_set_datetime(RTC_MCP, setbuf);
-
-            // Clear the flag in the RAM blob (header byte at offset 14)
-            ((uint8_t*)buf)[14] = (uint8_t)(((uint8_t*)buf)[14] & ~(PRAY2_FLAG_RTC_ONE_SHOT));
-            ctx->H.flags &= ~(PRAY2_FLAG_RTC_ONE_SHOT);
-
-            print_uart("RTC set from file (one-shot) and flag cleared\r\n");
-        } else {
-            print_uart("pray2 warn: header RTC parse failed; skipping RTC set\r\n");
-        }
-    }
+    const int now_min = now->hh * 60 + now->mm;
+    pray2_sched_load_day(ctx, now->YYYY, now->MO, now->DD, now_min);
+    ctx->prev_min = now_min;
+    return ctx->have_today;
+}
 
-    // Use the actual RTC for scheduler init.
-    char nowrtc[18] = {0};
-    RTCmcp7940_get_datetime(RTC_MCP, nowrtc);  // "HH:MM:SS|DD/MM/YY"
+// Same, file only: returns true if `now` falls inside the span.
+static inline bool pray2_sched_init(pray2_sched_t* ctx, const pray2_header_t* H, const pray2_time_t* now)
+{
+    return pray2_sched_init_ex(ctx, H, now, NULL, NULL, NULL);
+}
 
-    int hh, mm, ss, DD, MO, YYYY;
-    if (!pray2_parse_rtc_ascii(nowrtc[0] ? nowrtc : rtc_str17, &hh,&mm,&ss,&DD,&MO,&YYYY)) {
+// Initialize scheduler from RAM blob + current RTC string (parses both once).
+// Returns true if valid & in-range; false if file invalid (scheduler will no-op).
+static inline bool pray2_sched_init_from_ram(pray2_sched_t* ctx,
+                                      const uint8_t* buf, size_t len,
+                                      const char rtc_str17[17])
+{
+    pray2_header_t H;
+    pray2_time_t now;
+
+    if (!ctx) return false;
+    if (pray2_validate_and_parse_no_crc(buf, len, &H) != PRAY2_OK) {
+        memset(ctx, 0, sizeof(*ctx));
         ctx->cur_day_idx = -1;
-        print_uart("pray2 err: RTC ascii\r\n");
+        print_uart("pray2 err: parse\r\n");
         return false;
     }
-    const int now_min = hh * 60 + mm;
-
-    const int idx = pray2_compute_day_index(&ctx->H, YYYY, MO, DD);
-    ctx->cur_day_idx = idx;
-    ctx->next_cursor = 5; // default (no upcoming)
-
-    if (idx >= 0) {
-        if (pray2_get_day_minutes(&ctx->H, (uint16_t)idx, ctx->today_min)) {
-            // Choose the first prayer >= now
-            uint8_t nc = 5;
-            for (uint8_t i = 0; i < 5; ++i) {
-                if ((int)ctx->today_min[i] >= now_min) { nc = i; break; }
-            }
-            ctx->next_cursor = nc;
-        }
+    if (!pray2_time_parse(rtc_str17, &now)) {
+        memset(ctx, 0, sizeof(*ctx));
+        ctx->cur_day_idx = -1;
+        print_uart("pray2 err: RTC ascii\r\n");
+        return false;
     }
-
-    char localbuf[40];
-    snprintf(localbuf, sizeof(localbuf), "pray2 IDX: %d\r\n", idx);
-    print_uart(localbuf);
-
-    ctx->prev_min = now_min;
-    return (idx >= 0);
+    return pray2_sched_init(ctx, &H, &now);
 }
 
 // 1 Hz tick. Returns true only when a prayer should fire *now*.
-// On fire: *out_prayer is 0..4 (Fajr..Isha), *out_on_sec from header default_on_sec[*].
-static bool pray2_sched_tick(pray2_sched_t* ctx,
+// On fire: *out_prayer is 0..4 (Fajr..Isha), *out_on_sec the header's default_on_sec[*]
+// or the day's override.
+static inline bool pray2_sched_tick(pray2_sched_t* ctx,
                              const char rtc_str17[17],
                              int* out_prayer, uint16_t* out_on_sec)
 {
@@ -338,17 +853,8 @@ static bool pray2_sched_tick(pray2_sched_t* ctx,
     const int now_min = hh*60 + mm;
 
     // Day change?
-    int idx = pray2_compute_day_index(&ctx->H, YYYY, MO, DD);
-    if (idx != ctx->cur_day_idx) {
-        ctx->cur_day_idx = idx;
-        ctx->next_cursor = 5;
-        if (idx >= 0 && pray2_get_day_minutes(&ctx->H, (uint16_t)idx, ctx->today_min)) {
-            uint8_t nc = 5;
-            for (uint8_t i = 0; i < 5; ++i) {
-                if ((int)ctx->today_min[i] >= now_min) { nc = i; break; }
-            }
-            ctx->next_cursor = nc;
-        }
+    if ((int32_t)pray2_days_from_civil(YYYY, (unsigned)MO, (unsigned)DD) != ctx->cur_day) {
+        pray2_sched_load_day(ctx, YYYY, MO, DD, now_min);
         ctx->prev_min = now_min;
         return false; // do not fire on the exact minute of day rollover
     }
@@ -358,21 +864,24 @@ static bool pray2_sched_tick(pray2_sched_t* ctx,
     const int prev = ctx->prev_min;
     ctx->prev_min = now_min;
 
-    if (ctx->cur_day_idx < 0 || ctx->next_cursor >= 5) return false;
+    if (!ctx->have_today || ctx->next_cursor >= 5) return false;
 
     // POLICY A: if multiple events were skipped, fire only the earliest missed once.
     uint8_t i = ctx->next_cursor;
     if ((int)ctx->today_min[i] <= now_min) {
         // Fire if it is exactly now, or if it was missed in (prev..now].
         if ((int)ctx->today_min[i] > prev) {
+            APP_TRACE_MARK(PRAY2_FIRE, (uint32_t)i << 16 | ctx->today_min[i]);
+            if ((int)ctx->today_min[i] < now_min) APP_CNT_INC(LATE_FIRES);
             if (out_prayer)  *out_prayer = i;
-            if (out_on_sec)  *out_on_sec = ctx->H.default_on_sec[i];
+            if (out_on_sec)  *out_on_sec = ctx->today_on[i];
             ctx->next_cursor = (i+1u);
             return true;
         } else {
             // It was already <= prev (very large jump), advance cursor and do not fire now.
             while (ctx->next_cursor < 5 && (int)ctx->today_min[ctx->next_cursor] <= now_min) {
                 ctx->next_cursor++;
+                APP_CNT_INC(MISSED_EVENTS);
             }
             return false;
         }
@@ -380,14 +889,24 @@ static bool pray2_sched_tick(pray2_sched_t* ctx,
     return false;
 }
 
+// Relay time in ms for a prayer of today that pray2_sched_tick() fired. relay_ms
+// (0 = none) replaces the file's on_sec, not one a weekday rule or an override
+// set for the day.
+static inline uint32_t pray2_sched_relay_ms(const pray2_sched_t* ctx, int prayer, uint32_t relay_ms)
+{
+    if (!ctx || prayer < 0 || prayer > 4) return relay_ms;
+    if (relay_ms && !(ctx->today_on_set & (1u << prayer))) return relay_ms;
+    return (uint32_t)ctx->today_on[prayer] * 1000u;
+}
+
 
 
 
 // ---- core dumper: print one specific YEAR+MONTH ----
-static void debug_print_month_from_bin(const uint8_t *file_buf, size_t file_len,
+static inline void debug_print_month_from_bin(const uint8_t *file_buf, size_t file_len,
                                 int target_year, int target_month)
 {
-    char line[200];
+    char line[96];  // longest is a day row, 77 chars
     if (target_month < 1 || target_month > 12) {
         snprintf(line, sizeof(line), "Month %d invalid (1-12)\r\n", target_month);
         print_uart(line);
@@ -447,25 +966,17 @@ static void debug_print_month_from_bin(const uint8_t *file_buf, size_t file_len,
     }
 }
 
-// ---- convenience wrapper: print ALL occurrences of a month across the span ----
-static void debug_print_month_any_year(const uint8_t *file_buf, size_t file_len,
-                                int target_month)
+// ---- print ALL occurrences of a month across the span of a parsed header ----
+static inline void debug_print_month_from_header(const pray2_header_t *hdr, int target_month)
 {
-    char line[200];
+    char line[96];
     if (target_month < 1 || target_month > 12) {
         snprintf(line, sizeof(line), "Month %d invalid (1-12)\r\n", target_month);
         print_uart(line);
         return;
     }
 
-    pray2_header_t H;
-    pray2_status_t st = pray2_validate_and_parse_no_crc(file_buf, file_len, &H);
-    if (st != PRAY2_OK) {
-        snprintf(line, sizeof(line), "PRAY2 parse error %d\r\n", (int)st);
-        print_uart(line);
-        return;
-    }
-
+    const pray2_header_t H = *hdr;
     int y = H.year, m = H.start_month, d = H.start_day;
     int printed = 0;
 
@@ -514,4 +1025,19 @@ static void debug_print_month_any_year(const uint8_t *file_buf, size_t file_len,
     }
 }
 
+// ---- convenience wrapper: same, straight from a blob ----
+static inline void debug_print_month_any_year(const uint8_t *file_buf, size_t file_len,
+                                int target_month)
+{
+    pray2_header_t H;
+    pray2_status_t st = pray2_validate_and_parse_no_crc(file_buf, file_len, &H);
+    if (st != PRAY2_OK) {
+        char line[40];
+        snprintf(line, sizeof(line), "PRAY2 parse error %d\r\n", (int)st);
+        print_uart(line);
+        return;
+    }
+    debug_print_month_from_header(&H, target_month);
+}
+
 #endif // PRAY2_SCHED_H
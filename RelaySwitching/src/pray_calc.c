@@ -0,0 +1,535 @@
+// pray_calc.c — see pray_calc.h
+//
+// Follows adhanpy (astronomy/Astronomical.py, SolarCoordinates.py,
+// SolarTime.py and PrayerTimes.py) step by step, including its rounding, so
+// the two can be compared line by line. Angles are in degrees throughout.
+#include "pray_calc.h"
+#include <math.h>
+#include <stddef.h>
+
+#define TAB_N 256  // table steps per quarter turn, and per unit of atan's argument
+
+#define PI_F        3.14159265f
+#define HALF_PI_F   1.57079633f
+#define DEG_PER_RAD 57.2957795f
+#define STEP_RAD    ((float)(1.5707963267948966 / TAB_N))
+
+// sin(i · 90° / TAB_N):
+//   python3 -c "import math; print([math.sin(i*math.pi/512) for i in range(257)])"
+static const float sin_tab[TAB_N + 1] = {
+    0.0f, 0.00613588465f, 0.0122715383f, 0.0184067299f, 0.0245412285f, 0.0306748032f,
+    0.0368072229f, 0.0429382569f, 0.0490676743f, 0.0551952443f, 0.0613207363f, 0.0674439196f,
+    0.0735645636f, 0.079682438f, 0.0857973123f, 0.0919089565f, 0.0980171403f, 0.104121634f,
+    0.110222207f, 0.116318631f, 0.122410675f, 0.128498111f, 0.134580709f, 0.140658239f,
+    0.146730474f, 0.152797185f, 0.158858143f, 0.16491312f, 0.170961889f, 0.17700422f, 0.183039888f,
+    0.189068664f, 0.195090322f, 0.201104635f, 0.207111376f, 0.21311032f, 0.21910124f, 0.225083911f,
+    0.231058108f, 0.237023606f, 0.24298018f, 0.248927606f, 0.25486566f, 0.260794118f, 0.266712757f,
+    0.272621355f, 0.278519689f, 0.284407537f, 0.290284677f, 0.296150888f, 0.302005949f,
+    0.30784964f, 0.31368174f, 0.319502031f, 0.325310292f, 0.331106306f, 0.336889853f, 0.342660717f,
+    0.34841868f, 0.354163525f, 0.359895037f, 0.365612998f, 0.371317194f, 0.37700741f, 0.382683432f,
+    0.388345047f, 0.39399204f, 0.3996242f, 0.405241314f, 0.410843171f, 0.41642956f, 0.422000271f,
+    0.427555093f, 0.433093819f, 0.438616239f, 0.444122145f, 0.44961133f, 0.455083587f,
+    0.460538711f, 0.465976496f, 0.471396737f, 0.47679923f, 0.482183772f, 0.48755016f, 0.492898192f,
+    0.498227667f, 0.503538384f, 0.508830143f, 0.514102744f, 0.51935599f, 0.524589683f,
+    0.529803625f, 0.53499762f, 0.540171473f, 0.545324988f, 0.550457973f, 0.555570233f,
+    0.560661576f, 0.565731811f, 0.570780746f, 0.575808191f, 0.580813958f, 0.585797857f,
+    0.590759702f, 0.595699304f, 0.600616479f, 0.605511041f, 0.610382806f, 0.615231591f,
+    0.620057212f, 0.624859488f, 0.629638239f, 0.634393284f, 0.639124445f, 0.643831543f,
+    0.648514401f, 0.653172843f, 0.657806693f, 0.662415778f, 0.666999922f, 0.671558955f,
+    0.676092704f, 0.680600998f, 0.685083668f, 0.689540545f, 0.693971461f, 0.698376249f,
+    0.702754744f, 0.707106781f, 0.711432196f, 0.715730825f, 0.720002508f, 0.724247083f,
+    0.72846439f, 0.732654272f, 0.736816569f, 0.740951125f, 0.745057785f, 0.749136395f,
+    0.753186799f, 0.757208847f, 0.761202385f, 0.765167266f, 0.769103338f, 0.773010453f,
+    0.776888466f, 0.780737229f, 0.784556597f, 0.788346428f, 0.792106577f, 0.795836905f,
+    0.799537269f, 0.803207531f, 0.806847554f, 0.810457198f, 0.81403633f, 0.817584813f,
+    0.821102515f, 0.824589303f, 0.828045045f, 0.831469612f, 0.834862875f, 0.838224706f,
+    0.841554977f, 0.844853565f, 0.848120345f, 0.851355193f, 0.854557988f, 0.85772861f,
+    0.860866939f, 0.863972856f, 0.867046246f, 0.870086991f, 0.873094978f, 0.876070094f,
+    0.879012226f, 0.881921264f, 0.884797098f, 0.88763962f, 0.890448723f, 0.893224301f, 0.89596625f,
+    0.898674466f, 0.901348847f, 0.903989293f, 0.906595705f, 0.909167983f, 0.911706032f,
+    0.914209756f, 0.91667906f, 0.919113852f, 0.921514039f, 0.923879533f, 0.926210242f, 0.92850608f,
+    0.930766961f, 0.932992799f, 0.93518351f, 0.937339012f, 0.939459224f, 0.941544065f,
+    0.943593458f, 0.945607325f, 0.947585591f, 0.949528181f, 0.951435021f, 0.95330604f,
+    0.955141168f, 0.956940336f, 0.958703475f, 0.960430519f, 0.962121404f, 0.963776066f,
+    0.965394442f, 0.966976471f, 0.968522094f, 0.970031253f, 0.971503891f, 0.972939952f,
+    0.974339383f, 0.97570213f, 0.977028143f, 0.978317371f, 0.979569766f, 0.98078528f, 0.981963869f,
+    0.983105487f, 0.984210092f, 0.985277642f, 0.986308097f, 0.987301418f, 0.988257568f,
+    0.98917651f, 0.99005821f, 0.990902635f, 0.991709754f, 0.992479535f, 0.993211949f, 0.99390697f,
+    0.994564571f, 0.995184727f, 0.995767414f, 0.996312612f, 0.996820299f, 0.997290457f,
+    0.997723067f, 0.998118113f, 0.998475581f, 0.998795456f, 0.999077728f, 0.999322385f,
+    0.999529418f, 0.999698819f, 0.999830582f, 0.999924702f, 0.999981175f, 1.0f};
+
+// atan(i / TAB_N), radians:
+//   python3 -c "import math; print([math.atan(i/256) for i in range(257)])"
+static const float atan_tab[TAB_N + 1] = {
+    0.0f, 0.00390623013f, 0.00781234106f, 0.0117182136f, 0.0156237286f, 0.019528767f,
+    0.0234332099f, 0.0273369383f, 0.0312398334f, 0.0351417768f, 0.03904265f, 0.0429423347f,
+    0.0468407129f, 0.0507376669f, 0.0546330792f, 0.0585268326f, 0.06241881f, 0.0663088949f,
+    0.0701969711f, 0.0740829225f, 0.0779666338f, 0.0818479898f, 0.0857268758f, 0.0896031775f,
+    0.0934767812f, 0.0973475735f, 0.101215442f, 0.105080273f, 0.108941957f, 0.112800381f,
+    0.116655435f, 0.12050701f, 0.124354995f, 0.128199281f, 0.132039762f, 0.135876328f,
+    0.139708874f, 0.143537294f, 0.147361481f, 0.151181332f, 0.154996742f, 0.158807608f,
+    0.162613829f, 0.166415301f, 0.170211925f, 0.174003601f, 0.177790229f, 0.181571711f,
+    0.18534795f, 0.189118849f, 0.192884312f, 0.196644245f, 0.200398554f, 0.204147145f,
+    0.207889927f, 0.211626809f, 0.2153577f, 0.219082511f, 0.222801154f, 0.226513541f, 0.230219587f,
+    0.233919206f, 0.237612314f, 0.241298827f, 0.244978663f, 0.248651741f, 0.252317981f,
+    0.255977303f, 0.259629629f, 0.263274883f, 0.266912988f, 0.270543868f, 0.274167451f,
+    0.277783663f, 0.281392433f, 0.284993689f, 0.288587362f, 0.292173383f, 0.295751686f,
+    0.299322203f, 0.302884868f, 0.306439619f, 0.309986391f, 0.313525123f, 0.317055753f,
+    0.320578222f, 0.32409247f, 0.327598441f, 0.331096077f, 0.334585322f, 0.338066123f,
+    0.341538425f, 0.345002177f, 0.348457327f, 0.351903825f, 0.355341622f, 0.35877067f,
+    0.362190922f, 0.365602332f, 0.369004855f, 0.372398447f, 0.375783065f, 0.379158669f,
+    0.382525217f, 0.385882669f, 0.389230988f, 0.392570135f, 0.395900074f, 0.39922077f,
+    0.402532187f, 0.405834293f, 0.409127055f, 0.412410442f, 0.415684422f, 0.418948967f,
+    0.422204048f, 0.425449637f, 0.428685708f, 0.431912235f, 0.435129194f, 0.43833656f,
+    0.441534311f, 0.444722424f, 0.447900879f, 0.451069656f, 0.454228735f, 0.457378099f,
+    0.460517729f, 0.463647609f, 0.466767724f, 0.469878058f, 0.472978598f, 0.47606933f,
+    0.479150243f, 0.482221324f, 0.485282564f, 0.488333951f, 0.491375478f, 0.494407135f,
+    0.497428916f, 0.500440813f, 0.503442821f, 0.506434934f, 0.509417149f, 0.51238946f,
+    0.515351866f, 0.518304364f, 0.521246951f, 0.524179629f, 0.527102395f, 0.530015251f,
+    0.532918198f, 0.535811238f, 0.538694373f, 0.541567605f, 0.54443094f, 0.547284381f,
+    0.550127933f, 0.552961602f, 0.555785394f, 0.558599315f, 0.561403374f, 0.564197577f,
+    0.566981934f, 0.569756453f, 0.572521145f, 0.575276018f, 0.578021084f, 0.580756354f,
+    0.583481839f, 0.586197551f, 0.588903504f, 0.59159971f, 0.594286183f, 0.596962937f,
+    0.599629987f, 0.602287346f, 0.604935031f, 0.607573058f, 0.610201443f, 0.612820202f,
+    0.615429353f, 0.618028912f, 0.620618899f, 0.62319933f, 0.625770225f, 0.628331602f,
+    0.630883482f, 0.633425883f, 0.635958826f, 0.63848233f, 0.640996418f, 0.643501109f,
+    0.645996425f, 0.648482388f, 0.650959019f, 0.653426341f, 0.655884377f, 0.658333148f,
+    0.660772679f, 0.663202993f, 0.665624112f, 0.668036062f, 0.670438866f, 0.672832548f,
+    0.675217133f, 0.677592646f, 0.679959111f, 0.682316555f, 0.684665002f, 0.687004478f,
+    0.68933501f, 0.691656622f, 0.693969341f, 0.696273194f, 0.698568208f, 0.700854408f,
+    0.703131822f, 0.705400477f, 0.7076604f, 0.709911618f, 0.71215416f, 0.714388052f, 0.716613323f,
+    0.71883f, 0.721038111f, 0.723237685f, 0.725428749f, 0.727611333f, 0.729785464f, 0.731951171f,
+    0.734108483f, 0.736257429f, 0.738398037f, 0.740530337f, 0.742654356f, 0.744770126f,
+    0.746877674f, 0.748977029f, 0.751068222f, 0.753151281f, 0.755226236f, 0.757293116f,
+    0.759351951f, 0.76140277f, 0.763445603f, 0.765480479f, 0.767507428f, 0.76952648f, 0.771537665f,
+    0.773541012f, 0.77553655f, 0.77752431f, 0.779504322f, 0.781476615f, 0.783441219f, 0.785398163f};
+
+// ---- trigonometry ----
+
+// sin and cos of an angle in degrees: the nearest table step, then a
+// second-order Taylor step over the rest (at most half a step, error < 5e-9).
+// Callers keep |deg| within a few turns so the float remainder stays exact.
+static void sincos_deg(float deg, float *s, float *c)
+{
+    const float x = deg * (TAB_N / 90.0f);
+    const float k = floorf(x + 0.5f);
+    const float dx = (x - k) * STEP_RAD;
+    const uint32_t i = (uint32_t)(int32_t)k & (4u * TAB_N - 1u);
+    const uint32_t j = i % TAB_N;
+    float s0, c0;
+
+    switch (i / TAB_N) {
+    case 0:  s0 = sin_tab[j];          c0 = sin_tab[TAB_N - j];  break;
+    case 1:  s0 = sin_tab[TAB_N - j];  c0 = -sin_tab[j];         break;
+    case 2:  s0 = -sin_tab[j];         c0 = -sin_tab[TAB_N - j]; break;
+    default: s0 = -sin_tab[TAB_N - j]; c0 = sin_tab[j];          break;
+    }
+    const float h = 1.0f - 0.5f * dx * dx;
+    *s = s0 * h + c0 * dx;
+    *c = c0 * h - s0 * dx;
+}
+
+static float sin_deg(float deg)
+{
+    float s, c;
+    sincos_deg(deg, &s, &c);
+    return s;
+}
+
+static float cos_deg(float deg)
+{
+    float s, c;
+    sincos_deg(deg, &s, &c);
+    return c;
+}
+
+// atan(t) in radians for t in [0, 1]: table step plus a second-order step
+static float atan_unit(float t)
+{
+    const int i = (int)(t * TAB_N + 0.5f);
+    const float t0 = (float)i * (1.0f / TAB_N);
+    const float h = t - t0;
+    const float g = 1.0f / (1.0f + t0 * t0);
+    return atan_tab[i] + h * g * (1.0f - t0 * h * g);
+}
+
+static float atan2_deg(float y, float x)
+{
+    const float ay = fabsf(y), ax = fabsf(x);
+    float a;
+
+    if (ay <= ax) {
+        a = (ax > 0.0f) ? atan_unit(ay / ax) : 0.0f;
+    } else {
+        a = HALF_PI_F - atan_unit(ax / ay);
+    }
+    if (x < 0.0f) a = PI_F - a;
+    return (y < 0.0f ? -a : a) * DEG_PER_RAD;
+}
+
+// asin and acos fail (return false) outside [-1, 1], where Python raises
+static bool asin_deg(float v, float *out)
+{
+    if (!(v >= -1.0f && v <= 1.0f)) return false;
+    *out = atan2_deg(v, sqrtf((1.0f - v) * (1.0f + v)));
+    return true;
+}
+
+static bool acos_deg(float v, float *out)
+{
+    if (!(v >= -1.0f && v <= 1.0f)) return false;
+    *out = atan2_deg(sqrtf((1.0f - v) * (1.0f + v)), v);
+    return true;
+}
+
+// ---- FloatUtil ----
+
+static float unwind(float deg)
+{
+    return deg - 360.0f * floorf(deg * (1.0f / 360.0f));
+}
+
+static float closest_angle(float deg)
+{
+    if (deg >= -180.0f && deg <= 180.0f) return deg;
+    return deg - 360.0f * floorf(deg * (1.0f / 360.0f) + 0.5f);
+}
+
+static int32_t floor_div(int32_t a, int32_t b)
+{
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+static int32_t floor_mod(int32_t a, int32_t b)
+{
+    return a - floor_div(a, b) * b;
+}
+
+// ---- calendar ----
+
+static bool is_leap_year(int y)
+{
+    return (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0);
+}
+
+// Days from 2000-01-01 (proleptic Gregorian)
+static int32_t days_from_2000(int y, int m, int d)
+{
+    y -= m <= 2;
+    const int32_t era = (y >= 0 ? y : y - 399) / 400;
+    const int32_t yoe = y - era * 400;
+    const int32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 730425;
+}
+
+// ---- SolarCoordinates ----
+
+// unwind(c + k·d), d = n - 0.5 days from J2000.0 to 0h UT of day n, k = ki + kf
+// degrees a day. A float cannot hold k·d itself after a few years (360.98°/day
+// × 9000 days); the whole degrees ki·n go mod 360 in integers instead.
+static float day_angle(int32_t n, float c, int32_t ki, float kf)
+{
+    const int32_t whole = (ki * n) % 360;
+    return unwind(c + (float)whole + kf * (float)n);
+}
+
+// Rates in degrees per Julian century; the constants fold in d = n - 0.5
+#define DAY_ANGLE(n, c, per_century, ki)                                          \
+    day_angle((n), (float)((c) - (per_century) / 36525.0 / 2.0), (ki),            \
+              (float)((per_century) / 36525.0 - (ki)))
+
+struct solar {
+    float decl;  // declination
+    float ra;    // right ascension, 0..360
+    float gast;  // apparent sidereal time at Greenwich, not unwound
+};
+
+static void solar_coords(int32_t n, struct solar *out)
+{
+    const float T = ((float)n - 0.5f) * (1.0f / 36525.0f);
+    const float T2 = T * T, T3 = T2 * T;
+
+    const float L0 = unwind(DAY_ANGLE(n, 280.4664567, 36000.76983, 1) + 0.0003032f * T2);
+    const float Lp = DAY_ANGLE(n, 218.3165, 481267.8813, 13);
+    const float om = unwind(DAY_ANGLE(n, 125.04452, -1934.136261, 0) + 0.0020708f * T2 +
+                            T3 / 450000.0f);
+    const float M = unwind(DAY_ANGLE(n, 357.52911, 35999.05029, 1) - 0.0001537f * T2);
+    const float om_app = DAY_ANGLE(n, 125.04, -1934.136, 0);  // Ω as rounded in λ and ε
+
+    const float C = (1.914602f - 0.004817f * T - 0.000014f * T2) * sin_deg(M) +
+                    (0.019993f - 0.000101f * T) * sin_deg(2.0f * M) +
+                    0.000289f * sin_deg(3.0f * M);
+    const float lambda = unwind(L0 + C - 0.00569f - 0.00478f * sin_deg(om_app));
+    const float theta0 = unwind(DAY_ANGLE(n, 280.46061837, 360.98564736629 * 36525.0, 361) +
+                                0.000387933f * T2 - T3 / 38710000.0f);
+
+    float s_om, c_om, s_2L0, c_2L0, s_2Lp, c_2Lp, s_2om, c_2om;
+    sincos_deg(om, &s_om, &c_om);
+    sincos_deg(2.0f * L0, &s_2L0, &c_2L0);
+    sincos_deg(2.0f * Lp, &s_2Lp, &c_2Lp);
+    sincos_deg(2.0f * om, &s_2om, &c_2om);
+    const float dpsi = (-17.2f / 3600.0f) * s_om - (1.32f / 3600.0f) * s_2L0 -
+                       (0.23f / 3600.0f) * s_2Lp + (0.21f / 3600.0f) * s_2om;
+    const float deps = (9.2f / 3600.0f) * c_om + (0.57f / 3600.0f) * c_2L0 +
+                       (0.10f / 3600.0f) * c_2Lp - (0.09f / 3600.0f) * c_2om;
+    const float eps0 = 23.439291f - 0.013004167f * T - 0.0000001639f * T2 + 0.0000005036f * T3;
+    const float eps = eps0 + 0.00256f * cos_deg(om_app);
+
+    float s_l, c_l, s_e, c_e;
+    sincos_deg(lambda, &s_l, &c_l);
+    sincos_deg(eps, &s_e, &c_e);
+    (void)asin_deg(s_e * s_l, &out->decl);  // |sin ε sin λ| < 0.4
+    out->ra = unwind(atan2_deg(c_e * s_l, c_l));
+    out->gast = theta0 + dpsi * cos_deg(eps0 + deps);
+}
+
+// ---- SolarTime ----
+
+#define SUN_ALTITUDE (-50.0f / 60.0f)  // refraction and the sun's semi-diameter
+
+struct solar_time {
+    float lat;
+    float lw;                         // west longitude
+    const struct solar *s1, *s2, *s3; // previous day, the day, next day
+    float m0;                         // approximate transit, fraction of the day
+};
+
+static void solar_time_init(struct solar_time *st, float lat, float lon, const struct solar s[3])
+{
+    st->lat = lat;
+    st->lw = -lon;
+    st->s1 = &s[0];
+    st->s2 = &s[1];
+    st->s3 = &s[2];
+    const float m0 = (s[1].ra + st->lw - s[1].gast) * (1.0f / 360.0f);
+    st->m0 = m0 - floorf(m0);
+}
+
+static float interpolate(float y2, float y1, float y3, float n)
+{
+    const float a = y2 - y1, b = y3 - y2, c = b - a;
+    return y2 + (n / 2.0f) * (a + b + n * c);
+}
+
+static float interpolate_angles(float y2, float y1, float y3, float n)
+{
+    const float a = unwind(y2 - y1), b = unwind(y3 - y2), c = b - a;
+    return y2 + (n / 2.0f) * (a + b + n * c);
+}
+
+// Transit, as a fraction of the UTC day
+static float corrected_transit(const struct solar_time *st)
+{
+    const float theta = unwind(st->s2->gast + 360.985647f * st->m0);
+    const float alpha = unwind(interpolate_angles(st->s2->ra, st->s1->ra, st->s3->ra, st->m0));
+    const float H = closest_angle(theta - st->lw - alpha);
+    return st->m0 - H * (1.0f / 360.0f);
+}
+
+// When the sun is at altitude h0 before or after transit; false if never
+static bool corrected_hour_angle(const struct solar_time *st, float h0, bool after_transit,
+                                 float *out)
+{
+    float s_lat, c_lat, s_d2, c_d2;
+    sincos_deg(st->lat, &s_lat, &c_lat);
+    sincos_deg(st->s2->decl, &s_d2, &c_d2);
+
+    const float term2 = c_lat * c_d2;
+    float H0;
+    if (term2 == 0.0f || !acos_deg((sin_deg(h0) - s_lat * s_d2) / term2, &H0)) return false;
+
+    const float m = after_transit ? st->m0 + H0 * (1.0f / 360.0f) : st->m0 - H0 * (1.0f / 360.0f);
+    const float theta = unwind(st->s2->gast + 360.985647f * m);
+    const float alpha = unwind(interpolate_angles(st->s2->ra, st->s1->ra, st->s3->ra, m));
+    const float delta = interpolate(st->s2->decl, st->s1->decl, st->s3->decl, m);
+    const float H = theta - st->lw - alpha;
+
+    float s_d, c_d, s_H, c_H, h;
+    sincos_deg(delta, &s_d, &c_d);
+    sincos_deg(H, &s_H, &c_H);
+    if (!asin_deg(s_lat * s_d + c_lat * c_d * c_H, &h)) return false;
+    const float term4 = 360.0f * c_d * c_lat * s_H;
+    if (term4 == 0.0f) return false;
+    *out = m + (h - h0) / term4;
+    return true;
+}
+
+// TimeComponents: whole seconds from UTC midnight of the date, truncated
+static int32_t day_seconds(float day_fraction)
+{
+    return (int32_t)floorf(day_fraction * 86400.0f);
+}
+
+// ---- Twilight (Moonsighting Committee) ----
+
+static int days_since_solstice(int day_of_year, int year, float lat)
+{
+    const bool leap = is_leap_year(year);
+    const int days_in_year = leap ? 366 : 365;
+    int d;
+
+    if (lat >= 0.0f) {
+        d = day_of_year + 10;
+        if (d >= days_in_year) d -= days_in_year;
+    } else {
+        d = day_of_year - (leap ? 173 : 172);
+        if (d < 0) d += days_in_year;
+    }
+    return d;
+}
+
+// Seasonal twilight in seconds, from the a..d coefficients (minutes at
+// latitude 55) of season_adjusted_{morning,evening}_twilight
+static int32_t season_adjusted(const float k[4], float lat, int day_of_year, int year)
+{
+    const float alat = fabsf(lat) / 55.0f;
+    const float a = 75.0f + k[0] * alat, b = 75.0f + k[1] * alat;
+    const float c = 75.0f + k[2] * alat, d = 75.0f + k[3] * alat;
+    const int dyy = days_since_solstice(day_of_year, year, lat);
+    float adj;
+
+    if (dyy < 91) {
+        adj = a + (b - a) / 91.0f * (float)dyy;
+    } else if (dyy < 137) {
+        adj = b + (c - b) / 46.0f * (float)(dyy - 91);
+    } else if (dyy < 183) {
+        adj = c + (d - c) / 46.0f * (float)(dyy - 137);
+    } else if (dyy < 229) {
+        adj = d + (c - d) / 46.0f * (float)(dyy - 183);
+    } else if (dyy < 275) {
+        adj = c + (b - c) / 46.0f * (float)(dyy - 229);
+    } else {
+        adj = b + (a - b) / 91.0f * (float)(dyy - 275);
+    }
+    return (int32_t)floorf(adj * 60.0f + 0.5f);
+}
+
+static const float msc_morning[4] = {28.65f, 19.44f, 32.74f, 48.10f};
+static const float msc_evening[4] = {25.60f, 2.050f, -9.210f, 6.140f};
+
+// ---- PrayerTimes ----
+
+struct method {
+    float fajr_angle;
+    float isha_angle;
+    uint8_t isha_interval_min;
+    int8_t adj_min[PRAY_CALC_TIMES];  // method adjustments, added before rounding
+};
+
+// adhanpy's MethodsParameters for the generator's methods
+static const struct method methods[PRAY_METHOD_COUNT] = {
+    [PRAY_METHOD_KARACHI]                 = {18.0f, 18.0f, 0, {0, 0, 1, 0, 0, 0}},
+    [PRAY_METHOD_MUSLIM_WORLD_LEAGUE]     = {18.0f, 17.0f, 0, {0, 0, 1, 0, 0, 0}},
+    [PRAY_METHOD_EGYPTIAN]                = {19.5f, 17.5f, 0, {0, 0, 1, 0, 0, 0}},
+    [PRAY_METHOD_UMM_AL_QURA]             = {18.5f, 0.0f, 90, {0, 0, 0, 0, 0, 0}},
+    [PRAY_METHOD_MOON_SIGHTING_COMMITTEE] = {18.0f, 18.0f, 0, {0, 0, 5, 0, 3, 0}},
+    [PRAY_METHOD_NORTH_AMERICA]           = {15.0f, 15.0f, 0, {0, 0, 1, 0, 0, 0}},
+};
+
+// rounded_minute(): to the nearest minute with :30 rounding down; in the last
+// minute of an hour the seconds are dropped instead (no carry into the hour).
+static int32_t rounded_minute(int32_t sec)
+{
+    int32_t min = floor_div(sec, 60);
+    if (sec - min * 60 > 30 && floor_mod(min, 60) != 59) min++;
+    return min;
+}
+
+bool pray_calc_times(const struct pray_calc_params *p, int year, int month, int day,
+                     uint16_t out[PRAY_CALC_TIMES])
+{
+    if (!p || !out || p->method >= PRAY_METHOD_COUNT || month < 1 || month > 12 || day < 1 ||
+        day > 31) {
+        return false;
+    }
+    struct method m = methods[p->method];
+    if (p->method == PRAY_METHOD_CUSTOM) {
+        m.fajr_angle = p->fajr_angle;
+        m.isha_angle = p->isha_angle;
+        m.isha_interval_min = p->isha_interval_min;
+    }
+    const bool msc = p->method == PRAY_METHOD_MOON_SIGHTING_COMMITTEE;
+    const int32_t n = days_from_2000(year, month, day);
+    const int day_of_year = (int)(n - days_from_2000(year, 1, 1)) + 1;
+
+    // Yesterday..the day after tomorrow: today's times and tomorrow's sunrise
+    struct solar sc[4];
+    for (int i = 0; i < 4; i++) solar_coords(n - 1 + i, &sc[i]);
+    struct solar_time today, tomorrow;
+    solar_time_init(&today, p->lat, p->lon, &sc[0]);
+    solar_time_init(&tomorrow, p->lat, p->lon, &sc[1]);
+
+    float f;
+    const int32_t transit = day_seconds(corrected_transit(&today));
+    if (!corrected_hour_angle(&today, SUN_ALTITUDE, false, &f)) return false;
+    const int32_t sunrise = day_seconds(f);
+    if (!corrected_hour_angle(&today, SUN_ALTITUDE, true, &f)) return false;
+    const int32_t sunset = day_seconds(f);
+    if (!corrected_hour_angle(&tomorrow, SUN_ALTITUDE, false, &f)) return false;
+    const int32_t night = 86400 + day_seconds(f) - sunset;
+
+    // Asr: the shadow is asr_shadow times the object's height plus its noon shadow
+    const float inverse = (float)(p->asr_shadow ? p->asr_shadow : 1) +
+                          sin_deg(fabsf(p->lat - sc[1].decl)) / cos_deg(fabsf(p->lat - sc[1].decl));
+    if (inverse == 0.0f || !corrected_hour_angle(&today, atan2_deg(1.0f / inverse, 1.0f), true, &f)) {
+        return false;
+    }
+    const int32_t asr = day_seconds(f);
+
+    // Fajr and Isha never cross the middle of the night (MIDDLE_OF_THE_NIGHT),
+    // or the Moonsighting Committee's seasonal limits
+    bool have = corrected_hour_angle(&today, -m.fajr_angle, false, &f);
+    int32_t fajr = have ? day_seconds(f) : 0;
+    int32_t safe;
+    if (msc) {
+        if (p->lat >= 55.0f) {
+            fajr = sunrise - night / 7;
+            have = true;
+        }
+        safe = sunrise - season_adjusted(msc_morning, p->lat, day_of_year, year);
+    } else {
+        safe = sunrise - night / 2;
+    }
+    if (!have || fajr < safe) fajr = safe;
+
+    int32_t isha;
+    if (m.isha_interval_min) {
+        isha = sunset + (int32_t)m.isha_interval_min * 60;
+    } else {
+        have = corrected_hour_angle(&today, -m.isha_angle, true, &f);
+        isha = have ? day_seconds(f) : 0;
+        if (msc && p->lat >= 55.0f) {
+            isha = sunset + night / 7;
+            have = true;
+        }
+        safe = msc ? sunset + season_adjusted(msc_evening, p->lat, day_of_year, year)
+                   : sunset + night / 2;
+        if (!have || isha > safe) isha = safe;
+    }
+
+    const int32_t utc[PRAY_CALC_TIMES] = {fajr, sunrise, transit, asr, sunset, isha};
+    for (int i = 0; i < PRAY_CALC_TIMES; i++) {
+        const int32_t min = rounded_minute(utc[i] + (int32_t)m.adj_min[i] * 60);
+        out[i] = (uint16_t)floor_mod(min + p->utc_offset_min, 24 * 60);
+    }
+    return true;
+}
+
+bool pray_calc_day(const struct pray_calc_params *p, int year, int month, int day,
+                   uint16_t out_min[5])
+{
+    static const uint8_t row[5] = {PRAY_CALC_FAJR, PRAY_CALC_DHUHR, PRAY_CALC_ASR,
+                                   PRAY_CALC_MAGHRIB, PRAY_CALC_ISHA};
+    uint16_t t[PRAY_CALC_TIMES];
+
+    if (!out_min || !pray_calc_times(p, year, month, day, t)) return false;
+    for (int i = 0; i < 5; i++) {
+        out_min[i] = (uint16_t)floor_mod((int32_t)t[row[i]] + p->offset_min[i], 24 * 60);
+        if (i > 0 && out_min[i] <= out_min[i - 1]) {
+            out_min[i] = (out_min[i - 1] < 1439) ? out_min[i - 1] + 1 : 1439;
+        }
+    }
+    return true;
+}
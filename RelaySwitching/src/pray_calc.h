@@ -0,0 +1,63 @@
+// pray_calc.h — prayer times computed on the device
+//
+// The same solar-position and prayer-angle math the generator runs through
+// adhanpy on the PC (Meeus' low-precision sun, transit and hour-angle
+// corrections, the methods in its METHOD_CODE), so a day computed here gives
+// the generator's table row to the minute. Single-precision float only, with
+// table-based sine and arctangent: no double and no libm trig, so it runs on the
+// Cortex-M4F's FPU and builds unchanged on the host (tools/pray_calc).
+//
+// Fixed UTC offset: the generator's zone must not observe DST over the span.
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+// The generator's METHOD_CODE, also the PRAY2 header's method_code
+enum pray_calc_method {
+    PRAY_METHOD_CUSTOM = 0,               // fajr_angle / isha_angle / isha_interval_min
+    PRAY_METHOD_KARACHI = 1,              // 18° / 18°, Dhuhr +1
+    PRAY_METHOD_MUSLIM_WORLD_LEAGUE = 2,  // 18° / 17°, Dhuhr +1
+    PRAY_METHOD_EGYPTIAN = 3,             // 19.5° / 17.5°, Dhuhr +1
+    PRAY_METHOD_UMM_AL_QURA = 4,          // 18.5° / Maghrib + 90 min
+    PRAY_METHOD_MOON_SIGHTING_COMMITTEE = 5,  // 18° / 18°, seasonal limits, Dhuhr +5, Maghrib +3
+    PRAY_METHOD_NORTH_AMERICA = 6,        // 15° / 15°, Dhuhr +1
+    PRAY_METHOD_COUNT
+};
+
+// pray_calc_times() output order
+enum pray_calc_time {
+    PRAY_CALC_FAJR = 0,
+    PRAY_CALC_SUNRISE,
+    PRAY_CALC_DHUHR,
+    PRAY_CALC_ASR,
+    PRAY_CALC_MAGHRIB,
+    PRAY_CALC_ISHA,
+    PRAY_CALC_TIMES
+};
+
+struct pray_calc_params {
+    float   lat;                // degrees, north positive
+    float   lon;                // degrees, east positive
+    int16_t utc_offset_min;     // local time minus UTC
+    uint8_t method;             // enum pray_calc_method
+    uint8_t asr_shadow;         // Asr shadow factor: 1 Shafi'i (the generator's), 2 Hanafi
+    int8_t  offset_min[5];      // Fajr..Isha, added after rounding as the generator's offsets
+    // PRAY_METHOD_CUSTOM only
+    float   fajr_angle;         // degrees below the horizon
+    float   isha_angle;
+    uint8_t isha_interval_min;  // Isha = Maghrib + this; 0 to use isha_angle
+};
+
+// adhanpy's PrayerTimes for one local date: Fajr, Sunrise, Dhuhr, Asr, Maghrib
+// and Isha as local minutes of the day (0..1439), method adjustments applied,
+// offset_min not. Returns false where the sun does not rise, set or reach the
+// Asr altitude (the generator fails on those days too).
+bool pray_calc_times(const struct pray_calc_params *p, int year, int month, int day,
+                     uint16_t out[PRAY_CALC_TIMES]);
+
+// One PRAY2 table row (Fajr, Dhuhr, Asr, Maghrib, Isha), as the generator's
+// compute_minutes_table(): offsets added modulo 1440 (a time pushed past
+// midnight wraps, as datetime arithmetic does there), then made strictly
+// rising, capped at 1439.
+bool pray_calc_day(const struct pray_calc_params *p, int year, int month, int day,
+                   uint16_t out_min[5]);
@@ -0,0 +1,47 @@
+// rtc_oneshot.c
+#include "rtc_oneshot.h"
+#include "pray2_reader.h"
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/crc.h>
+#include <string.h>
+
+// Most recent first; 0 = empty slot.
+static uint32_t applied[RTC_ONESHOT_SLOTS];
+
+static int rtc_settings_set(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+    const char *next;
+    if (!settings_name_steq(key, "applied", &next) || next) return -ENOENT;
+    if (len != sizeof(applied)) return -EINVAL;
+    return (read_cb(cb_arg, applied, len) == (ssize_t)len) ? 0 : -EIO;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(rtc_oneshot, "rtc", NULL, rtc_settings_set, NULL, NULL);
+
+int rtc_oneshot_init(void)
+{
+    return settings_load_subtree("rtc");
+}
+
+uint32_t rtc_oneshot_key(const uint8_t *buf, size_t len)
+{
+    uint32_t payload = pray2_payload_size(buf, len);
+    return payload ? crc32_ieee(buf, payload) : 0;
+}
+
+bool rtc_oneshot_applied(uint32_t key)
+{
+    for (int i = 0; i < RTC_ONESHOT_SLOTS; ++i) {
+        if (applied[i] == key) return true;
+    }
+    return false;
+}
+
+int rtc_oneshot_mark(uint32_t key)
+{
+    if (key == 0 || rtc_oneshot_applied(key)) return 0;
+    memmove(&applied[1], &applied[0], sizeof(applied) - sizeof(applied[0]));
+    applied[0] = key;
+    return settings_save_one("rtc/applied", applied, sizeof(applied));
+}
@@ -0,0 +1,24 @@
+// rtc_oneshot.h — which schedule files have already set the RTC
+//
+// A PRAY2 file with the one-shot flag carries the time it was generated at.
+// That time must be applied once, not on every boot that loads the file, so
+// the CRCs of the last RTC_ONESHOT_SLOTS applied files are kept in settings
+// ("rtc/applied") instead of rewriting the flag in the file itself.
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RTC_ONESHOT_SLOTS 4
+
+// Load the record (settings_subsys_init() must have run, see app_config_init()).
+int rtc_oneshot_init(void);
+
+// CRC32 identifying a PRAY2 blob: the generator's trailing CRC, i.e. over
+// header + table (+ durations). Returns 0 if buf is not a PRAY2 blob.
+uint32_t rtc_oneshot_key(const uint8_t *buf, size_t len);
+
+bool rtc_oneshot_applied(uint32_t key);
+
+// Record key as applied and persist it. Returns 0 or a negative errno.
+int rtc_oneshot_mark(uint32_t key);
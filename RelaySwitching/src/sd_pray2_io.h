@@ -9,23 +9,133 @@
 #define PRAY2_FLAG_RTC_ONE_SHOT 0x10  // header flags bit4
 #endif
 
+// Read size used by sd_load_entire_file(); a multiple of the 512-byte sector so
+// every read after the first starts on a sector boundary.
+#define SD_LOAD_SPAN 4096
 
+// Integrity verdict for a file loaded with sd_load_entire_file().
+enum sd_pray2_crc {
+    SD_PRAY2_CRC_OK = 0,    // trailing CRC32 present and matches
+    SD_PRAY2_CRC_MISMATCH,  // trailing CRC32 present but wrong
+    SD_PRAY2_CRC_ABSENT     // not a PRAY2 file or file ends before the CRC
+};
+
+
+// Init the "SD" disk and mount FAT at /SD: (one attempt; see sd_service.h for
+// retries). Returns 0 on success, -1 otherwise.
 int mount_sd_card(void);
 
-// Find the single .bin file in root (e.g. "/SD:") and return full path "/SD:/xxx.bin".
-// Returns 0 on success; negative errno or Zephyr FS error otherwise.
-int sd_find_single_bin(const char *root, char *out_path, size_t out_len);
+// Unmount /SD: (card removed). Returns 0 or a negative errno.
+int unmount_sd_card(void);
+
+// ---- schedule library ----
+// Any number of PRAY2 .bin files (one per year or span) live in the root next
+// to a small binary index, so boot and day rollover never enumerate the card.
+#define SD_INDEX_NAME        "index.pray"
+#define SD_INDEX_MAX_ENTRIES 32
+
+struct sd_index_entry {
+    int32_t  start_day;   // first table day, days since 1970-01-01
+    uint16_t days;        // span length
+    uint8_t  method_code;
+    uint8_t  flags;       // PRAY2 header flags
+    uint32_t crc;         // trailing CRC32 of the file (0 if absent)
+    char     name[20];    // file name inside root, NUL-padded
+};
 
-// Read entire file into RAM buffer. Sets *out_len.
+// Every call below that opens, writes or renames library files (both roots)
+// holds one library lock, so an SD import, an upload and a load never meet on
+// the same file.
+
+// Scan root for .bin files and (re)write the index from their headers.
+// Only needed when the index is missing, e.g. after copying files by hand.
 // Returns 0 on success; negative errno/FS error otherwise.
-int sd_load_entire_file(const char *path, uint8_t *buf, size_t max_len, size_t *out_len);
+int sd_index_rebuild(const char *root);
+
+// Find the file whose span covers `day` (days since 1970-01-01) by binary search
+// over the index; rebuilds the index first if it is missing or damaged.
+// Returns 0 with *out/out_path filled on a hit. Returns -ENOENT if no span
+// covers the day, still filling *out/out_path with the next span (or the last
+// one) when the library is not empty. Negative errno/FS error otherwise.
+int sd_index_lookup(const char *root, int32_t day,
+                    struct sd_index_entry *out, char *out_path, size_t out_len);
+
+// Copy up to max index entries (sorted by start day) into out; rebuilds a
+// missing index first. Returns the number of entries or a negative error.
+int sd_index_list(const char *root, struct sd_index_entry *out, size_t max);
 
-// Clear one-shot flag (bit 0x10) at header offset 14 in the file on SD.
-// Safe to call even if bit already clear.
+// Add (or replace, same start day) an existing .bin file in root to the index.
 // Returns 0 on success; negative errno/FS error otherwise.
-int sd_clear_oneshot_flag_in_file(const char *path);
+int sd_index_add_file(const char *root, const char *name);
 
+// Read entire file into RAM buffer. Sets *out_len and, if out_crc is given, checks
+// the CRC32 the generator appends after the PRAY2 payload.
+// Returns 0 on success (even on CRC mismatch; see *out_crc), -EFBIG if the file
+// does not fit in max_len, negative errno/FS error otherwise.
+int sd_load_entire_file(const char *path, uint8_t *buf, size_t max_len, size_t *out_len,
+                        enum sd_pray2_crc *out_crc);
 
+// A file too big for the RAM buffer (-EFBIG above) is read in place instead:
+// open it as a pray_src_t and pray_open() it, and rows and sections are read
+// from the file as the scheduler asks for them. One file at a time; opening
+// another, or unmounting its card, closes it. The file is streamed once to
+// check its trailing CRC (*out_crc as above; *out_key the CRC computed over
+// the payload, rtc_oneshot_key()'s value, 0 if there is none).
+// Returns 0 on success, negative errno/FS error otherwise.
+struct pray_src;
+int sd_pray_src_open(const char *path, struct pray_src *src,
+                     enum sd_pray2_crc *out_crc, uint32_t *out_key);
+void sd_pray_src_close(void);
+
+// Write a PRAY2 blob to root as S<YYMMDD>.BIN (named by its first day; a file for
+// the same start day is replaced) and add it to the index.
+// Only a file the loaders would start is written: it must parse, have days and
+// not fail its trailing CRC. Returns 0 on success; -EINVAL if it does not; -ENOSPC
+// if the index is full; negative errno/FS error otherwise.
 int sd_store_pray2_from_ram(const char *root,
                             const uint8_t *data, size_t len,
-                            char *out_path, size_t out_len);
\ No newline at end of file
+                            char *out_path, size_t out_len);
+// ---- date overrides ----
+// An overrides-only PRAY3 file (no days, an OVERRIDES section) is kept next to
+// the index under this name and applies to whichever schedule file runs.
+#define SD_OVERRIDE_NAME "override.pray"
+
+// Write data as root's override file (replacing it). Returns 0 on success;
+// -EINVAL if it is not an overrides-only file that parses and does not fail its
+// trailing CRC; negative errno/FS error otherwise.
+int sd_overrides_store(const char *root, const uint8_t *data, size_t len);
+
+// Copy the library file at src_path (another root) into root as name and index
+// it, with the checks sd_store_pray2_from_ram() applies: the header is parsed
+// and the CRC folded in as the file streams through, so any size will do.
+// Returns 0 on success; -EINVAL if it fails them (nothing is left in root);
+// negative errno/FS error otherwise.
+int sd_import_pray2(const char *src_path, const char *root, const char *name);
+
+// ---- raw-sector boot copy (CONFIG_APP_SD_RAW_SCHEDULE) ----
+// The active schedule is mirrored into sectors between the MBR and the first
+// partition, so boot can read it with two disk_access_read() calls and no FAT
+// mount. Layout from SD_RAW_FIRST_LBA: one header sector, then the payload.
+#define SD_RAW_MAGIC       "PRAYRAW"
+#define SD_RAW_SECTOR      512
+#define SD_RAW_MAX_SECTORS (SD_LOAD_SPAN / SD_RAW_SECTOR)
+
+struct sd_raw_hdr {
+    char     magic[8];    // SD_RAW_MAGIC, NUL-terminated
+    uint16_t version;     // 1
+    uint16_t hdr_size;    // sizeof(struct sd_raw_hdr)
+    uint32_t len;         // payload bytes
+    uint32_t crc;         // CRC32 (IEEE) of the payload
+    uint32_t seq;         // incremented by each sd_raw_store()
+    uint32_t hdr_crc;     // CRC32 of the fields above
+};
+
+// Read the raw copy into buf (max_len must hold whole sectors, i.e. up to
+// SD_LOAD_SPAN). Returns 0 with *out_len set; -ENOENT if the region holds no
+// valid copy; -EBADMSG on payload CRC mismatch; -ENOTSUP if the card has no
+// MBR gap big enough; negative errno otherwise.
+int sd_raw_load(uint8_t *buf, size_t max_len, size_t *out_len);
+
+// Write data as the raw copy (payload first, header last, skipped if the
+// stored copy is already identical). Returns 0 or a negative errno.
+int sd_raw_store(const uint8_t *data, size_t len);
@@ -0,0 +1,134 @@
+// sd_service.c
+#include "sd_service.h"
+#include "sd_pray2_io.h"
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/util.h>
+
+#define SD_SERVICE_PRIO  K_LOWEST_APPLICATION_THREAD_PRIO
+
+#define SD_CD_NODE DT_ALIAS(sd_cd)
+#if DT_NODE_EXISTS(SD_CD_NODE)
+#define SD_HAS_CD 1
+static const struct gpio_dt_spec sd_cd = GPIO_DT_SPEC_GET(SD_CD_NODE, gpios);
+static struct gpio_callback sd_cd_cb;
+#else
+#define SD_HAS_CD 0
+#endif
+
+K_EVENT_DEFINE(sd_events);
+
+// SD init and FAT mount can take seconds on a bad card: keep them off the
+// system work queue, which also carries the event log and settings writes.
+static K_THREAD_STACK_DEFINE(sd_stack, CONFIG_APP_SD_SERVICE_STACK_SIZE);
+static struct k_work_q sd_wq;
+
+static sd_service_mount_cb mount_cb;
+static atomic_t mounted;
+static uint32_t retry_ms = SD_RETRY_MIN_MS;
+
+static void sd_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(sd_work, sd_work_handler);
+
+bool sd_service_card_present(void)
+{
+#if SD_HAS_CD
+    return gpio_pin_get_dt(&sd_cd) > 0;
+#else
+    return true;
+#endif
+}
+
+bool sd_service_is_mounted(void)
+{
+    return atomic_get(&mounted) != 0;
+}
+
+static void sd_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+    bool present = sd_service_card_present();
+
+    if (sd_service_is_mounted()) {
+        if (!present) {
+            (void)unmount_sd_card();
+            atomic_set(&mounted, 0);
+            k_event_post(&sd_events, SD_EVT_REMOVED);
+        }
+        return;
+    }
+
+    // Empty slot: wait for the card-detect edge, no polling.
+    if (!present) {
+        retry_ms = SD_RETRY_MIN_MS;
+        return;
+    }
+
+    if (mount_sd_card() != 0) {
+        (void)k_work_schedule_for_queue(&sd_wq, &sd_work, K_MSEC(retry_ms));
+        retry_ms = MIN(retry_ms * 2, SD_RETRY_MAX_MS);
+        return;
+    }
+
+    retry_ms = SD_RETRY_MIN_MS;
+    atomic_set(&mounted, 1);
+    k_event_clear(&sd_events, SD_EVT_REMOVED);
+    k_event_post(&sd_events, SD_EVT_MOUNTED);
+
+    if (mount_cb && mount_cb()) {
+        k_event_post(&sd_events, SD_EVT_NEW_SCHEDULE);
+    }
+}
+
+#if SD_HAS_CD
+static void sd_cd_isr(const struct device *port, struct gpio_callback *cb, uint32_t pins)
+{
+    ARG_UNUSED(port);
+    ARG_UNUSED(cb);
+    ARG_UNUSED(pins);
+    // Contacts bounce on insertion; act once the level has settled.
+    (void)k_work_reschedule_for_queue(&sd_wq, &sd_work, K_MSEC(SD_CD_DEBOUNCE_MS));
+}
+
+// The pin is an input before main(), so sd_service_card_present() can be asked
+// ahead of sd_service_start() (the raw-sector boot path does).
+static int sd_cd_pin_init(void)
+{
+    return gpio_is_ready_dt(&sd_cd) ? gpio_pin_configure_dt(&sd_cd, GPIO_INPUT) : -ENODEV;
+}
+
+SYS_INIT(sd_cd_pin_init, APPLICATION, 0);
+
+static void sd_cd_init(void)
+{
+    if (!gpio_is_ready_dt(&sd_cd)) {
+        return;
+    }
+    gpio_init_callback(&sd_cd_cb, sd_cd_isr, BIT(sd_cd.pin));
+    if (gpio_add_callback(sd_cd.port, &sd_cd_cb) == 0) {
+        (void)gpio_pin_interrupt_configure_dt(&sd_cd, GPIO_INT_EDGE_BOTH);
+    }
+}
+#endif
+
+void sd_service_start(sd_service_mount_cb on_mount)
+{
+    static const struct k_work_queue_config cfg = { .name = "sd_service" };
+
+    mount_cb = on_mount;
+    k_work_queue_start(&sd_wq, sd_stack, K_THREAD_STACK_SIZEOF(sd_stack),
+                       SD_SERVICE_PRIO, &cfg);
+#if SD_HAS_CD
+    sd_cd_init();
+#endif
+    (void)k_work_schedule_for_queue(&sd_wq, &sd_work, K_NO_WAIT);
+}
+
+void sd_service_request(void)
+{
+    if (sd_service_is_mounted()) return;
+    retry_ms = SD_RETRY_MIN_MS;
+    (void)k_work_reschedule_for_queue(&sd_wq, &sd_work, K_NO_WAIT);
+}
@@ -0,0 +1,38 @@
+// sd_service.h — background SD card mount/remount on its own work queue
+//
+// Nothing here blocks the caller: sd_service_start() only schedules the first
+// attempt. A failed mount is retried with exponential backoff
+// (SD_RETRY_MIN_MS doubling up to SD_RETRY_MAX_MS). With an "sd-cd"
+// card-detect alias in the devicetree, insert/remove edges trigger a mount or
+// unmount at once and no retries run while the slot is empty.
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#define SD_RETRY_MIN_MS   1000
+#define SD_RETRY_MAX_MS   (60 * 1000)
+#define SD_CD_DEBOUNCE_MS 200
+
+// Bits posted to sd_events.
+#define SD_EVT_MOUNTED      BIT(0)
+#define SD_EVT_REMOVED      BIT(1)
+#define SD_EVT_NEW_SCHEDULE BIT(2)  // on_mount reported new schedule data
+
+extern struct k_event sd_events;
+
+// Runs on the SD work queue after each successful mount (e.g. to import new
+// files). Return true if a schedule worth reloading is now available.
+typedef bool (*sd_service_mount_cb)(void);
+
+// Start the service; the first mount attempt runs in the background.
+void sd_service_start(sd_service_mount_cb on_mount);
+
+// Ask for a mount attempt now instead of at the next backoff step.
+void sd_service_request(void);
+
+bool sd_service_is_mounted(void);
+
+// False only when a card-detect switch reports an empty slot. Valid from boot,
+// before sd_service_start().
+bool sd_service_card_present(void);
@@ -0,0 +1,99 @@
+// sim_board.c — native_sim glue: command-line options for the emulated board
+//
+//   --rtc=YYYY-MM-DDTHH:MM:SS  start the RTC emulator at this UTC time
+//                              (default 2025-01-01T00:00:00)
+//   --switch=auto|manual       position of the auto/manual switch
+//   --oled                     print the display on stdout whenever it changes
+//
+// Only built for native_sim (see CMakeLists.txt).
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/timeutil.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cmdline.h"
+#include "soc.h"
+#include "RTCmcp7940_emul.h"
+#include "ssd1306_emul.h"
+
+static char *opt_rtc;
+static char *opt_switch;
+static bool opt_oled;
+
+static void sim_board_options(void)
+{
+    static struct args_struct_t opts[] = {
+        { .option = "rtc", .name = "time", .type = 's', .dest = (void *)&opt_rtc,
+          .descript = "Start the emulated RTC at YYYY-MM-DDTHH:MM:SS (UTC)" },
+        { .option = "switch", .name = "auto|manual", .type = 's', .dest = (void *)&opt_switch,
+          .descript = "Auto/manual switch position (default auto)" },
+        { .is_switch = true, .option = "oled", .type = 'b', .dest = (void *)&opt_oled,
+          .descript = "Print the emulated display whenever a new frame differs" },
+        ARG_TABLE_ENDMARKER
+    };
+    native_add_command_line_opts(opts);
+}
+NATIVE_TASK(sim_board_options, PRE_BOOT_1, 10);
+
+static void oled_frame(const struct emul *target, void *user)
+{
+    static uint8_t last[SSD1306_BUFFER_SIZE];
+    ARG_UNUSED(user);
+
+    const uint8_t *fb = ssd1306_emul_gddram(target);
+    if (memcmp(last, fb, sizeof(last)) == 0) return;
+    memcpy(last, fb, sizeof(last));
+    printk("--- oled frame %u ---\n", (unsigned)ssd1306_emul_frames(target));
+    ssd1306_emul_print(target);
+}
+
+static int sim_set_rtc(const char *text)
+{
+    struct tm tm = {0};
+    if (sscanf(text, "%d-%d-%dT%d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+               &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
+        return -EINVAL;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    mcp7940n_emul_set_time(EMUL_DT_GET(DT_NODELABEL(sim_rtc)), timeutil_timegm(&tm));
+    return 0;
+}
+
+// The GPIO emulator has no pull resistors, so both inputs are driven
+// explicitly. main() reads sw0: contact closed (low) = manual, open = auto.
+// sw1 is not read for the mode and is held open.
+static void sim_set_switch(bool manual)
+{
+    const struct gpio_dt_spec sw_mode = GPIO_DT_SPEC_GET(DT_ALIAS(sw0), gpios);
+    const struct gpio_dt_spec sw_other = GPIO_DT_SPEC_GET(DT_ALIAS(sw1), gpios);
+
+    (void)gpio_pin_configure_dt(&sw_mode, GPIO_INPUT);
+    (void)gpio_pin_configure_dt(&sw_other, GPIO_INPUT);
+    (void)gpio_emul_input_set(sw_mode.port, sw_mode.pin, manual ? 0 : 1);
+    (void)gpio_emul_input_set(sw_other.port, sw_other.pin, 1);
+}
+
+static int sim_board_init(void)
+{
+    if (opt_rtc && sim_set_rtc(opt_rtc) != 0) {
+        printk("sim: bad --rtc '%s', keeping default\n", opt_rtc);
+    }
+
+    sim_set_switch(opt_switch && strcmp(opt_switch, "manual") == 0);
+
+    if (opt_oled) {
+        ssd1306_emul_set_frame_cb(EMUL_DT_GET(DT_NODELABEL(sim_oled)), oled_frame, NULL);
+    }
+    return 0;
+}
+
+// After the RTC and display drivers (POST_KERNEL), before main().
+SYS_INIT(sim_board_init, APPLICATION, 0);
@@ -15,24 +15,154 @@
 #include <zephyr/storage/flash_map.h>
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
 
 /* Flash partition and device definitions */
-#define TEST_PARTITION              storage_partition
+#define TEST_PARTITION              scratch_partition
 #define TEST_PARTITION_OFFSET	FIXED_PARTITION_OFFSET(TEST_PARTITION)
 #define TEST_PARTITION_DEVICE	FIXED_PARTITION_DEVICE(TEST_PARTITION)
 
-/* Flash configuration constants */
-#define FLASH_PAGE_SIZE             4096
+/* Write-back buffer: one page, the largest page size this code supports */
+#define SYS_FLASH_WB_SIZE           4096
+
+/* Blank-check read chunk (stack) */
+#define SYS_FLASH_CHECK_CHUNK       64
 
 
 const struct device *flash_dev;
 
+static K_MUTEX_DEFINE(flash_lock);
+static uint8_t wb_buf[SYS_FLASH_WB_SIZE];
+static uint32_t wb_page;        /* partition offset of the cached page */
+static uint32_t wb_page_size;
+static bool wb_valid;           /* wb_buf holds the page */
+static bool wb_need_erase;      /* some buffered byte cannot be programmed over flash */
+static uint32_t wb_lo, wb_hi;   /* dirty range within the page, wb_lo == wb_hi if clean */
+static uint8_t erase_value = 0xFF;
+static size_t write_block = 1;
+static struct sys_flash_stats stats;
+
+/**
+ * @brief Looks up the page that contains a partition offset.
+ *
+ * @param offset Offset from the start of the partition.
+ * @param page_off Set to the page start (partition offset).
+ * @param page_size Set to the page size.
+ * @return 0 on success, negative errno otherwise.
+ */
+static int page_of(uint32_t offset, uint32_t *page_off, uint32_t *page_size)
+{
+    struct flash_pages_info info;
+    int rc = flash_get_page_info_by_offs(flash_dev, TEST_PARTITION_OFFSET + offset, &info);
+
+    if (rc == 0) {
+        *page_off = (uint32_t)info.start_offset - TEST_PARTITION_OFFSET;
+        *page_size = (uint32_t)info.size;
+    }
+    return rc;
+}
+
+/**
+ * @brief Checks whether a flash range reads back as erased.
+ */
+static bool range_is_blank(uint32_t offset, uint32_t size)
+{
+    uint8_t chunk[SYS_FLASH_CHECK_CHUNK];
+
+    while (size) {
+        uint32_t n = MIN(size, sizeof(chunk));
+        if (flash_read(flash_dev, TEST_PARTITION_OFFSET + offset, chunk, n) != 0) {
+            return false;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            if (chunk[i] != erase_value) {
+                return false;
+            }
+        }
+        offset += n;
+        size -= n;
+    }
+    return true;
+}
+
+/**
+ * @brief Erases one page unless it is already blank. Caller holds flash_lock.
+ */
+static int erase_page(uint32_t page_off, uint32_t page_size)
+{
+    uint32_t t0 = k_cycle_get_32();
+    int rc = 0;
+
+    if (range_is_blank(page_off, page_size)) {
+        stats.erase_skipped++;
+    } else {
+        rc = flash_erase(flash_dev, TEST_PARTITION_OFFSET + page_off, page_size);
+        if (rc == 0) {
+            stats.erase_pages++;
+        }
+    }
+    stats.erase_us += (uint32_t)k_cyc_to_us_floor64(k_cycle_get_32() - t0);
+    return rc;
+}
+
+/**
+ * @brief Programs a range of the cached page. Caller holds flash_lock.
+ */
+static int program(uint32_t lo, uint32_t hi)
+{
+    uint32_t t0 = k_cycle_get_32();
+    int rc = flash_write(flash_dev, TEST_PARTITION_OFFSET + wb_page + lo, &wb_buf[lo], hi - lo);
+
+    stats.program_us += (uint32_t)k_cyc_to_us_floor64(k_cycle_get_32() - t0);
+    if (rc == 0) {
+        stats.program_ops++;
+        stats.program_bytes += hi - lo;
+    }
+    return rc;
+}
+
+/**
+ * @brief Writes the cached page back. Caller holds flash_lock.
+ *
+ * Without a needed erase only the dirty range (widened to the write block) is
+ * programmed; otherwise the page is erased and programmed whole.
+ */
+static int wb_flush_locked(void)
+{
+    int rc = 0;
+
+    if (!wb_valid || wb_lo == wb_hi) {
+        return 0;
+    }
+
+    if (wb_need_erase) {
+        rc = erase_page(wb_page, wb_page_size);
+        if (rc == 0) {
+            rc = program(0, wb_page_size);
+        }
+    } else {
+        uint32_t lo = ROUND_DOWN(wb_lo, write_block);
+        uint32_t hi = MIN(ROUND_UP(wb_hi, write_block), wb_page_size);
+        rc = program(lo, hi);
+    }
+
+    if (rc == 0) {
+        wb_lo = wb_hi = 0;
+        wb_need_erase = false;
+    } else {
+        /* Keep nothing we cannot vouch for */
+        wb_valid = false;
+    }
+    return rc;
+}
+
 /**
  * @brief Erases a portion of the flash memory.
  * 
- * This function erases a specific region of the flash memory, starting at the
- * given offset and covering the specified size. The operation is performed on
- * the partition defined by `TEST_PARTITION`.
+ * Every page overlapped by [offset, offset + size) is erased; pages that
+ * already read back blank are skipped. Buffered data for an erased page is
+ * dropped.
  * 
  * @param offset Offset from the start of the partition to erase.
  * @param size Size of the memory region to erase (in bytes).
@@ -41,17 +171,29 @@ const struct device *flash_dev;
 enum sys_flash_status sys_flash_erase(uint32_t offset, uint32_t size)
 {
     enum sys_flash_status stat = sys_flash_ok;
+    uint32_t end = offset + size;
 
-    uint32_t flashOffset = TEST_PARTITION_OFFSET + offset;
+    if (size == 0 || end < offset || end > FIXED_PARTITION_SIZE(TEST_PARTITION)) {
+        return (size == 0) ? sys_flash_ok : sys_flash_err;
+    }
 
-    /* Attempt to erase the specified region */
-    if (flash_erase(flash_dev, flashOffset, FLASH_PAGE_SIZE) != 0) {
-        
-        stat = sys_flash_err;
-        goto common;
+    k_mutex_lock(&flash_lock, K_FOREVER);
+    while (offset < end) {
+        uint32_t page_off, page_size;
+
+        if (page_of(offset, &page_off, &page_size) != 0 ||
+            erase_page(page_off, page_size) != 0) {
+            stat = sys_flash_err;
+            goto common;
+        }
+        if (wb_valid && wb_page == page_off) {
+            wb_valid = false;
+        }
+        offset = page_off + page_size;
     }
 
 common:
+    k_mutex_unlock(&flash_lock);
     return stat;
 }
 
@@ -59,7 +201,8 @@ common:
  * @brief Reads data from the flash memory.
  * 
  * This function reads a specified amount of data from the flash memory,
- * starting at the given offset within the `TEST_PARTITION`.
+ * starting at the given offset within the `TEST_PARTITION`. Data still in
+ * the write-back buffer is returned as written.
  * 
  * @param offset Offset from the start of the partition to read from.
  * @param data Pointer to the buffer where the read data will be stored.
@@ -72,6 +215,8 @@ enum sys_flash_status sys_flash_read(uint32_t offset, void *data, uint32_t size)
 
     uint32_t flashOffset = TEST_PARTITION_OFFSET + offset;
 
+    k_mutex_lock(&flash_lock, K_FOREVER);
+
     /* Attempt to read the specified data */
     if (flash_read(flash_dev, flashOffset, data, size) != 0) {
         
@@ -79,48 +224,135 @@ enum sys_flash_status sys_flash_read(uint32_t offset, void *data, uint32_t size)
         goto common;
     }
 
+    /* Overlay the part of the request that is still buffered */
+    if (wb_valid && wb_lo != wb_hi) {
+        uint32_t lo = MAX(offset, wb_page);
+        uint32_t hi = MIN(offset + size, wb_page + wb_page_size);
+        if (lo < hi) {
+            memcpy((uint8_t *)data + (lo - offset), &wb_buf[lo - wb_page], hi - lo);
+        }
+    }
+
 common:
+    k_mutex_unlock(&flash_lock);
     return stat;
 }
 
 /**
  * @brief Writes data to the flash memory.
  * 
- * This function writes a specified amount of data to the flash memory,
- * starting at the given offset within the `TEST_PARTITION`. Before writing,
- * it ensures the region is erased by calling `sys_flash_erase`.
+ * The data is copied into the write-back buffer page by page; a page is
+ * written to flash when a later write moves to another page or on
+ * sys_flash_flush(). Writes may span any number of pages.
  * 
  * @param offset Offset from the start of the partition to write to.
  * @param data Pointer to the data to be written.
  * @param size Number of bytes to write.
  * @return sys_flash_ok if successful, sys_flash_err if an error occurred.
  */
-enum sys_flash_status sys_flash_write(uint32_t offset, void *data, uint32_t size)
+enum sys_flash_status sys_flash_write(uint32_t offset, const void *data, uint32_t size)
 {
     enum sys_flash_status stat = sys_flash_ok;
+    const uint8_t *src = data;
+    uint32_t end = offset + size;
 
-    uint32_t flashOffset = TEST_PARTITION_OFFSET + offset;
+    if (end < offset || end > FIXED_PARTITION_SIZE(TEST_PARTITION)) {
+        return sys_flash_err;
+    }
 
-    /* Ensure the region is erased before writing */
-    sys_flash_erase(offset, size);
+    k_mutex_lock(&flash_lock, K_FOREVER);
+    while (offset < end) {
+        uint32_t page_off, page_size;
 
-    /* Attempt to write the specified data */
-    if (flash_write(flash_dev, flashOffset, data, size) != 0) {
-        
-        stat = sys_flash_err;
-        goto common;
+        if (page_of(offset, &page_off, &page_size) != 0 || page_size > sizeof(wb_buf)) {
+            stat = sys_flash_err;
+            goto common;
+        }
+
+        /* Switch the buffer to this page */
+        if (!wb_valid || wb_page != page_off) {
+            if (wb_flush_locked() != 0 ||
+                flash_read(flash_dev, TEST_PARTITION_OFFSET + page_off, wb_buf, page_size) != 0) {
+                wb_valid = false;
+                stat = sys_flash_err;
+                goto common;
+            }
+            wb_page = page_off;
+            wb_page_size = page_size;
+            wb_lo = wb_hi = 0;
+            wb_need_erase = false;
+            wb_valid = true;
+        }
+
+        uint32_t in_page = offset - page_off;
+        uint32_t n = MIN(end - offset, page_size - in_page);
+
+        /* Programming can only move bytes away from the erased state */
+        for (uint32_t i = 0; i < n && !wb_need_erase; i++) {
+            uint8_t old = wb_buf[in_page + i];
+            if (old != erase_value && old != src[i]) {
+                wb_need_erase = true;
+            }
+        }
+        memcpy(&wb_buf[in_page], src, n);
+
+        if (wb_lo == wb_hi) {
+            wb_lo = in_page;
+            wb_hi = in_page + n;
+        } else {
+            wb_lo = MIN(wb_lo, in_page);
+            wb_hi = MAX(wb_hi, in_page + n);
+        }
+
+        offset += n;
+        src += n;
     }
 
 common:
+    k_mutex_unlock(&flash_lock);
     return stat;
 }
 
+/**
+ * @brief Writes any buffered data to flash.
+ *
+ * @return sys_flash_ok if successful, sys_flash_err if an error occurred.
+ */
+enum sys_flash_status sys_flash_flush(void)
+{
+    k_mutex_lock(&flash_lock, K_FOREVER);
+    int rc = wb_flush_locked();
+    k_mutex_unlock(&flash_lock);
+
+    return (rc == 0) ? sys_flash_ok : sys_flash_err;
+}
+
+/**
+ * @brief Copies the erase/program counters.
+ */
+void sys_flash_get_stats(struct sys_flash_stats *out)
+{
+    k_mutex_lock(&flash_lock, K_FOREVER);
+    *out = stats;
+    k_mutex_unlock(&flash_lock);
+}
+
+/**
+ * @brief Clears the erase/program counters.
+ */
+void sys_flash_stats_reset(void)
+{
+    k_mutex_lock(&flash_lock, K_FOREVER);
+    memset(&stats, 0, sizeof(stats));
+    k_mutex_unlock(&flash_lock);
+}
+
 /**
  * @brief Initializes the flash memory device.
  * 
  * This function initializes the flash memory device by retrieving the
  * device associated with the `TEST_PARTITION`. It verifies the device is
- * ready for use.
+ * ready for use and reads its erase value and write block size.
  * 
  * @return sys_flash_ok if successful, sys_flash_err if the device is not ready.
  */
@@ -138,6 +370,11 @@ enum sys_flash_status sys_flash_init()
         goto common;
     }
 
+    erase_value = flash_get_parameters(flash_dev)->erase_value;
+    write_block = MAX(flash_get_write_block_size(flash_dev), 1);
+    wb_valid = false;
+    memset(&stats, 0, sizeof(stats));
+
 common:
     return stat;
 }
@@ -1,10 +1,15 @@
 /**
  * @file sys_flash.h
  * @brief Flash memory management for the application.
- * 
- * This header file defines the interfaces and constants for interacting 
+ *
+ * This header file defines the interfaces and constants for interacting
  * with the system's flash memory, including read, write, and erase operations.
- * 
+ *
+ * Writes go through a one-page RAM write-back buffer: small writes to the same
+ * page are combined and programmed once, on sys_flash_flush() or when a write
+ * moves to another page. A page is only erased when the new data cannot be
+ * programmed over what is already there.
+ *
  * @author Haseeb Zaib
  * @date December 19, 2024
  * @contact hzaib76@gmail.com
@@ -24,16 +29,29 @@ enum sys_flash_status {
   sys_flash_err     /**< Operation failed */
 };
 
-
+/**
+ * @brief Erase/program counters since init or the last sys_flash_stats_reset().
+ */
+struct sys_flash_stats {
+  uint32_t erase_pages;    /**< Pages actually erased */
+  uint32_t erase_skipped;  /**< Pages found blank, erase skipped */
+  uint32_t erase_us;       /**< Time spent erasing and blank-checking */
+  uint32_t program_ops;    /**< flash_write() calls issued */
+  uint32_t program_bytes;  /**< Bytes programmed */
+  uint32_t program_us;     /**< Time spent programming */
+};
 
 
 
 /* Function declarations */
 extern enum sys_flash_status sys_flash_erase(uint32_t offset, uint32_t size);
 extern enum sys_flash_status sys_flash_read(uint32_t offset, void *data, uint32_t size);
-extern enum sys_flash_status sys_flash_write(uint32_t offset, void *data, uint32_t size);
+extern enum sys_flash_status sys_flash_write(uint32_t offset, const void *data, uint32_t size);
+extern enum sys_flash_status sys_flash_flush(void);
 extern enum sys_flash_status sys_flash_init();
+extern void sys_flash_get_stats(struct sys_flash_stats *out);
+extern void sys_flash_stats_reset(void);
 
 
 
-#endif /* _SYS_FLASH_H_ */
\ No newline at end of file
+#endif /* _SYS_FLASH_H_ */
@@ -6,6 +6,8 @@
  */
 
 #include "xmodem.h"
+#include "app_trace.h"
+#include "app_counters.h"
 
 extern uint16_t DataBufferTotalSize ;
 extern void ledfasttoggle(uint8_t toggling);
@@ -39,6 +41,7 @@ uint8_t xmodem_receive(uint8_t *buffer, uint8_t (*rx)(uint8_t *, uint16_t, uint3
 
     x_first_packet_received = false;
     xmodem_packet_number = 1u;
+    APP_TRACE_BEGIN(XMODEM_RX, 0);
    
     /* Loop until there isn't any error (or until we jump to the user application). */
     while (X_OK == status)
@@ -75,6 +78,8 @@ uint8_t xmodem_receive(uint8_t *buffer, uint8_t (*rx)(uint8_t *, uint16_t, uint3
             packet_status = xmodem_handle_packet(buffer, header, rx, tx);
             if (X_OK == packet_status)
             {
+                APP_TRACE_MARK(XMODEM_BLOCK, xmodem_packet_number - 1u);
+                APP_CNT_INC(XM_PACKETS);
                 (void)tx(X_ACK, PROTOCOL_TIMEOUT);
             }
             /* If the error was flash related, then immediately set the error counter to max (graceful abort). */
@@ -97,6 +102,7 @@ uint8_t xmodem_receive(uint8_t *buffer, uint8_t (*rx)(uint8_t *, uint16_t, uint3
 
             k_msleep(500);
             ledfasttoggle(20);
+            APP_TRACE_END(XMODEM_RX, total_size);
              total_size = 0;
             return;
             break;
@@ -113,6 +119,7 @@ uint8_t xmodem_receive(uint8_t *buffer, uint8_t (*rx)(uint8_t *, uint16_t, uint3
             break;
         }
     }
+    APP_TRACE_END(XMODEM_RX, 0);
 }
 
 /**
@@ -156,7 +163,8 @@ static xmodem_status xmodem_handle_packet(uint8_t *buffer, uint8_t header, uint8
 
     /* 2 bytes for packet number, 1024 for data, 2 for CRC*/
     uint8_t received_packet_number[X_PACKET_NUMBER_SIZE];
-    uint8_t received_packet_data[X_PACKET_1024_SIZE];
+    /* Static: 1 KiB on the main stack was its deepest frame. Only the main thread receives. */
+    static uint8_t received_packet_data[X_PACKET_1024_SIZE];
     uint8_t received_packet_crc[X_PACKET_CRC_SIZE];
 
     /* Get the size of the data. */
@@ -214,7 +222,7 @@ static xmodem_status xmodem_handle_packet(uint8_t *buffer, uint8_t header, uint8
         if (crc_calculated != crc_received)
         {
             /* The calculated and received CRC are different. */
-
+            APP_CNT_INC(XM_CRC_FAIL);
             status |= X_ERROR_CRC;
         }
     }
@@ -251,6 +259,7 @@ static xmodem_status xmodem_error_handler(uint8_t *error_number, uint8_t max_err
     xmodem_status status = X_OK;
     /* Raise the error counter. */
     (*error_number)++;
+    APP_CNT_INC(XM_RETRIES);
     /* If the counter reached the max value, then abort. */
     if ((*error_number) >= max_error_number)
     {
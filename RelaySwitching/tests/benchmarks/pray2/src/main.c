@@ -0,0 +1,67 @@
+/*
+ * PRAY2 kernel benchmarks on target, timed with k_cycle_get_32().
+ *
+ *   west build -b nrf52dk/nrf52832 tests/benchmarks/pray2 && west flash
+ *
+ * Prints one JSON object (see tools/pray2_bench/pray2_bench.h), then
+ * "PRAY2_BENCH_DONE rc=<n>". Cut the JSON from the console log and compare it
+ * with earlier runs; the host build of the same kernels is tools/pray2_bench.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/printk.h>
+#include "pray2_bench.h"
+
+/*
+ * Each case must finish inside one 32-bit counter period. Where the system
+ * timer is a slow RTC (nRF52: 32768 Hz) rather than the CPU clock, run longer
+ * to get a usable resolution and report time only.
+ */
+#define BENCH_ITERS_CYCLES 2000
+#define BENCH_ITERS_SLOW   20000
+#define CPU_HZ DT_PROP_OR(DT_PATH(cpus, cpu_0), clock_frequency, 0)
+
+static const uint8_t ref_file[] = {
+#include "karachi_2025.bin.inc"
+};
+
+static uint8_t scratch[PRAY2_BENCH_SCRATCH];
+static struct pray2_bench_input inputs[2];
+
+void print_uart(char *buf)
+{
+	printk("%s", buf);
+}
+
+static uint64_t cycles_now(void)
+{
+	return k_cycle_get_32();
+}
+
+static void emit(const char *line)
+{
+	printk("%s\n", line);
+}
+
+int main(void)
+{
+	const uint32_t hz = sys_clock_hw_cycles_per_sec();
+	const bool cpu_cycles = (hz == CPU_HZ);
+	const struct pray2_bench_io io = {
+		.target = CONFIG_BOARD,
+		.now = cycles_now,
+		.clock_hz = hz,
+		.clock_is_cycles = cpu_cycles,
+		.clock_wraps32 = true,
+		.iters = cpu_cycles ? BENCH_ITERS_CYCLES : BENCH_ITERS_SLOW,
+		.emit = emit,
+	};
+
+	/* Keep interrupts and the idle thread out of the way as far as possible. */
+	k_msleep(100);
+	int rc = pray2_bench_run(&io, ref_file, sizeof(ref_file), scratch, inputs);
+
+	printk("PRAY2_BENCH_DONE rc=%d\n", rc);
+	return 0;
+}
@@ -0,0 +1,14 @@
+/*
+ * Host monotonic clock for the benchmark. Built in the native simulator
+ * runner's context (host libc), called from the embedded image.
+ */
+#include <stdint.h>
+#include <time.h>
+
+uint64_t sd_bench_host_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
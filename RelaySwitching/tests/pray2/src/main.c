@@ -0,0 +1,668 @@
+/*
+ * PRAY2 parser and scheduler (pray2_reader.h): behaviour and time budgets.
+ *
+ *   west twister -T tests/pray2 -p native_sim -p qemu_cortex_m3
+ *
+ * Most tests run against the generator's 2025 Karachi file; the leap-day,
+ * single-day and out-of-span cases use small files built in RAM, the PRAY3
+ * case the same year re-packed and read through a pray_src_t, and the override
+ * and weekday-rule cases overrides-only files applied over it. Every test
+ * also checks its run time against a budget (see Kconfig), so a slower
+ * scheduler fails here before it reaches a board.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+#include "pray2_reader.h"
+
+static const uint8_t ref_file[] = {
+#include "karachi_2025.bin.inc"
+};
+
+static uint8_t small_file[PRAY2_HEADER_SIZE + 3 * 5 * 2];
+static pray2_header_t ref_hdr;
+static pray2_sched_t sched;
+
+/* pray2_reader.h reports through the app's UART printer; stay quiet. */
+void print_uart(char *buf)
+{
+	ARG_UNUSED(buf);
+}
+
+#define BUDGET_MS(ms) ((ms) * CONFIG_PRAY2_TEST_BUDGET_SCALE)
+
+static uint64_t budget_start(void)
+{
+	return k_cycle_get_64();
+}
+
+static void budget_check(uint64_t start, uint32_t budget_ms, const char *what)
+{
+	uint64_t us = k_cyc_to_us_floor64(k_cycle_get_64() - start);
+
+	TC_PRINT("%s: %llu us (budget %u ms)\n", what, (unsigned long long)us, budget_ms);
+	zassert_true(us <= (uint64_t)budget_ms * 1000U, "%s took %llu us, budget %u ms",
+		     what, (unsigned long long)us, budget_ms);
+}
+
+static void put2(char *p, int v)
+{
+	p[0] = (char)('0' + v / 10);
+	p[1] = (char)('0' + v % 10);
+}
+
+/* "HH:MM:SS|DD/MM/YY" without snprintf, which would dominate the sweeps. */
+static const char *rtc(int Y, int M, int D, int hh, int mm)
+{
+	static char s[18] = "00:00:00|00/00/00";
+
+	put2(&s[0], hh);
+	put2(&s[3], mm);
+	put2(&s[9], D);
+	put2(&s[12], M);
+	put2(&s[15], Y % 100);
+	return s;
+}
+
+static pray2_time_t at(int Y, int M, int D, int hh, int mm)
+{
+	return (pray2_time_t){ .hh = hh, .mm = mm, .ss = 0, .DD = D, .MO = M, .YYYY = Y };
+}
+
+static bool tick(int Y, int M, int D, int hh, int mm, int *prayer, uint16_t *on_sec)
+{
+	return pray2_sched_tick(&sched, rtc(Y, M, D, hh, mm), prayer, on_sec);
+}
+
+/* Minute-by-minute from hh:mm on the given day; returns the number of fires. */
+static int sweep_day(int Y, int M, int D, int from_min, int to_min)
+{
+	int fires = 0;
+	int prayer;
+
+	for (int m = from_min; m <= to_min; m++) {
+		fires += tick(Y, M, D, m / 60, m % 60, &prayer, NULL);
+	}
+	return fires;
+}
+
+static void day_minutes(const pray2_header_t *h, int Y, int M, int D, uint16_t mins[5])
+{
+	int idx = pray2_compute_day_index(h, Y, M, D);
+
+	zassert_true(idx >= 0, "%04d-%02d-%02d outside span", Y, M, D);
+	zassert_true(pray2_get_day_minutes(h, (uint16_t)idx, mins));
+}
+
+/* Header + days x 5 minutes; Fajr drifts one minute a day so days differ. */
+static size_t build_file(int Y, int M, int D, uint16_t days)
+{
+	uint8_t *b = small_file;
+	size_t len = PRAY2_HEADER_SIZE + (size_t)days * 10U;
+
+	zassert_true(len <= sizeof(small_file));
+	memset(b, 0, sizeof(small_file));
+	memcpy(b, PRAY2_MAGIC, 5);
+	b[5] = PRAY2_VERSION;
+	sys_put_le16(PRAY2_HEADER_SIZE, &b[6]);
+	sys_put_le16((uint16_t)Y, &b[8]);
+	sys_put_le16(days, &b[10]);
+	b[12] = (uint8_t)M;
+	b[13] = (uint8_t)D;
+	memcpy(&b[16], "00:00:00|01/01/00", 17);
+	for (int i = 0; i < 5; i++) {
+		sys_put_le16((uint16_t)(30 + i), &b[34 + 2 * i]);
+	}
+	sys_put_le32(PRAY2_HEADER_SIZE, &b[44]);
+	sys_put_le32((uint32_t)days * 10U, &b[48]);
+
+	static const uint16_t base[5] = { 5 * 60, 12 * 60 + 30, 16 * 60, 18 * 60 + 30, 20 * 60 };
+
+	for (uint16_t d = 0; d < days; d++) {
+		for (int p = 0; p < 5; p++) {
+			sys_put_le16(base[p] + (p == 0 ? d : 0),
+				     &b[PRAY2_HEADER_SIZE + d * 10 + p * 2]);
+		}
+	}
+	return len;
+}
+
+static void *suite_setup(void)
+{
+	zassert_equal(pray2_validate_and_parse_no_crc(ref_file, sizeof(ref_file), &ref_hdr),
+		      PRAY2_OK);
+	zassert_equal(ref_hdr.year, 2025);
+	zassert_equal(ref_hdr.days, 365);
+	return NULL;
+}
+
+ZTEST(pray2, test_quick_fire_each)
+{
+	const int Y = 2025, M = 7, D = 2;
+	uint16_t mins[5];
+	uint64_t t0 = budget_start();
+
+	day_minutes(&ref_hdr, Y, M, D, mins);
+	for (int p = 0; p < 5; p++) {
+		int before = mins[p] - 1;
+		int prayer = -1;
+		uint16_t on_sec = 0;
+		pray2_time_t now = at(Y, M, D, before / 60, before % 60);
+
+		zassert_true(pray2_sched_init(&sched, &ref_hdr, &now));
+		zassert_true(tick(Y, M, D, mins[p] / 60, mins[p] % 60, &prayer, &on_sec),
+			     "prayer %d did not fire", p);
+		zassert_equal(prayer, p);
+		zassert_equal(on_sec, ref_hdr.default_on_sec[p]);
+		/* Same minute again: no second fire */
+		zassert_false(tick(Y, M, D, mins[p] / 60, mins[p] % 60, &prayer, &on_sec));
+	}
+	budget_check(t0, BUDGET_MS(5), "quick fire");
+}
+
+ZTEST(pray2, test_full_day_sweep)
+{
+	const int Y = 2025, M = 3, D = 15;
+	uint16_t mins[5];
+	int seen = 0;
+	uint64_t t0 = budget_start();
+	pray2_time_t now = at(Y, M, D, 0, 0);
+
+	day_minutes(&ref_hdr, Y, M, D, mins);
+	zassert_true(pray2_sched_init(&sched, &ref_hdr, &now));
+	for (int m = 1; m < 24 * 60; m++) {
+		int prayer;
+
+		if (tick(Y, M, D, m / 60, m % 60, &prayer, NULL)) {
+			zassert_equal(prayer, seen, "out of order at minute %d", m);
+			zassert_equal(m, mins[prayer], "fired at %d, table says %u", m,
+				      mins[prayer]);
+			seen++;
+		}
+	}
+	zassert_equal(seen, 5);
+	budget_check(t0, BUDGET_MS(20), "full day");
+}
+
+ZTEST(pray2, test_day_rollover)
+{
+	uint64_t t0 = budget_start();
+	pray2_time_t now = at(2025, 1, 31, 23, 55);
+	int Y = 2025, M = 1, D = 31;
+
+	zassert_true(pray2_sched_init(&sched, &ref_hdr, &now));
+	zassert_equal(sweep_day(Y, M, D, 23 * 60 + 56, 23 * 60 + 59), 0);
+
+	advance_one_day(&Y, &M, &D);
+	zassert_equal(M, 2);
+	zassert_equal(D, 1);
+	zassert_equal(sweep_day(Y, M, D, 0, 9), 0);
+	zassert_equal(sched.cur_day_idx, 31);
+	zassert_equal(sched.next_cursor, 0, "new day must start at Fajr");
+	budget_check(t0, BUDGET_MS(5), "rollover");
+}
+
+ZTEST(pray2, test_clock_jump_forward)
+{
+	const int Y = 2025, M = 6, D = 21;
+	uint16_t mins[5];
+	int prayer = -1;
+	uint64_t t0 = budget_start();
+
+	day_minutes(&ref_hdr, Y, M, D, mins);
+	int start = mins[1] - 10;
+	int jump = MIN(mins[4] + 1, 23 * 60 + 59);
+	pray2_time_t now = at(Y, M, D, start / 60, start % 60);
+
+	zassert_true(pray2_sched_init(&sched, &ref_hdr, &now));
+	/* Policy A: only the earliest missed prayer fires */
+	zassert_true(tick(Y, M, D, jump / 60, jump % 60, &prayer, NULL));
+	zassert_equal(prayer, 1, "expected Dhuhr, got %d", prayer);
+	zassert_false(tick(Y, M, D, (jump + 1) / 60, (jump + 1) % 60, &prayer, NULL));
+	zassert_equal(sched.next_cursor, 5);
+	budget_check(t0, BUDGET_MS(5), "clock jump");
+}
+
+ZTEST(pray2, test_out_of_span)
+{
+	size_t len = build_file(2025, 3, 10, 3);
+	pray2_header_t h;
+	uint64_t t0 = budget_start();
+
+	zassert_equal(pray2_validate_and_parse_no_crc(small_file, len, &h), PRAY2_OK);
+
+	pray2_time_t before = at(2025, 3, 9, 4, 0);
+
+	zassert_false(pray2_sched_init(&sched, &h, &before));
+	zassert_equal(sched.cur_day_idx, -1);
+	zassert_equal(sweep_day(2025, 3, 9, 0, 24 * 60 - 1), 0);
+
+	/* Walks into the span, fires, then falls off the end silently */
+	zassert_equal(sweep_day(2025, 3, 10, 0, 24 * 60 - 1), 5);
+	zassert_equal(sweep_day(2025, 3, 13, 0, 24 * 60 - 1), 0);
+	zassert_equal(sched.cur_day_idx, -1);
+	budget_check(t0, BUDGET_MS(40), "out of span");
+}
+
+ZTEST(pray2, test_leap_day)
+{
+	size_t len = build_file(2024, 2, 28, 3);
+	pray2_header_t h;
+	uint16_t mins[5];
+	uint64_t t0 = budget_start();
+
+	zassert_equal(pray2_validate_and_parse_no_crc(small_file, len, &h), PRAY2_OK);
+	zassert_equal(pray2_compute_day_index(&h, 2024, 2, 29), 1);
+	zassert_equal(pray2_compute_day_index(&h, 2024, 3, 1), 2);
+	day_minutes(&h, 2024, 2, 29, mins);
+	zassert_equal(mins[0], 5 * 60 + 1);
+
+	pray2_time_t now = at(2024, 2, 28, 23, 0);
+	int prayer = -1;
+
+	zassert_true(pray2_sched_init(&sched, &h, &now));
+	zassert_equal(sweep_day(2024, 2, 28, 23 * 60 + 1, 24 * 60 - 1), 0);
+	zassert_false(tick(2024, 2, 29, 0, 0, &prayer, NULL));
+	zassert_equal(sweep_day(2024, 2, 29, 1, 5 * 60), 0);
+	zassert_true(tick(2024, 2, 29, 5, 1, &prayer, NULL));
+	zassert_equal(prayer, 0);
+	zassert_equal(sweep_day(2024, 2, 29, 5 * 60 + 2, 24 * 60 - 1), 4);
+	zassert_equal(sweep_day(2024, 3, 1, 0, 24 * 60 - 1), 5);
+	budget_check(t0, BUDGET_MS(40), "leap day");
+}
+
+ZTEST(pray2, test_single_day_file)
+{
+	size_t len = build_file(2025, 12, 31, 1);
+	pray2_header_t h;
+	uint64_t t0 = budget_start();
+
+	zassert_equal(pray2_validate_and_parse_no_crc(small_file, len, &h), PRAY2_OK);
+
+	pray2_time_t now = at(2025, 12, 31, 0, 0);
+
+	zassert_true(pray2_sched_init(&sched, &h, &now));
+	zassert_equal(sweep_day(2025, 12, 31, 1, 24 * 60 - 1), 5);
+	zassert_equal(sweep_day(2026, 1, 1, 0, 24 * 60 - 1), 0);
+	zassert_equal(sched.cur_day_idx, -1);
+	budget_check(t0, BUDGET_MS(40), "single day");
+}
+
+/* Computed days (pray_calc on the device) stand in for days past the table */
+static int day_fn_calls;
+
+static bool fake_day_fn(int year, int month, int day, uint16_t out_minutes[5])
+{
+	static const uint16_t row[5] = { 300, 600, 800, 1000, 1100 };
+
+	day_fn_calls++;
+	if (year == 2026 && month == 1 && day == 3) {
+		return false; /* no times for this day: nothing fires */
+	}
+	memcpy(out_minutes, row, sizeof(row));
+	return true;
+}
+
+ZTEST(pray2, test_day_fn_past_span)
+{
+	size_t len = build_file(2025, 12, 31, 1);
+	pray2_header_t h;
+	uint64_t t0 = budget_start();
+
+	zassert_equal(pray2_validate_and_parse_no_crc(small_file, len, &h), PRAY2_OK);
+
+	pray2_time_t now = at(2025, 12, 31, 0, 0);
+
+	day_fn_calls = 0;
+	zassert_true(pray2_sched_init_ex(&sched, &h, &now, fake_day_fn, NULL, NULL));
+	zassert_equal(day_fn_calls, 0, "table days must not ask day_fn");
+	zassert_equal(sweep_day(2025, 12, 31, 1, 24 * 60 - 1), 5);
+
+	int prayer = -1;
+
+	zassert_equal(sweep_day(2026, 1, 1, 0, 5 * 60 - 1), 0);
+	zassert_true(tick(2026, 1, 1, 5, 0, &prayer, NULL));
+	zassert_equal(prayer, 0);
+	zassert_equal(sched.cur_day_idx, -1);
+	zassert_true(sched.have_today);
+	zassert_equal(sweep_day(2026, 1, 1, 5 * 60 + 1, 24 * 60 - 1), 4);
+	zassert_equal(sweep_day(2026, 1, 2, 0, 24 * 60 - 1), 5);
+	zassert_equal(sweep_day(2026, 1, 3, 0, 24 * 60 - 1), 0);
+	zassert_false(sched.have_today);
+	zassert_equal(day_fn_calls, 3, "one call per day change");
+
+	/* Starting outside the span asks day_fn at once */
+	now = at(2026, 1, 4, 12, 0);
+	zassert_true(pray2_sched_init_ex(&sched, &h, &now, fake_day_fn, NULL, NULL));
+	zassert_equal(sweep_day(2026, 1, 4, 12 * 60 + 1, 24 * 60 - 1), 3);
+	budget_check(t0, BUDGET_MS(40), "day_fn");
+}
+
+ZTEST(pray2, test_location_section)
+{
+	size_t len = build_file(2025, 12, 31, 1) + PRAY2_LOCATION_SIZE;
+	uint8_t *loc = &small_file[PRAY2_HEADER_SIZE];
+	pray2_header_t h;
+
+	zassert_true(len <= sizeof(small_file));
+	memmove(loc + PRAY2_LOCATION_SIZE, loc, 10);
+	small_file[14] |= PRAY2_FLAG_LOCATION;
+	sys_put_le32(PRAY2_HEADER_SIZE + PRAY2_LOCATION_SIZE, &small_file[44]);
+	sys_put_le32((uint32_t)30033000, &loc[0]);
+	sys_put_le32((uint32_t)-40550000, &loc[4]);
+	sys_put_le16((uint16_t)-300, &loc[8]);
+	loc[10] = 2;
+	loc[11] = (uint8_t)-3;
+	loc[15] = 5;
+
+	pray2_location_t l;
+
+	zassert_equal(pray2_validate_and_parse_no_crc(small_file, len, &h), PRAY2_OK);
+	zassert_true(h.has_location);
+	zassert_true(pray2_get_location(&h, &l));
+	zassert_equal(l.lat_udeg, 30033000);
+	zassert_equal(l.lon_udeg, -40550000);
+	zassert_equal(l.utc_offset_min, -300);
+	zassert_equal(l.asr_shadow, 2);
+	zassert_equal(l.offset_min[0], -3);
+	zassert_equal(l.offset_min[4], 5);
+
+	uint16_t mins[5];
+
+	day_minutes(&h, 2025, 12, 31, mins);
+	zassert_equal(mins[0], 5 * 60, "table starts after the section");
+	zassert_equal(mins[4], 20 * 60);
+
+	loc[10] = 3;
+	zassert_equal(pray2_validate_and_parse_no_crc(small_file, len, &h), PRAY2_ERR_LOCATION);
+	loc[10] = 1;
+	sys_put_le32(PRAY2_HEADER_SIZE, &small_file[44]);
+	zassert_equal(pray2_validate_and_parse_no_crc(small_file, len, &h), PRAY2_ERR_LOCATION);
+}
+
+/* The reference year as PRAY3, read through a pray_src_t that counts bytes */
+static uint8_t pray3_file[PRAY3_HEADER_SIZE + 3 * PRAY3_DIR_ENTRY + 366 * 10 + 4];
+static uint32_t src_bytes;
+
+static int counting_read(const pray_src_t *src, uint32_t off, void *buf, uint32_t len)
+{
+	if (off + len > src->size) {
+		return -EINVAL;
+	}
+	memcpy(buf, (const uint8_t *)src->ctx + off, len);
+	src_bytes += len;
+	return 0;
+}
+
+ZTEST(pray2, test_pray3_lazy_source)
+{
+	const uint32_t table = (uint32_t)ref_hdr.days * 10U;
+	const uint32_t dir_end = PRAY3_HEADER_SIZE + 3 * PRAY3_DIR_ENTRY;
+	uint8_t *b = pray3_file;
+
+	memset(b, 0, sizeof(pray3_file));
+	memcpy(b, ref_file, 44); /* span, flags, method, RTC string and durations as PRAY2 */
+	memcpy(b, PRAY3_MAGIC, 5);
+	b[5] = PRAY3_VERSION;
+	sys_put_le16(PRAY3_HEADER_SIZE, &b[6]);
+	b[33] = 3;
+	sys_put_le32(dir_end + table, &b[44]);
+	sys_put_le16(0x40, &b[48]); /* unknown to this reader: skipped */
+	sys_put_le32(dir_end + table, &b[52]);
+	sys_put_le32(4, &b[56]);
+	sys_put_le16(PRAY3_SEC_TIMES, &b[60]);
+	sys_put_le32(dir_end, &b[64]);
+	sys_put_le32(table, &b[68]);
+	sys_put_le16(PRAY3_SEC_CRC, &b[72]);
+	sys_put_le32(dir_end + table, &b[76]);
+	sys_put_le32(4, &b[80]);
+	memcpy(&b[dir_end], ref_hdr.table_ptr, table);
+
+	const pray_src_t src = { .read = counting_read, .size = dir_end + table + 4, .ctx = b };
+	pray2_header_t h;
+
+	src_bytes = 0;
+	zassert_equal(pray_open(&src, &h), PRAY2_OK);
+	zassert_true(src_bytes <= PRAY_HEAD_MAX, "open reads the header and directory only");
+	zassert_equal(h.version, 3);
+	zassert_equal(h.days, ref_hdr.days);
+	zassert_is_null(h.table_ptr);
+	zassert_equal(pray2_payload_size(b, src.size), dir_end + table);
+
+	uint16_t want[5], got[5];
+
+	for (uint16_t i = 0; i < h.days; i++) {
+		zassert_true(pray2_get_day_minutes(&h, i, got));
+		zassert_true(pray2_get_day_minutes(&ref_hdr, i, want));
+		zassert_mem_equal(got, want, sizeof(want));
+	}
+
+	pray2_time_t now = at(2025, 6, 1, 0, 0);
+
+	zassert_true(pray2_sched_init(&sched, &h, &now));
+	src_bytes = 0;
+	zassert_equal(sweep_day(2025, 6, 1, 1, 24 * 60 - 1), 5);
+	zassert_equal(sweep_day(2025, 6, 2, 0, 24 * 60 - 1), 5);
+	zassert_equal(src_bytes, 10, "one row per day change");
+
+	/* The same bytes in RAM parse the same way */
+	zassert_equal(pray2_validate_and_parse_no_crc(b, src.size, &h), PRAY2_OK);
+	zassert_not_null(h.table_ptr);
+
+	b[33] = 0;
+	zassert_equal(pray2_validate_and_parse_no_crc(b, src.size, &h), PRAY2_ERR_SECTION);
+	b[33] = 3;
+	sys_put_le32(table - 10, &b[68]);
+	zassert_equal(pray2_validate_and_parse_no_crc(b, src.size, &h), PRAY2_ERR_TABLE_SIZE);
+}
+
+static uint8_t ovr_file[PRAY3_HEADER_SIZE + PRAY3_DIR_ENTRY + 4 + 3 * PRAY3_OVR_ENTRY];
+
+static void put_override(uint8_t *e, int Y, int M, int D, uint16_t days, uint8_t mask,
+			 uint8_t mode, int16_t value, uint16_t on_sec)
+{
+	sys_put_le32((uint32_t)pray2_days_from_civil(Y, M, D), e);
+	sys_put_le16(days, e + 4);
+	e[6] = mask;
+	e[7] = mode;
+	sys_put_le16((uint16_t)value, e + 8);
+	sys_put_le16(on_sec, e + 10);
+}
+
+ZTEST(pray2, test_overrides_file)
+{
+	const uint32_t sec = PRAY3_HEADER_SIZE + PRAY3_DIR_ENTRY;
+	uint8_t *b = ovr_file;
+
+	/* Overrides only: no days, one OVERRIDES section of three entries */
+	memset(b, 0, sizeof(ovr_file));
+	memcpy(b, ref_file, 44);
+	memcpy(b, PRAY3_MAGIC, 5);
+	b[5] = PRAY3_VERSION;
+	sys_put_le16(PRAY3_HEADER_SIZE, &b[6]);
+	sys_put_le16(0, &b[10]);
+	b[33] = 1;
+	sys_put_le32(sizeof(ovr_file), &b[44]);
+	sys_put_le16(PRAY3_SEC_OVERRIDES, &b[48]);
+	sys_put_le32(sec, &b[52]);
+	sys_put_le32(sizeof(ovr_file) - sec, &b[56]);
+	sys_put_le16(3, &b[sec]);
+	/* Ramadan: Isha +120, Fajr -10 with a longer pulse; then one fixed Dhuhr */
+	put_override(&b[sec + 4], 2025, 3, 1, 30, 0x10, 0, 120, 0);
+	put_override(&b[sec + 16], 2025, 3, 1, 30, 0x01, 0, -10, 90);
+	put_override(&b[sec + 28], 2025, 3, 31, 1, 0x02, PRAY3_OVR_ABSOLUTE, 13 * 60, 120);
+
+	pray2_header_t ovr;
+	pray3_override_t o[PRAY3_OVR_MAX];
+
+	zassert_equal(pray2_validate_and_parse_no_crc(b, sizeof(ovr_file), &ovr), PRAY2_OK);
+	zassert_equal(ovr.days, 0);
+
+	/* No CRC section, yet the payload size must still lie inside the file */
+	pray2_header_t bad;
+
+	sys_put_le32(sizeof(ovr_file) + 1, &b[44]);
+	zassert_equal(pray2_validate_and_parse_no_crc(b, sizeof(ovr_file), &bad), PRAY2_ERR_SECTION);
+	sys_put_le32(sizeof(ovr_file), &b[44]);
+	zassert_equal(pray3_find_overrides(&ovr, (int32_t)pray2_days_from_civil(2025, 2, 28), o, 8), 0);
+	zassert_equal(pray3_find_overrides(&ovr, (int32_t)pray2_days_from_civil(2025, 3, 1), o, 8), 2);
+	zassert_equal(pray3_find_overrides(&ovr, (int32_t)pray2_days_from_civil(2025, 3, 30), o, 8), 2);
+	zassert_equal(pray3_find_overrides(&ovr, (int32_t)pray2_days_from_civil(2025, 3, 31), o, 8), 1);
+	zassert_equal(o[0].value, 13 * 60);
+	zassert_equal(pray3_find_overrides(&ovr, (int32_t)pray2_days_from_civil(2025, 4, 1), o, 8), 0);
+
+	uint16_t row[5];
+	pray2_time_t now = at(2025, 3, 15, 0, 0);
+
+	day_minutes(&ref_hdr, 2025, 3, 15, row);
+	zassert_true(pray2_sched_init_ex(&sched, &ref_hdr, &now, NULL, &ovr, NULL));
+	zassert_equal(sched.today_min[0], row[0] - 10);
+	zassert_equal(sched.today_min[4], row[4] + 120);
+	zassert_equal(sched.today_min[2], row[2]);
+
+	int prayer;
+	uint16_t on_sec;
+	bool fired = tick(2025, 3, 15, sched.today_min[0] / 60, sched.today_min[0] % 60, &prayer, &on_sec);
+
+	zassert_true(fired && prayer == 0);
+	zassert_equal(on_sec, 90, "override pulse");
+	zassert_equal(sched.today_on_set, 0x01, "only Fajr's relay time is the override's");
+	zassert_equal(pray2_sched_relay_ms(&sched, 0, 5000), 90000, "override beats relay_ms");
+	zassert_equal(pray2_sched_relay_ms(&sched, 1, 5000), 5000);
+	zassert_equal(pray2_sched_relay_ms(&sched, 1, 0), ref_hdr.default_on_sec[1] * 1000u);
+	fired = tick(2025, 3, 15, row[1] / 60, row[1] % 60, &prayer, &on_sec);
+	zassert_true(fired && prayer == 1);
+	zassert_equal(on_sec, ref_hdr.default_on_sec[1]);
+
+	/* The day change looks the overrides up again */
+	zassert_equal(sweep_day(2025, 3, 31, 0, 24 * 60 - 1), 5);
+	zassert_equal(sched.today_min[1], 13 * 60);
+	zassert_equal(sched.today_on[1], 120);
+	day_minutes(&ref_hdr, 2025, 4, 1, row);
+	zassert_equal(sweep_day(2025, 4, 1, 0, 24 * 60 - 1), 5);
+	zassert_mem_equal(sched.today_min, row, sizeof(row));
+
+	/* An absolute time past the next prayer keeps the day rising */
+	uint16_t m[5] = {300, 700, 900, 1100, 1200}, on[5] = {0};
+	const pray3_override_t late = {.mask = 0x04, .mode = PRAY3_OVR_ABSOLUTE, .value = 1150};
+
+	pray3_apply_overrides(&late, 1, m, on);
+	zassert_equal(m[2], 1150);
+	zassert_equal(m[3], 1151);
+	zassert_equal(m[4], 1200);
+}
+
+static uint8_t weekly_file[PRAY3_HEADER_SIZE + 2 * PRAY3_DIR_ENTRY + PRAY3_WEEKLY_SIZE + 4 + PRAY3_OVR_ENTRY];
+
+ZTEST(pray2, test_weekly_rules)
+{
+	const uint32_t wk = PRAY3_HEADER_SIZE + 2 * PRAY3_DIR_ENTRY, ov = wk + PRAY3_WEEKLY_SIZE;
+	uint8_t *b = weekly_file;
+
+	/* Fridays: Dhuhr at 13:30 with a 300 s pulse; one Friday moved to 12:45 by date */
+	memset(b, 0, sizeof(weekly_file));
+	memcpy(b, ref_file, 44);
+	memcpy(b, PRAY3_MAGIC, 5);
+	b[5] = PRAY3_VERSION;
+	sys_put_le16(PRAY3_HEADER_SIZE, &b[6]);
+	sys_put_le16(0, &b[10]);
+	b[33] = 2;
+	sys_put_le32(sizeof(weekly_file), &b[44]);
+	sys_put_le16(PRAY3_SEC_WEEKLY, &b[48]);
+	sys_put_le32(wk, &b[52]);
+	sys_put_le32(PRAY3_WEEKLY_SIZE, &b[56]);
+	sys_put_le16(PRAY3_SEC_OVERRIDES, &b[60]);
+	sys_put_le32(ov, &b[64]);
+	sys_put_le32(4 + PRAY3_OVR_ENTRY, &b[68]);
+	b[wk + 5 * PRAY3_WEEKLY_ENTRY] = 0x02;
+	b[wk + 5 * PRAY3_WEEKLY_ENTRY + 1] = PRAY3_OVR_ABSOLUTE;
+	sys_put_le16(13 * 60 + 30, &b[wk + 5 * PRAY3_WEEKLY_ENTRY + 2]);
+	sys_put_le16(300, &b[wk + 5 * PRAY3_WEEKLY_ENTRY + 4]);
+	sys_put_le16(1, &b[ov]);
+	put_override(&b[ov + 4], 2025, 3, 21, 1, 0x02, PRAY3_OVR_ABSOLUTE, 12 * 60 + 45, 0);
+
+	pray2_header_t ovr;
+	pray3_weekly_t w[7];
+
+	zassert_equal(pray2_validate_and_parse_no_crc(b, sizeof(weekly_file), &ovr), PRAY2_OK);
+	zassert_true(pray3_get_weekly(&ovr, w));
+	zassert_equal(w[5].mask, 0x02);
+	zassert_equal(w[5].on_sec, 300);
+	zassert_equal(pray2_weekday(0), 4, "1970-01-01 was a Thursday");
+	zassert_equal(pray2_weekday(-1), 3);
+	zassert_equal(pray2_weekday((int32_t)pray2_days_from_civil(2025, 3, 14)), 5);
+
+	uint16_t row[5];
+	int prayer;
+	uint16_t on_sec;
+	pray2_time_t now = at(2025, 3, 13, 0, 0);
+
+	/* Thursday as the table; the day change to Friday applies the rule */
+	day_minutes(&ref_hdr, 2025, 3, 13, row);
+	zassert_true(pray2_sched_init_ex(&sched, &ref_hdr, &now, NULL, &ovr, NULL));
+	zassert_mem_equal(sched.today_min, row, sizeof(row));
+	day_minutes(&ref_hdr, 2025, 3, 14, row);
+	zassert_equal(sweep_day(2025, 3, 14, 0, 13 * 60 + 29), 1);
+	zassert_equal(sched.today_min[1], 13 * 60 + 30);
+	zassert_equal(sched.today_min[0], row[0]);
+	zassert_true(tick(2025, 3, 14, 13, 30, &prayer, &on_sec) && prayer == 1);
+	zassert_equal(on_sec, 300, "Friday pulse");
+	zassert_equal(sched.today_on_set, 0x02);
+	zassert_equal(pray2_sched_relay_ms(&sched, 1, 5000), 300000, "rule beats relay_ms");
+
+	/* Saturday has no rule; the next Friday's date override wins over it */
+	day_minutes(&ref_hdr, 2025, 3, 15, row);
+	zassert_equal(sweep_day(2025, 3, 15, 0, 24 * 60 - 1), 5);
+	zassert_mem_equal(sched.today_min, row, sizeof(row));
+	zassert_equal(sched.today_on_set, 0);
+	zassert_equal(sweep_day(2025, 3, 21, 0, 24 * 60 - 1), 5);
+	zassert_equal(sched.today_min[1], 12 * 60 + 45);
+	zassert_equal(sched.today_on[1], 300);
+
+	/* The device's Friday rule replaces the file's; edits apply from the next day */
+	pray3_weekly_t dev[7] = {0};
+
+	dev[5] = (pray3_weekly_t){.mask = 0x02, .value = 15};
+	now = at(2025, 3, 28, 0, 0);
+	day_minutes(&ref_hdr, 2025, 3, 28, row);
+	zassert_true(pray2_sched_init_ex(&sched, &ref_hdr, &now, NULL, &ovr, dev));
+	zassert_equal(sched.today_min[1], row[1] + 15);
+	zassert_equal(sched.today_on[1], ref_hdr.default_on_sec[1]);
+	zassert_equal(sched.today_on_set, 0, "a rule without a relay time keeps the file's");
+	dev[6] = (pray3_weekly_t){.mask = 0x10, .value = -5, .on_sec = 30};
+	zassert_equal(sched.today_min[4], row[4]);
+	day_minutes(&ref_hdr, 2025, 3, 29, row);
+	zassert_equal(sweep_day(2025, 3, 29, 0, 24 * 60 - 1), 5);
+	zassert_equal(sched.today_min[4], row[4] - 5);
+	zassert_equal(sched.today_on[4], 30);
+	zassert_equal(sched.today_on_set, 0x10);
+
+	/* A bad WEEKLY size is rejected */
+	sys_put_le32(PRAY3_WEEKLY_SIZE - 1, &b[56]);
+	zassert_equal(pray2_validate_and_parse_no_crc(b, sizeof(weekly_file), &ovr), PRAY2_ERR_SECTION);
+}
+
+ZTEST(pray2, test_full_year_sweep)
+{
+	int Y = 2025, M = 1, D = 1;
+	int fires = 0;
+	int prayer;
+	uint16_t on_sec;
+	uint64_t t0 = budget_start();
+	pray2_time_t now = at(Y, M, D, 0, 0);
+
+	zassert_true(pray2_sched_init(&sched, &ref_hdr, &now));
+	for (int day = 0; day < ref_hdr.days; day++) {
+		for (int m = (day == 0); m < 24 * 60; m++) {
+			fires += tick(Y, M, D, m / 60, m % 60, &prayer, &on_sec);
+		}
+		advance_one_day(&Y, &M, &D);
+	}
+	zassert_equal(fires, 5 * ref_hdr.days);
+	zassert_false(tick(Y, M, D, 0, 0, &prayer, &on_sec), "fired past the span");
+	budget_check(t0, BUDGET_MS(5000), "full year");
+}
+
+ZTEST_SUITE(pray2, NULL, suite_setup, NULL, NULL, NULL);
@@ -0,0 +1,312 @@
+/*
+ * Relay timing of the real firmware on native_sim.
+ *
+ *   west twister -T tests/relay_timing -p native_sim
+ *
+ * The application's main() runs in its own thread on the emulated board (RTC
+ * and OLED emulators, GPIO emulator) through one simulated day of the 2025
+ * Karachi schedule, while the test flips the auto/manual switch at random
+ * moments away from the prayer times. Every relay edge is captured with its
+ * timestamp, then checked:
+ *  - each prayer in auto mode gives one pulse, starting no later than
+ *    CONFIG_RELAY_TIMING_TOLERANCE_MS after its minute and lasting exactly
+ *    the default relay_ms, or for Dhuhr the longer on_sec of the Friday rule;
+ *  - a prayer in manual mode gives no pulse (the relay is held);
+ *  - every other edge is the firmware following a switch change.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/sys/timeutil.h>
+#include <stdlib.h>
+#include "RTCmcp7940_emul.h"
+#include "pray2_reader.h"
+#include "lfs_store.h"
+#include "sd_pray2_io.h"
+#include "app_config.h"
+#include "rtc_oneshot.h"
+
+/* ../../src/main.c, renamed by CMakeLists.txt */
+int relayswitching_main(void);
+
+static const uint8_t ref_file[] = {
+#include "karachi_2025.bin.inc"
+};
+
+/* The simulated day, a Friday; the emulated RTC starts at its midnight. */
+#define DAY_Y 2025
+#define DAY_M 6
+#define DAY_D 13
+#define DAY_MS (24 * 3600 * 1000LL)
+
+/* No switch change this close to a pulse, so each prayer has one mode. */
+#define GUARD_MS 5000
+
+#define TICK_MS k_ticks_to_ms_ceil32(1)
+
+/* The Friday rule: Dhuhr at its table time with this relay time */
+#define FRI_RULE "Dhuhr 0 90"
+#define FRI_ON_SEC 90
+
+static const struct gpio_dt_spec relay = GPIO_DT_SPEC_GET(DT_ALIAS(led1), gpios);
+static const struct gpio_dt_spec sw_mode = GPIO_DT_SPEC_GET(DT_ALIAS(sw0), gpios);
+
+static K_THREAD_STACK_DEFINE(fw_stack, CONFIG_MAIN_STACK_SIZE);
+static struct k_thread fw_thread;
+
+static uint16_t fire_min[5];
+static uint16_t on_sec[5];
+static int64_t toggle_ms[CONFIG_RELAY_TIMING_TOGGLES]; /* since midnight */
+
+/* Relay edges, physical level after the edge; high = relay energised. */
+struct edge {
+	int64_t ms; /* since midnight */
+	bool high;
+};
+
+static struct edge edges[4 * 5 + 2 * CONFIG_RELAY_TIMING_TOGGLES];
+static size_t n_edges;
+static bool relay_high;
+static int64_t midnight_uptime;
+static struct gpio_callback relay_cb;
+
+static void relay_edge(const struct device *port, struct gpio_callback *cb, uint32_t pins)
+{
+	ARG_UNUSED(port);
+	ARG_UNUSED(cb);
+	ARG_UNUSED(pins);
+
+	/* Only changes are reported, so the level just flips. */
+	relay_high = !relay_high;
+	if (n_edges < ARRAY_SIZE(edges)) {
+		edges[n_edges] = (struct edge){ k_uptime_get() - midnight_uptime, relay_high };
+	}
+	n_edges++;
+}
+
+/*
+ * The GPIO emulator reports output changes only on pins that are inputs as
+ * well, so once main() has set the relay pin up, add the input side at the
+ * same level and watch both edges.
+ */
+static void capture_start(void)
+{
+	relay_high = gpio_emul_output_get(relay.port, relay.pin) > 0;
+	zassert_ok(gpio_pin_configure_dt(&relay, GPIO_INPUT |
+					 (relay_high ? GPIO_OUTPUT_HIGH : GPIO_OUTPUT_LOW)));
+	gpio_init_callback(&relay_cb, relay_edge, BIT(relay.pin));
+	zassert_ok(gpio_add_callback(relay.port, &relay_cb));
+	zassert_ok(gpio_pin_interrupt_configure_dt(&relay, GPIO_INT_EDGE_BOTH));
+}
+
+static uint32_t rng_state = CONFIG_RELAY_TIMING_SEED;
+
+static uint32_t rng(void)
+{
+	/* xorshift32: the same switch times on every run and host */
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+static bool toggle_time_ok(int64_t t, size_t placed)
+{
+	for (int i = 0; i < 5; ++i) {
+		int64_t start = fire_min[i] * 60000LL;
+		int64_t end = start + on_sec[i] * 1000LL + CONFIG_RELAY_TIMING_TOLERANCE_MS;
+
+		if (t > start - GUARD_MS && t < end + GUARD_MS) {
+			return false;
+		}
+	}
+	for (size_t i = 0; i < placed; ++i) {
+		if (llabs(t - toggle_ms[i]) < GUARD_MS) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+	int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Switch starts in auto (sim_board.c); each change flips it. */
+static bool manual_at(int64_t ms)
+{
+	bool manual = false;
+
+	for (size_t i = 0; i < ARRAY_SIZE(toggle_ms) && toggle_ms[i] <= ms; ++i) {
+		manual = !manual;
+	}
+	return manual;
+}
+
+static void *relay_timing_setup(void)
+{
+	/* The reference year is the only file in the internal flash library. */
+	struct fs_file_t f;
+
+	zassert_ok(lfs_store_mount());
+	fs_file_t_init(&f);
+	zassert_ok(fs_open(&f, LFS_STORE_ROOT "/k2025.bin", FS_O_CREATE | FS_O_TRUNC | FS_O_WRITE));
+	zassert_equal(fs_write(&f, ref_file, sizeof(ref_file)), sizeof(ref_file));
+	zassert_ok(fs_close(&f));
+	zassert_ok(sd_index_rebuild(LFS_STORE_ROOT));
+
+	/*
+	 * relay_ms stays at its default, Fridays give Dhuhr a longer pulse, the
+	 * switch picks the mode, and the file's one-shot clock counts as applied
+	 * so the RTC stays where the test puts it. Saved before main() loads the
+	 * settings over app_cfg.
+	 */
+	zassert_ok(app_config_init());
+	zassert_true(app_cfg.relay_ms > 0 && FRI_ON_SEC * 1000u > app_cfg.relay_ms);
+	zassert_ok(app_config_set("fri", FRI_RULE));
+	zassert_ok(app_config_set("mode", "0"));
+	zassert_ok(rtc_oneshot_init());
+	zassert_ok(rtc_oneshot_mark(rtc_oneshot_key(ref_file, sizeof(ref_file))));
+	k_sleep(K_MSEC(APP_CFG_SAVE_DELAY_MS + 100));
+
+	pray2_header_t H;
+	zassert_equal(pray2_validate_and_parse_no_crc(ref_file, sizeof(ref_file), &H), PRAY2_OK);
+	int idx = pray2_compute_day_index(&H, DAY_Y, DAY_M, DAY_D);
+	zassert_true(idx >= 0);
+	zassert_true(pray2_get_day_minutes(&H, (uint16_t)idx, fire_min));
+	zassert_equal(pray2_weekday((int32_t)pray2_days_from_civil(DAY_Y, DAY_M, DAY_D)), 5);
+	for (int i = 0; i < 5; ++i) {
+		on_sec[i] = (uint16_t)(app_cfg.relay_ms / 1000u);
+	}
+	on_sec[1] = FRI_ON_SEC;
+
+	/* Random switch changes between 00:01 and 23:59, clear of every pulse. */
+	for (size_t n = 0; n < ARRAY_SIZE(toggle_ms); ) {
+		int64_t t = 60000 + (int64_t)(rng() % (uint32_t)(DAY_MS - 120000));
+
+		if (toggle_time_ok(t, n)) {
+			toggle_ms[n++] = t;
+		}
+	}
+	qsort(toggle_ms, ARRAY_SIZE(toggle_ms), sizeof(toggle_ms[0]), cmp_i64);
+	return NULL;
+}
+
+static void fw_entry(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+	(void)relayswitching_main();
+}
+
+static void sleep_until(int64_t ms)
+{
+	int64_t now = k_uptime_get() - midnight_uptime;
+
+	if (ms > now) {
+		k_sleep(K_MSEC(ms - now));
+	}
+}
+
+/* First unused edge at or after from_ms with the given level, or -1. */
+static int find_edge(const bool *used, int64_t from_ms, int64_t to_ms, bool high)
+{
+	for (size_t i = 0; i < MIN(n_edges, ARRAY_SIZE(edges)); ++i) {
+		if (!used[i] && edges[i].high == high && edges[i].ms >= from_ms &&
+		    edges[i].ms <= to_ms) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+ZTEST(relay_timing, test_simulated_day)
+{
+	struct tm tm = { .tm_year = DAY_Y - 1900, .tm_mon = DAY_M - 1, .tm_mday = DAY_D };
+
+	mcp7940n_emul_set_time(EMUL_DT_GET(DT_NODELABEL(sim_rtc)), timeutil_timegm(&tm));
+	midnight_uptime = k_uptime_get();
+
+	k_thread_create(&fw_thread, fw_stack, K_THREAD_STACK_SIZEOF(fw_stack), fw_entry,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
+	k_thread_name_set(&fw_thread, "main");
+
+	/* main() sets its pins up first thing, then shows the splash screen. */
+	k_sleep(K_MSEC(500));
+	capture_start();
+
+	for (size_t i = 0; i < ARRAY_SIZE(toggle_ms); ++i) {
+		sleep_until(toggle_ms[i]);
+		bool manual = (i % 2) == 0;
+
+		zassert_ok(gpio_emul_input_set(sw_mode.port, sw_mode.pin, manual ? 0 : 1));
+	}
+	sleep_until(DAY_MS);
+	k_thread_suspend(&fw_thread);
+
+	zassert_true(n_edges <= ARRAY_SIZE(edges), "%u relay edges, room for %u",
+		     (unsigned)n_edges, (unsigned)ARRAY_SIZE(edges));
+
+	bool used[ARRAY_SIZE(edges)] = { false };
+	size_t matched = 0;
+	int checked = 0;
+
+	for (int i = 0; i < 5; ++i) {
+		int64_t due = fire_min[i] * 60000LL;
+		int64_t want = on_sec[i] * 1000LL;
+
+		if (manual_at(due)) {
+			zassert_equal(find_edge(used, due - GUARD_MS, due + GUARD_MS, false), -1,
+				      "prayer %d at %02u:%02u: relay released in manual mode",
+				      i, fire_min[i] / 60, fire_min[i] % 60);
+			continue;
+		}
+
+		int on = find_edge(used, due, due + CONFIG_RELAY_TIMING_TOLERANCE_MS, true);
+
+		zassert_true(on >= 0, "prayer %d at %02u:%02u: no pulse within %d ms", i,
+			     fire_min[i] / 60, fire_min[i] % 60, CONFIG_RELAY_TIMING_TOLERANCE_MS);
+		used[on] = true;
+
+		int off = find_edge(used, edges[on].ms, edges[on].ms + want + GUARD_MS, false);
+
+		zassert_true(off >= 0, "prayer %d: pulse never ended", i);
+		used[off] = true;
+
+		int64_t len = edges[off].ms - edges[on].ms;
+
+		TC_PRINT("prayer %d %02u:%02u: on +%lld ms, %lld ms long (on_sec %u)\n", i,
+			 fire_min[i] / 60, fire_min[i] % 60, (long long)(edges[on].ms - due), (long long)len,
+			 on_sec[i]);
+		zassert_true(llabs(len - want) <= TICK_MS, "prayer %d: pulse %lld ms, want %lld",
+			     i, (long long)len, (long long)want);
+		matched += 2;
+		checked++;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(toggle_ms); ++i) {
+		bool manual = (i % 2) == 0;
+		int e = find_edge(used, toggle_ms[i],
+				  toggle_ms[i] + CONFIG_RELAY_TIMING_TOLERANCE_MS, manual);
+
+		zassert_true(e >= 0, "switch to %s at %lld ms: relay did not follow",
+			     manual ? "manual" : "auto", (long long)toggle_ms[i]);
+		used[e] = true;
+		matched++;
+	}
+
+	zassert_equal(matched, n_edges, "%u relay edges, %u explained",
+		      (unsigned)n_edges, (unsigned)matched);
+	TC_PRINT("%d pulses checked, %u switch changes followed\n", checked,
+		 (unsigned)ARRAY_SIZE(toggle_ms));
+}
+
+ZTEST_SUITE(relay_timing, NULL, relay_timing_setup, NULL, NULL, NULL);
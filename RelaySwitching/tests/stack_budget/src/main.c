@@ -0,0 +1,344 @@
+/*
+ * Stack and heap high-water marks of the real firmware on native_sim.
+ *
+ *   west twister -T tests/stack_budget -p native_sim
+ *
+ * Each worst-case path runs on a stack the size of the thread that runs it
+ * in the firmware, which must keep CONFIG_APP_STACK_HEADROOM_PCT unused:
+ *  - upload: the 'f' command (XMODEM, parse, one-shot RTC set, save to the
+ *    library and export to the card) on a CONFIG_MAIN_STACK_SIZE stack, the
+ *    reference file coming in over a fake link;
+ *  - SD and library error paths on the same stack: missing file, file too
+ *    big, no index, not a PRAY2 blob, no file system, no schedule for the
+ *    date, CRC mismatch;
+ *  - the system work queue after a month dump, a computed-days window fill
+ *    (CONFIG_APP_PRAY_CALC), a settings save and an event log flush;
+ *  - the SD service queue after the first mount of a blank card (mkfs) and
+ *    the library sync.
+ * Peak system heap use must stay inside CONFIG_HEAP_MEM_POOL_SIZE by the
+ * same margin.
+ *
+ * These are x86 frames, close to the Cortex-M4 ones but not equal; the
+ * stack_report build target gives the static ARM figures. The main() above
+ * the upload path is not on the test stack, the headroom covers it.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/sys_heap.h>
+#include <zephyr/sys/timeutil.h>
+#include <string.h>
+#include "RTCmcp7940.h"
+#include "RTCmcp7940_emul.h"
+#include "xmodem.h"
+#include "pray2_reader.h"
+#include "lfs_store.h"
+#include "sd_pray2_io.h"
+#include "sd_service.h"
+#include "event_log.h"
+#include "app_config.h"
+#include "rtc_oneshot.h"
+#include "calc_schedule.h"
+
+/* ../../src/main.c; its main() is renamed by CMakeLists.txt and never runs */
+extern const struct device *RTC_MCP;
+extern const char *library_root;
+extern uint8_t DataBuffer[4 * 1024];
+extern uint16_t DataBufferTotalSize;
+void upload_pray2_file(uint8_t (*rx)(uint8_t *, uint16_t, uint32_t),
+		       uint8_t (*tx)(uint8_t, uint32_t));
+pray2_status_t handle_new_pray2_file(const char *rtc);
+void load_pray2_from_sd_and_init(const char *rtc, bool allow_nearest);
+
+extern struct k_heap _system_heap;
+
+static const uint8_t ref_file[] = {
+#include "karachi_2025.bin.inc"
+};
+
+#define REF_BLOCKS DIV_ROUND_UP(sizeof(ref_file), X_PACKET_1024_SIZE)
+#define BAD_ROOT LFS_STORE_ROOT "/bad"
+
+static const struct gpio_dt_spec led = GPIO_DT_SPEC_GET(DT_ALIAS(led0), gpios);
+
+static K_THREAD_STACK_DEFINE(main_stack, CONFIG_MAIN_STACK_SIZE);
+static struct k_thread main_thread;
+
+static void check_budget(const char *what, size_t size, size_t used)
+{
+	size_t budget = size * (100 - CONFIG_APP_STACK_HEADROOM_PCT) / 100;
+
+	TC_PRINT("%-20s %5u of %5u bytes (budget %u)\n", what, (unsigned)used,
+		 (unsigned)size, (unsigned)budget);
+	zassert_true(used <= budget, "%s: %u bytes used, budget %u", what, (unsigned)used,
+		     (unsigned)budget);
+}
+
+static void check_heap(void)
+{
+	struct sys_memory_stats st;
+
+	zassert_ok(sys_heap_runtime_stats_get(&_system_heap.heap, &st));
+	check_budget("system heap", CONFIG_HEAP_MEM_POOL_SIZE, st.max_allocated_bytes);
+}
+
+static void check_thread(const char *what, struct k_thread *thread)
+{
+	size_t unused;
+
+	zassert_ok(k_thread_stack_space_get(thread, &unused));
+	check_budget(what, thread->stack_info.size, thread->stack_info.size - unused);
+}
+
+static void main_entry(void *p1, void *p2, void *p3)
+{
+	void (*fn)(void) = p1;
+	size_t *unused = p2;
+
+	ARG_UNUSED(p3);
+	fn();
+	(void)k_thread_stack_space_get(k_current_get(), unused);
+}
+
+/* Run fn on a freshly painted main-sized stack and check what it used. */
+static void run_on_main_stack(const char *what, void (*fn)(void))
+{
+	size_t unused = 0;
+
+	k_thread_create(&main_thread, main_stack, K_THREAD_STACK_SIZEOF(main_stack), main_entry,
+			fn, &unused, NULL, K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
+	k_thread_name_set(&main_thread, "main");
+	zassert_ok(k_thread_join(&main_thread, K_FOREVER));
+	check_budget(what, main_thread.stack_info.size, main_thread.stack_info.size - unused);
+}
+
+static void write_file(const char *path, const uint8_t *data, size_t len)
+{
+	struct fs_file_t f;
+
+	fs_file_t_init(&f);
+	zassert_ok(fs_open(&f, path, FS_O_CREATE | FS_O_TRUNC | FS_O_WRITE));
+	zassert_equal(fs_write(&f, data, len), len);
+	zassert_ok(fs_close(&f));
+}
+
+/* ---- fake XMODEM link: the sender's side, 1K blocks with CRC16 ---- */
+
+static uint8_t link_buf[REF_BLOCKS * (3 + X_PACKET_1024_SIZE + X_PACKET_CRC_SIZE) + 1];
+static size_t link_len, link_pos, link_acks;
+
+static void link_load(const uint8_t *data, size_t len)
+{
+	link_len = link_pos = link_acks = 0;
+	for (uint8_t blk = 1; len > 0; ++blk) {
+		size_t n = MIN(len, (size_t)X_PACKET_1024_SIZE);
+		uint8_t *payload;
+
+		link_buf[link_len++] = X_STX;
+		link_buf[link_len++] = blk;
+		link_buf[link_len++] = 255u - blk;
+		payload = &link_buf[link_len];
+		memcpy(payload, data, n);
+		memset(payload + n, 0x1A, X_PACKET_1024_SIZE - n); /* CP/M EOF padding */
+		link_len += X_PACKET_1024_SIZE;
+
+		uint16_t crc = crc16_itu_t(0, payload, X_PACKET_1024_SIZE);
+
+		link_buf[link_len++] = crc >> 8;
+		link_buf[link_len++] = crc & 0xFF;
+		data += n;
+		len -= n;
+	}
+	link_buf[link_len++] = X_EOT;
+}
+
+static uint8_t link_rx(uint8_t *buf, uint16_t size, uint32_t timeout)
+{
+	ARG_UNUSED(timeout);
+	if (link_pos + size > link_len) {
+		return 0xFF;
+	}
+	memcpy(buf, &link_buf[link_pos], size);
+	link_pos += size;
+	return 0;
+}
+
+static uint8_t link_tx(uint8_t byte, uint32_t timeout)
+{
+	ARG_UNUSED(timeout);
+	if (byte == X_ACK) {
+		link_acks++;
+	}
+	return 0;
+}
+
+/* ---- paths ---- */
+
+static void upload(void)
+{
+	upload_pray2_file(link_rx, link_tx);
+}
+
+static int err_rc[7];
+
+/* ref_file with a payload byte flipped, trailing CRC left as it was */
+static uint8_t bad_file[sizeof(ref_file)];
+
+static void sd_error_paths(void)
+{
+	struct sd_index_entry entry;
+	enum sd_pray2_crc crc;
+	char path[48];
+	size_t len;
+	int32_t day = (int32_t)pray2_days_from_civil(2025, 6, 15);
+
+	err_rc[0] = sd_load_entire_file(LFS_STORE_ROOT "/NOFILE.BIN", DataBuffer,
+					sizeof(DataBuffer), &len, &crc);
+	err_rc[1] = sd_load_entire_file(LFS_STORE_ROOT "/k2025.bin", DataBuffer, 512, &len, &crc);
+	err_rc[2] = sd_index_lookup(LFS_STORE_ROOT "/none", day, &entry, path, sizeof(path));
+	err_rc[3] = sd_store_pray2_from_ram(LFS_STORE_ROOT, (const uint8_t *)"junk", 4, path,
+					    sizeof(path));
+	err_rc[4] = sd_store_pray2_from_ram("/nofs", ref_file, sizeof(ref_file), path,
+					    sizeof(path));
+	err_rc[5] = sd_store_pray2_from_ram(LFS_STORE_ROOT, bad_file, sizeof(bad_file), path,
+					    sizeof(path));
+	err_rc[6] = sd_import_pray2(BAD_ROOT "/k2025.bin", LFS_STORE_ROOT, "BADIMP.BIN");
+
+	/* Through main.c: no file covers 2030, then the only file is corrupt */
+	load_pray2_from_sd_and_init("12:00:00|15/06/30", false);
+	library_root = BAD_ROOT;
+	load_pray2_from_sd_and_init("12:00:00|15/06/25", false);
+	library_root = LFS_STORE_ROOT;
+}
+
+static K_SEM_DEFINE(synced, 0, 1);
+
+/* What main.c's on_sd_mount() does with the library in flash */
+static bool sync_on_mount(void)
+{
+	int copied = 0;
+
+	(void)lfs_store_sync_from_sd("/SD:", &copied);
+	k_sem_give(&synced);
+	return copied > 0;
+}
+
+static void find_sd_thread(const struct k_thread *thread, void *user_data)
+{
+	const struct k_thread **found = user_data;
+	const char *name = k_thread_name_get((k_tid_t)thread);
+
+	if (name && strcmp(name, "sd_service") == 0) {
+		*found = thread;
+	}
+}
+
+/* ---- tests ---- */
+
+ZTEST(stack_budget, test_upload)
+{
+	struct fs_dirent ent;
+
+	link_load(ref_file, sizeof(ref_file));
+	run_on_main_stack("main: upload", upload);
+
+	zassert_equal(link_acks, REF_BLOCKS + 1, "%u of %u blocks and EOT acked",
+		      (unsigned)link_acks, (unsigned)REF_BLOCKS + 1);
+	zassert_ok(fs_stat(LFS_STORE_ROOT "/S250101.BIN", &ent), "upload not saved");
+	check_heap();
+}
+
+ZTEST(stack_budget, test_sd_errors)
+{
+	struct fs_dirent ent;
+
+	memcpy(bad_file, ref_file, sizeof(bad_file));
+	bad_file[PRAY2_HEADER_SIZE + 1] ^= 0x01;
+	(void)fs_mkdir(BAD_ROOT);
+	write_file(BAD_ROOT "/k2025.bin", bad_file, sizeof(bad_file));
+	zassert_ok(sd_index_rebuild(BAD_ROOT));
+
+	run_on_main_stack("main: SD errors", sd_error_paths);
+
+	zassert_equal(err_rc[0], -ENOENT);
+	zassert_equal(err_rc[1], -EFBIG);
+	zassert_true(err_rc[2] < 0);
+	zassert_equal(err_rc[3], -EINVAL);
+	zassert_true(err_rc[4] < 0);
+	zassert_equal(err_rc[5], -EINVAL, "stored despite its CRC");
+	zassert_equal(err_rc[6], -EINVAL, "imported despite its CRC");
+	zassert_not_equal(fs_stat(LFS_STORE_ROOT "/BADIMP.BIN", &ent), 0);
+	zassert_not_equal(fs_stat(LFS_STORE_ROOT "/BADIMP.BIN.tmp", &ent), 0);
+	check_heap();
+}
+
+ZTEST(stack_budget, test_sd_service)
+{
+	const struct k_thread *sd_thread = NULL;
+
+	sd_service_start(sync_on_mount);
+	zassert_true(k_event_wait(&sd_events, SD_EVT_MOUNTED, false, K_SECONDS(30)) != 0,
+		     "card never mounted");
+	zassert_ok(k_sem_take(&synced, K_SECONDS(30)));
+
+	k_thread_foreach(find_sd_thread, &sd_thread);
+	zassert_not_null(sd_thread);
+	check_thread("sd_service: mount", (struct k_thread *)sd_thread);
+	check_heap();
+}
+
+ZTEST(stack_budget, test_sysworkq)
+{
+	char rtc[24];
+
+	/*
+	 * Month dump after the load, the computed-days window (app_cfg.calc: every
+	 * day is computed), a settings save, a full event log batch
+	 */
+	memcpy(DataBuffer, ref_file, sizeof(ref_file));
+	DataBufferTotalSize = sizeof(ref_file);
+	zassert_ok(RTCmcp7940_get_datetime(RTC_MCP, rtc));
+	if (IS_ENABLED(CONFIG_APP_PRAY_CALC)) {
+		zassert_ok(app_config_set("calc", "1"));
+	}
+	zassert_equal(handle_new_pray2_file(rtc), PRAY2_OK);
+	calc_schedule_prefetch(rtc);
+	zassert_ok(app_config_set("contrast", "200"));
+	for (int i = 0; i < EVLOG_BATCH; ++i) {
+		event_log_post(EVLOG_MODE_CHANGE, i & 1, 0);
+	}
+	k_sleep(K_MSEC(APP_CFG_SAVE_DELAY_MS + 1000));
+	if (IS_ENABLED(CONFIG_APP_PRAY_CALC)) {
+		zassert_ok(app_config_set("calc", "0"));
+	}
+
+	check_thread("sysworkq", &k_sys_work_q.thread);
+	check_heap();
+}
+
+static void *stack_budget_setup(void)
+{
+	struct tm tm = { .tm_year = 2025 - 1900, .tm_mon = 5, .tm_mday = 15, .tm_hour = 12 };
+
+	zassert_ok(lfs_store_mount());
+	write_file(LFS_STORE_ROOT "/k2025.bin", ref_file, sizeof(ref_file));
+	zassert_ok(sd_index_rebuild(LFS_STORE_ROOT));
+
+	/* The one-shot RTC set stays pending, so the upload takes that path too */
+	zassert_ok(app_config_init());
+	zassert_ok(app_config_set("month_dump", "1"));
+	zassert_ok(rtc_oneshot_init());
+	zassert_ok(event_log_init());
+
+	RTC_MCP = DEVICE_DT_GET_ONE(zephyr_rtcmcp7940);
+	zassert_true(device_is_ready(RTC_MCP));
+	mcp7940n_emul_set_time(EMUL_DT_GET(DT_NODELABEL(sim_rtc)), timeutil_timegm(&tm));
+	zassert_ok(gpio_pin_configure_dt(&led, GPIO_OUTPUT_INACTIVE));
+	return NULL;
+}
+
+ZTEST_SUITE(stack_budget, NULL, stack_budget_setup, NULL, NULL, NULL);
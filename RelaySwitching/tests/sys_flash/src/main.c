@@ -0,0 +1,121 @@
+/*
+ * sys_flash on the native_sim flash simulator (scratch_partition).
+ *
+ *   west twister -T tests/sys_flash -p native_sim
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/storage/flash_map.h>
+#include <string.h>
+#include "sys_flash.h"
+
+#define PART_SIZE FIXED_PARTITION_SIZE(scratch_partition)
+
+static uint32_t page;
+static uint8_t pattern[3 * 4096 + 64];
+static uint8_t readback[sizeof(pattern)];
+
+static void *suite_setup(void)
+{
+	struct flash_pages_info info;
+
+	zassert_equal(sys_flash_init(), sys_flash_ok);
+	zassert_ok(flash_get_page_info_by_offs(FIXED_PARTITION_DEVICE(scratch_partition),
+					       FIXED_PARTITION_OFFSET(scratch_partition), &info));
+	page = info.size;
+	zassert_true(PART_SIZE >= 4 * page, "scratch_partition too small");
+	zassert_true(3 * page <= sizeof(pattern), "page size above 4 KiB");
+
+	for (size_t i = 0; i < sizeof(pattern); i++) {
+		pattern[i] = (uint8_t)(i * 7 + 3);
+	}
+	return NULL;
+}
+
+static void before_each(void *fixture)
+{
+	ARG_UNUSED(fixture);
+	zassert_equal(sys_flash_erase(0, PART_SIZE), sys_flash_ok);
+	sys_flash_stats_reset();
+}
+
+ZTEST(sys_flash, test_write_spanning_pages)
+{
+	uint32_t len = 3 * page - 20;
+
+	zassert_equal(sys_flash_write(10, pattern, len), sys_flash_ok);
+	zassert_equal(sys_flash_flush(), sys_flash_ok);
+	zassert_equal(sys_flash_read(10, readback, len), sys_flash_ok);
+	zassert_mem_equal(readback, pattern, len);
+}
+
+ZTEST(sys_flash, test_erase_covers_every_page_and_skips_blank)
+{
+	struct sys_flash_stats st;
+
+	zassert_equal(sys_flash_write(0, pattern, 3 * page), sys_flash_ok);
+	zassert_equal(sys_flash_flush(), sys_flash_ok);
+	sys_flash_stats_reset();
+
+	/* Unaligned range touching three pages */
+	zassert_equal(sys_flash_erase(100, 2 * page), sys_flash_ok);
+	sys_flash_get_stats(&st);
+	zassert_equal(st.erase_pages, 3);
+
+	zassert_equal(sys_flash_read(0, readback, 3 * page), sys_flash_ok);
+	for (uint32_t i = 0; i < 3 * page; i++) {
+		zassert_equal(readback[i], 0xFF, "byte %u not erased", i);
+	}
+
+	/* Already blank: nothing to do */
+	zassert_equal(sys_flash_erase(0, 3 * page), sys_flash_ok);
+	sys_flash_get_stats(&st);
+	zassert_equal(st.erase_pages, 3);
+	zassert_equal(st.erase_skipped, 3);
+}
+
+ZTEST(sys_flash, test_small_writes_are_combined)
+{
+	struct sys_flash_stats st;
+
+	for (int i = 0; i < 64; i++) {
+		zassert_equal(sys_flash_write(i * 16, &pattern[i * 16], 16), sys_flash_ok);
+	}
+	/* Buffered data is visible before the flush */
+	zassert_equal(sys_flash_read(0, readback, 1024), sys_flash_ok);
+	zassert_mem_equal(readback, pattern, 1024);
+
+	zassert_equal(sys_flash_flush(), sys_flash_ok);
+	sys_flash_get_stats(&st);
+	zassert_equal(st.program_ops, 1);
+	zassert_equal(st.erase_pages, 0);
+}
+
+ZTEST(sys_flash, test_overwrite_erases_and_keeps_neighbours)
+{
+	static const uint8_t patch[5] = {1, 2, 3, 4, 5};
+	struct sys_flash_stats st;
+
+	zassert_equal(sys_flash_write(0, pattern, page), sys_flash_ok);
+	zassert_equal(sys_flash_flush(), sys_flash_ok);
+	sys_flash_stats_reset();
+
+	zassert_equal(sys_flash_write(101, patch, sizeof(patch)), sys_flash_ok);
+	zassert_equal(sys_flash_flush(), sys_flash_ok);
+	sys_flash_get_stats(&st);
+	zassert_equal(st.erase_pages, 1);
+
+	zassert_equal(sys_flash_read(0, readback, page), sys_flash_ok);
+	zassert_mem_equal(readback, pattern, 101);
+	zassert_mem_equal(&readback[101], patch, sizeof(patch));
+	zassert_mem_equal(&readback[106], &pattern[106], page - 106);
+}
+
+ZTEST(sys_flash, test_out_of_range_rejected)
+{
+	zassert_equal(sys_flash_write(PART_SIZE - 8, pattern, 16), sys_flash_err);
+	zassert_equal(sys_flash_erase(PART_SIZE - 8, 16), sys_flash_err);
+}
+
+ZTEST_SUITE(sys_flash, NULL, suite_setup, before_each, NULL, NULL);
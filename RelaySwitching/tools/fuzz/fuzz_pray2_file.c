@@ -0,0 +1,141 @@
+// fuzz_pray2_file.c — PRAY2/PRAY3 file blobs through the parser, table and scheduler
+//
+// The input is copied into an exact-size heap buffer so ASan reports any read
+// past the end of what came off the UART/SD. Beyond memory safety it checks
+// the invariants the firmware relies on: every in-span date maps back to its
+// own day index, one day never fires more than five times, and a file opened
+// through a pray_src_t reads the same as the file in RAM.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pray2_reader.h"
+#include "pray2_mutator.h"
+
+#define FUZZ_WALK_DAYS 400  // bound the per-input work
+
+void print_uart(char *buf)
+{
+    (void)buf;
+}
+
+#define check(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);  \
+            abort();                                                                  \
+        }                                                                             \
+    } while (0)
+
+static int buf_read(const pray_src_t *src, uint32_t off, void *out, uint32_t len)
+{
+    if ((uint64_t)off + len > src->size) return -1;
+    memcpy(out, (const uint8_t *)src->ctx + off, len);
+    return 0;
+}
+
+static void check_lazy(const pray2_header_t *ram, const uint8_t *buf, size_t size)
+{
+    const pray_src_t src = {buf_read, (uint32_t)size, (void *)buf};
+    pray2_header_t h;
+    pray2_location_t la, lb;
+    pray3_method_t ma, mb;
+    pray3_dst_t da[8], db[8];
+    uint16_t a[5], b[5];
+
+    check(pray_open(&src, &h) == PRAY2_OK);
+    check(h.days == ram->days && h.table_ptr == NULL);
+    for (uint32_t i = 0; i < h.days && i < FUZZ_WALK_DAYS; i++) {
+        check(pray2_get_day_minutes(ram, (uint16_t)i, a) && pray2_get_day_minutes(&h, (uint16_t)i, b));
+        check(memcmp(a, b, sizeof(a)) == 0);
+    }
+    check(pray2_get_location(ram, &la) == pray2_get_location(&h, &lb));
+    check(pray3_get_method(ram, &ma) == pray3_get_method(&h, &mb));
+    check(pray3_get_dst(ram, da, 8) == pray3_get_dst(&h, db, 8));
+
+    pray3_override_t oa[PRAY3_OVR_MAX], ob[PRAY3_OVR_MAX];
+    const int32_t first = (int32_t)pray2_days_from_civil(h.year, h.start_month, h.start_day);
+    for (int32_t date = first - 2; date < first + 40; date += 3) {
+        const int n = pray3_find_overrides(ram, date, oa, PRAY3_OVR_MAX);
+        check(n >= 0 && n <= PRAY3_OVR_MAX);
+        check(n == pray3_find_overrides(&h, date, ob, PRAY3_OVR_MAX));
+        check(memcmp(oa, ob, (size_t)n * sizeof(oa[0])) == 0);
+    }
+
+    pray3_weekly_t wa[7] = {0}, wb[7] = {0};
+    check(pray3_get_weekly(ram, wa) == pray3_get_weekly(&h, wb));
+    check(memcmp(wa, wb, sizeof(wa)) == 0);
+}
+
+static void run_day(const pray2_header_t *h, int y, int m, int d)
+{
+    pray2_sched_t s;
+    pray2_time_t t = {0, 0, 0, d, m, y};
+    char rtc[18] = "00:00:00|00/00/00";
+    int fires = 0;
+
+    pray2_sched_init(&s, h, &t);
+    rtc[9] = (char)('0' + d / 10);
+    rtc[10] = (char)('0' + d % 10);
+    rtc[12] = (char)('0' + m / 10);
+    rtc[13] = (char)('0' + m % 10);
+    rtc[15] = (char)('0' + y % 100 / 10);
+    rtc[16] = (char)('0' + y % 10);
+    for (int min = 1; min < 24 * 60; min++) {
+        int p;
+        uint16_t on;
+        rtc[0] = (char)('0' + min / 600);
+        rtc[1] = (char)('0' + min / 60 % 10);
+        rtc[3] = (char)('0' + min % 60 / 10);
+        rtc[4] = (char)('0' + min % 10);
+        if (pray2_sched_tick(&s, rtc, &p, &on)) {
+            check(p >= 0 && p < 5);
+            fires++;
+        }
+    }
+    check(fires <= 5);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    uint8_t *buf = malloc(size ? size : 1);
+    if (!buf) return 0;
+    memcpy(buf, data, size);
+
+    pray2_header_t h;
+    (void)pray2_payload_size(buf, size);
+    if (pray2_validate_and_parse_no_crc(buf, size, &h) == PRAY2_OK) {
+        uint16_t mins[5];
+        const uint32_t probe[] = {0, h.days / 2u, h.days ? h.days - 1u : 0u, h.days, 0xFFFFu};
+        for (size_t i = 0; i < sizeof(probe) / sizeof(probe[0]); i++) {
+            check(pray2_get_day_minutes(&h, (uint16_t)probe[i], mins) == (probe[i] < h.days));
+        }
+
+        int y = h.year, m = h.start_month, d = h.start_day;
+        check(d == 1 || pray2_compute_day_index(&h, y, m, d - 1) == -1);
+        for (uint32_t i = 0; i < h.days && i < FUZZ_WALK_DAYS; i++) {
+            check(pray2_compute_day_index(&h, y, m, d) == (int)i);
+            if (i == 0 || i + 1 == h.days) run_day(&h, y, m, d);
+            advance_one_day(&y, &m, &d);
+        }
+
+        pray2_time_t now;
+        pray2_sched_t s;
+        if (pray2_time_parse(h.rtc_ascii, &now) && pray2_sched_init(&s, &h, &now)) {
+            int p;
+            uint16_t on;
+            (void)pray2_sched_tick(&s, h.rtc_ascii, &p, &on);
+        }
+        if (h.days <= FUZZ_WALK_DAYS) debug_print_month_from_header(&h, 1 + (int)(size % 12));
+        check_lazy(&h, buf, size);
+    }
+
+    free(buf);
+    return 0;
+}
+
+size_t LLVMFuzzerCustomMutator(uint8_t *data, size_t size, size_t max_size, unsigned int seed)
+{
+    return pray2_mutate_file(data, size, max_size, seed);
+}
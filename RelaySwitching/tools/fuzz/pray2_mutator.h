@@ -0,0 +1,252 @@
+// pray2_mutator.h — structure-aware mutations for PRAY2/PRAY3 files and RTC strings
+//
+// Purely random bytes almost never get past the magic/version/size checks, so
+// most mutations here keep the header self-consistent and change one thing:
+// the span (days / start date), the table placement, the durations block, the
+// minute values or the embedded RTC string; for PRAY3, one directory entry's
+// type, offset or size, the section count or the payload size. One case in
+// eight falls back to the engine's byte-level mutator to reach the error paths.
+#ifndef PRAY2_MUTATOR_H
+#define PRAY2_MUTATOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// libFuzzer's LLVMFuzzerMutate, or the standalone driver's stand-in.
+size_t LLVMFuzzerMutate(uint8_t *data, size_t size, size_t max_size);
+
+static inline uint32_t fz_rand(uint32_t *s)
+{
+    uint32_t x = *s ? *s : 0x6D2B79F5u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+static inline void fz_put16(uint8_t *p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline void fz_put32(uint8_t *p, uint32_t v) { fz_put16(p, v); fz_put16(p + 2, v >> 16); }
+static inline uint32_t fz_get16(const uint8_t *p) { return p[0] | (uint32_t)p[1] << 8; }
+static inline uint32_t fz_get32(const uint8_t *p) { return fz_get16(p) | fz_get16(p + 2) << 16; }
+
+// Values that sit on the edges of the checks in pray2_reader.h.
+static inline uint32_t fz_edge(uint32_t *s, uint32_t near)
+{
+    static const uint32_t edges[] = {0, 1, 2, 63, 64, 65, 365, 366, 1439, 1440, 0x7FFF, 0xFFFF,
+                                     0x10000, 0x7FFFFFFF, 0x80000000u, 0xFFFFFFFFu};
+    uint32_t r = fz_rand(s);
+    switch (r % 4) {
+    case 0: return edges[(r >> 8) % (sizeof(edges) / sizeof(edges[0]))];
+    case 1: return near + ((r >> 8) % 5) - 2;
+    default: return fz_rand(s);
+    }
+}
+
+// "HH:MM:SS|DD/MM/YY" with fields that are usually in range; returns length written.
+static inline size_t fz_rtc_string(uint32_t *s, char *out, size_t max)
+{
+    char t[18];
+    uint32_t r = fz_rand(s);
+    int v[6] = {(int)(r % 26), (int)((r >> 5) % 62), (int)((r >> 11) % 62),
+                (int)((r >> 17) % 33), (int)((r >> 23) % 14), (int)(fz_rand(s) % 100)};
+    char sep = (fz_rand(s) & 1) ? '/' : ':';
+    for (int i = 0; i < 6; i++) {
+        t[i * 3] = (char)('0' + v[i] / 10 % 10);
+        t[i * 3 + 1] = (char)('0' + v[i] % 10);
+        t[i * 3 + 2] = (i < 2) ? ':' : (i == 2) ? '|' : sep;
+    }
+    uint32_t c = fz_rand(s);
+    if (c % 3 == 0) t[(c >> 4) % 17] = (char)(c >> 12);  // one bad character
+    size_t n = (c % 5 == 0) ? (c >> 20) % 17 : 17;       // or cut short
+    if (n > max) n = max;
+    memcpy(out, t, n);
+    return n;
+}
+
+// A minimal valid file to start from when the input is not one.
+static inline size_t fz_skeleton(uint32_t *s, uint8_t *d, size_t max)
+{
+    uint32_t days = 1 + fz_rand(s) % 8;
+    size_t len = 64 + days * 10;
+    if (len > max) return 0;
+    memset(d, 0, 64);
+    memcpy(d, "PRAY2", 5);
+    d[5] = 2;
+    fz_put16(d + 6, 64);
+    fz_put16(d + 8, 2020 + fz_rand(s) % 10);
+    fz_put16(d + 10, days);
+    d[12] = (uint8_t)(1 + fz_rand(s) % 12);
+    d[13] = (uint8_t)(1 + fz_rand(s) % 28);
+    memcpy(d + 16, "12:00:00|01/01/25", 17);
+    for (int i = 0; i < 5; i++) fz_put16(d + 34 + 2 * i, 30);
+    fz_put32(d + 44, 64);
+    fz_put32(d + 48, days * 10);
+    for (uint32_t i = 0; i < days * 5; i++) fz_put16(d + 64 + 2 * i, 300 + i * 200 % 1140);
+    return len;
+}
+
+// The same as PRAY3: 48-byte header, then a directory of 12-byte entries
+// {u16 type, u16 0, u32 offset, u32 size}: TIMES unless there are no days,
+// OVERRIDES sometimes (always without days) and the CRC section sometimes
+// (left zero; the fuzz target does not check it).
+static inline size_t fz_skeleton3(uint32_t *s, uint8_t *d, size_t max)
+{
+    uint32_t days = fz_rand(s) % 8;  // 0: an overrides-only file
+    uint32_t r = fz_rand(s);
+    bool ovr = days == 0 || (r & 1);
+    bool crc = (r >> 1) & 1;
+    uint32_t count = (days != 0) + ovr + crc;
+    uint32_t off = 48 + count * 12;
+    size_t len = off + days * 10 + (ovr ? 16 : 0) + (crc ? 4 : 0);
+    if (len > max) return 0;
+    memset(d, 0, len);
+    memcpy(d, "PRAY3", 5);
+    d[5] = 3;
+    fz_put16(d + 6, 48);
+    fz_put16(d + 8, 2020 + fz_rand(s) % 10);
+    fz_put16(d + 10, days);
+    d[12] = (uint8_t)(1 + fz_rand(s) % 12);
+    d[13] = (uint8_t)(1 + fz_rand(s) % 28);
+    memcpy(d + 16, "12:00:00|01/01/25", 17);
+    d[33] = (uint8_t)count;
+    for (int i = 0; i < 5; i++) fz_put16(d + 34 + 2 * i, 30);
+
+    uint8_t *e = d + 48;
+    if (days) {
+        fz_put16(e, 1);  // TIMES
+        fz_put32(e + 4, off);
+        fz_put32(e + 8, days * 10);
+        for (uint32_t i = 0; i < days * 5; i++) fz_put16(d + off + 2 * i, 300 + i * 200 % 1140);
+        off += days * 10, e += 12;
+    }
+    if (ovr) {
+        fz_put16(e, 6);  // OVERRIDES: one entry, a day near 2025
+        fz_put32(e + 4, off);
+        fz_put32(e + 8, 16);
+        fz_put16(d + off, 1);
+        fz_put32(d + off + 4, 20089 + fz_rand(s) % 400);
+        fz_put16(d + off + 8, 1 + fz_rand(s) % 30);
+        d[off + 10] = (uint8_t)(1 + fz_rand(s) % 31);
+        off += 16, e += 12;
+    }
+    fz_put32(d + 44, off);  // payload: every byte before the CRC
+    if (crc) {
+        fz_put16(e, 7);
+        fz_put32(e + 4, off);
+        fz_put32(e + 8, 4);
+    }
+    return len;
+}
+
+// One thing changed in a PRAY3 file: a directory entry, the section count, the
+// payload size, the span or the section bytes.
+static inline size_t fz_mutate_pray3(uint32_t *s, uint8_t *d, size_t size, size_t max, uint32_t op)
+{
+    uint32_t count = d[33];
+    uint32_t n = count < 16 && 48 + count * 12 <= size ? count : (uint32_t)(size - 48) / 12;
+    uint8_t *e = d + 48 + (n ? fz_rand(s) % n : 0) * 12;
+
+    switch (op) {
+    case 1:  // a section's offset: before the directory, overlapping, past the end
+        if (n) fz_put32(e + 4, fz_edge(s, fz_get32(e + 4)));
+        return size;
+    case 2:  // a section's size
+        if (n) fz_put32(e + 8, fz_edge(s, fz_get32(e + 8)));
+        return size;
+    case 3:  // a section's type: a duplicate, 0, or newer than the reader
+        if (n) fz_put16(e, (fz_rand(s) & 1) ? fz_rand(s) % 12 : fz_edge(s, fz_get16(e)));
+        return size;
+    case 4:  // the section count, around the directory actually written
+        d[33] = (uint8_t)fz_edge(s, count);
+        return size;
+    case 5:  // the payload size the CRC is taken over
+        fz_put32(d + 44, fz_edge(s, (fz_rand(s) & 1) ? (uint32_t)size : fz_get32(d + 44)));
+        return size;
+    case 6:  // span and start date; the TIMES size no longer matches
+        fz_put16(d + 10, fz_edge(s, fz_get16(d + 10)));
+        if (fz_rand(s) & 1) d[13] = (uint8_t)(fz_rand(s) % 34);
+        return size;
+    default:  // section bytes, or cut or grow
+        if (fz_rand(s) & 1) {
+            for (int k = 0; k < 8 && size > 50; k++) {
+                size_t at = 48 + 2 * (fz_rand(s) % ((size - 48) / 2));
+                fz_put16(d + at, fz_edge(s, fz_get16(d + at)));
+            }
+            return size;
+        }
+        if (fz_rand(s) & 1) return 48 + fz_rand(s) % (size - 47);
+        return size < max ? size + fz_rand(s) % (max - size + 1) : size;
+    }
+}
+
+static inline size_t pray2_mutate_file(uint8_t *d, size_t size, size_t max, unsigned seed)
+{
+    uint32_t s = seed;
+    uint32_t op = fz_rand(&s) % 8;
+
+    if (op == 0) return LLVMFuzzerMutate(d, size, max);
+    if (size >= 48 && memcmp(d, "PRAY3", 5) == 0) return fz_mutate_pray3(&s, d, size, max, op);
+    if (size < 64 || memcmp(d, "PRAY2", 5) != 0) {
+        size_t n = (fz_rand(&s) & 1) ? fz_skeleton3(&s, d, max) : fz_skeleton(&s, d, max);
+        return n ? n : LLVMFuzzerMutate(d, size, max);
+    }
+
+    uint32_t days = fz_get16(d + 10);
+    switch (op) {
+    case 1: {  // new span length, table kept consistent and sized to fit
+        days = fz_edge(&s, days) & 0xFFFF;
+        size_t want = 64 + (size_t)days * 10;
+        if (want > max) days = (uint32_t)((max - 64) / 10), want = 64 + (size_t)days * 10;
+        for (size_t i = size; i + 1 < want; i += 2) fz_put16(d + i, fz_rand(&s) % 1440);
+        fz_put16(d + 10, days);
+        fz_put32(d + 44, 64);
+        fz_put32(d + 48, days * 10);
+        d[14] &= (uint8_t)~0x01u;
+        fz_put32(d + 52, 0);
+        fz_put32(d + 56, 0);
+        return want;
+    }
+    case 2:  // start date, including impossible ones
+        fz_put16(d + 8, (fz_rand(&s) & 1) ? fz_edge(&s, fz_get16(d + 8)) : 1999 + fz_rand(&s) % 103);
+        d[12] = (uint8_t)(fz_rand(&s) % 15);
+        d[13] = (uint8_t)(fz_rand(&s) % 34);
+        return size;
+    case 3: {  // durations block after the table, sometimes wrong
+        d[14] ^= 0x01u;
+        uint32_t off = 64 + days * 10, sz = days * 10;
+        if (fz_rand(&s) & 1) off = fz_edge(&s, off);
+        if (fz_rand(&s) & 1) sz = fz_edge(&s, sz);
+        fz_put32(d + 52, off);
+        fz_put32(d + 56, sz);
+        return size;
+    }
+    case 4:  // table placement
+        fz_put32(d + 44, fz_edge(&s, 64));
+        if (fz_rand(&s) & 1) fz_put32(d + 48, fz_edge(&s, days * 10));
+        return size;
+    case 5:  // minute values, including past midnight and out of order
+        for (int k = 0; k < 8 && size > 66; k++) {
+            size_t at = 64 + 2 * (fz_rand(&s) % ((size - 64) / 2));
+            fz_put16(d + at, fz_edge(&s, 720));
+        }
+        return size;
+    case 6:  // embedded RTC string and flags
+        fz_rtc_string(&s, (char *)d + 16, 17);
+        d[14] ^= (uint8_t)(1u << (fz_rand(&s) % 8));
+        return size;
+    default:  // cut or grow
+        if (fz_rand(&s) & 1) return 64 + fz_rand(&s) % (size - 63);
+        return size < max ? size + fz_rand(&s) % (max - size + 1) : size;
+    }
+}
+
+static inline size_t pray2_mutate_rtc(uint8_t *d, size_t size, size_t max, unsigned seed)
+{
+    uint32_t s = seed;
+    if (fz_rand(&s) % 4 == 0) return LLVMFuzzerMutate(d, size, max);
+    return fz_rtc_string(&s, (char *)d, max);
+}
+
+#endif // PRAY2_MUTATOR_H
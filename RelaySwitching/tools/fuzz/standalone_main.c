@@ -0,0 +1,166 @@
+// standalone_main.c — minimal libFuzzer-compatible driver for toolchains without it
+//
+// Runs every file given (directories are walked one level), then, with
+// -runs=N, N rounds of mutation over that corpus through the target's
+// LLVMFuzzerCustomMutator. No coverage feedback: the structure-aware mutator
+// does the steering. Flags use libFuzzer's spelling so CMake and CI can call
+// either build the same way. Inputs that crash are written to
+// crash-<round> before the sanitizer aborts.
+#include <dirent.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define FUZZ_MAX_INPUT (64 * 1024)
+#define MAX_CORPUS      256
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+size_t LLVMFuzzerCustomMutator(uint8_t *data, size_t size, size_t max_size, unsigned int seed);
+void __sanitizer_set_death_callback(void (*callback)(void));
+
+static struct { uint8_t *data; size_t size; } corpus[MAX_CORPUS];
+static size_t corpus_n;
+static uint32_t rng = 1;
+
+static const uint8_t *cur_data;
+static size_t cur_size;
+static unsigned long cur_round;
+
+static uint32_t next_rand(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+size_t LLVMFuzzerMutate(uint8_t *data, size_t size, size_t max_size)
+{
+    switch (next_rand() % 4) {
+    case 0:  // flip bits
+        if (size) data[next_rand() % size] ^= (uint8_t)(1u << (next_rand() % 8));
+        return size;
+    case 1:  // random byte
+        if (size) data[next_rand() % size] = (uint8_t)next_rand();
+        return size;
+    case 2:  // truncate
+        return size ? next_rand() % size : 0;
+    default:  // append
+        if (size < max_size) data[size++] = (uint8_t)next_rand();
+        return size;
+    }
+}
+
+static void dump_crash(void)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "crash-%lu", cur_round);
+    FILE *f = fopen(name, "wb");
+    if (!f) return;
+    fwrite(cur_data, 1, cur_size, f);
+    fclose(f);
+    fprintf(stderr, "standalone: input written to %s (%zu bytes)\n", name, cur_size);
+}
+
+// check() failures abort() without going through the sanitizer runtime.
+static void on_abort(int sig)
+{
+    dump_crash();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void run_one(const uint8_t *data, size_t size)
+{
+    cur_data = data;
+    cur_size = size;
+    (void)LLVMFuzzerTestOneInput(data, size);
+}
+
+static void add_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "standalone: cannot open %s\n", path);
+        exit(1);
+    }
+    uint8_t *buf = malloc(FUZZ_MAX_INPUT);
+    size_t n = fread(buf, 1, FUZZ_MAX_INPUT, f);
+    fclose(f);
+
+    run_one(buf, n);
+    if (corpus_n < MAX_CORPUS) {
+        corpus[corpus_n].data = buf;
+        corpus[corpus_n].size = n;
+        corpus_n++;
+    } else {
+        free(buf);
+    }
+}
+
+static void add_path(const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "standalone: no such file %s\n", path);
+        exit(1);
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        add_file(path);
+        return;
+    }
+    DIR *dir = opendir(path);
+    struct dirent *e;
+    while (dir && (e = readdir(dir)) != NULL) {
+        char sub[1024];
+        if (e->d_name[0] == '.') continue;
+        snprintf(sub, sizeof(sub), "%s/%s", path, e->d_name);
+        if (stat(sub, &st) == 0 && S_ISREG(st.st_mode)) add_file(sub);
+    }
+    if (dir) closedir(dir);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long runs = 0;
+
+    __sanitizer_set_death_callback(dump_crash);
+    signal(SIGABRT, on_abort);
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0) {
+            runs = strtoul(argv[i] + 6, NULL, 0);
+        } else if (strncmp(argv[i], "-seed=", 6) == 0) {
+            rng = (uint32_t)strtoul(argv[i] + 6, NULL, 0);
+            if (!rng) rng = 1;
+        } else if (argv[i][0] == '-') {
+            continue;  // other libFuzzer flags have no meaning here
+        } else {
+            add_path(argv[i]);
+        }
+    }
+    printf("standalone: %zu corpus inputs OK\n", corpus_n);
+
+    static uint8_t buf[FUZZ_MAX_INPUT];
+    size_t size = 0;
+    for (cur_round = 0; cur_round < runs; cur_round++) {
+        // Restart from a corpus entry now and then so runs don't drift off.
+        if (cur_round % 64 == 0 && corpus_n) {
+            size_t k = next_rand() % corpus_n;
+            size = corpus[k].size;
+            memcpy(buf, corpus[k].data, size);
+        }
+        size = LLVMFuzzerCustomMutator(buf, size, sizeof(buf), next_rand());
+
+        uint8_t *exact = malloc(size ? size : 1);
+        memcpy(exact, buf, size);
+        run_one(exact, size);
+        free(exact);
+    }
+    if (runs) printf("standalone: %lu mutated inputs OK\n", runs);
+
+    for (size_t i = 0; i < corpus_n; i++) free(corpus[i].data);
+    return 0;
+}
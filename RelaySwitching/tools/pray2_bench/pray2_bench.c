@@ -0,0 +1,69 @@
+// pray2_bench.c — host runner for the PRAY2 kernel benchmarks (pray2_bench.h)
+//
+//   pray2_bench [file.bin] [--iters N] [--out results.json]
+//
+// Times with CLOCK_MONOTONIC; JSON goes to stdout or --out. The same kernels
+// run on target from tests/benchmarks/pray2 with k_cycle_get_32().
+#include <stdlib.h>
+#include <time.h>
+
+#include "pray2_bench.h"
+
+static uint8_t file_buf[1u << 20];
+static uint8_t scratch[PRAY2_BENCH_SCRATCH];
+static struct pray2_bench_input inputs[2];
+static FILE *out;
+
+void print_uart(char *buf)
+{
+    fputs(buf, stderr);
+}
+
+static uint64_t host_now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+static void host_emit(const char *line)
+{
+    fprintf(out, "%s\n", line);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = PRAY2_BENCH_DEFAULT_FILE;
+    const char *out_path = NULL;
+    struct pray2_bench_io io = {
+        .target = "host",
+        .now = host_now,
+        .clock_hz = 1000000000u,
+        .iters = 1000000,
+        .emit = host_emit,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) io.iters = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) out_path = argv[++i];
+        else if (argv[i][0] != '-') path = argv[i];
+        else {
+            fputs("usage: pray2_bench [file.bin] [--iters N] [--out results.json]\n", stderr);
+            return 2;
+        }
+    }
+    if (io.iters == 0) io.iters = 1;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return 2; }
+    size_t len = fread(file_buf, 1, sizeof(file_buf), f);
+    fclose(f);
+
+    out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) { perror(out_path); return 2; }
+
+    int rc = pray2_bench_run(&io, file_buf, len, scratch, inputs);
+    if (out != stdout) fclose(out);
+    if (rc) fprintf(stderr, "%s: not a usable 1-year PRAY2 file\n", path);
+    return rc ? 1 : 0;
+}
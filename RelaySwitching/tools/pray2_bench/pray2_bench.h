@@ -0,0 +1,311 @@
+// pray2_bench.h — PRAY2 kernel benchmarks shared by the host tool and the
+// on-target app (tests/benchmarks/pray2)
+//
+// The caller supplies a clock and a line printer in struct pray2_bench_io and a
+// 1-year PRAY2 file; results go out as one JSON object:
+//
+//   {"target":"...","clock_hz":...,"results":[
+//     {"name":"sched_tick","input":"10y-jumps","iters":...,"ns_per_op":...,
+//      "cycles_per_op":...}, ...]}
+//
+// cycles_per_op is only given when the clock counts CPU cycles
+// (k_cycle_get_32() on target); the host clock is nanoseconds.
+//
+// Inputs are generated before timing with a fixed-seed xorshift, so runs are
+// comparable. The 10-year table is the 1-year table tiled ten times in
+// `scratch`, which must hold PRAY2_BENCH_SCRATCH bytes.
+#ifndef PRAY2_BENCH_H
+#define PRAY2_BENCH_H
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "pray2_reader.h"
+#include "pray_calc.h"
+
+#define PRAY2_BENCH_YEARS    10
+#define PRAY2_BENCH_SCRATCH  (PRAY2_HEADER_SIZE + 366u * 10u * PRAY2_BENCH_YEARS)
+#define PRAY2_BENCH_RANDOM   128  // random dates / RTC strings per input set
+
+struct pray2_bench_io {
+    const char *target;
+    uint64_t (*now)(void);     // monotonic ticks
+    uint64_t clock_hz;         // ticks per second
+    bool clock_is_cycles;
+    bool clock_wraps32;        // now() is a 32-bit counter: deltas taken mod 2^32
+    uint32_t iters;            // iterations per case
+    void (*emit)(const char *line);
+};
+
+struct pray2_bench_input {
+    const uint8_t *file;
+    size_t len;
+    pray2_header_t hdr;
+    const char *label;           // "1y" / "10y"
+    int dates[PRAY2_BENCH_RANDOM][3];
+    char rtc[PRAY2_BENCH_RANDOM][18];
+};
+
+static volatile uint32_t pray2_bench_sink;
+
+static inline uint32_t pray2_bench_rand(uint32_t *s)
+{
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+static inline void pray2_bench_put2(char *p, int v)
+{
+    p[0] = (char)('0' + v / 10);
+    p[1] = (char)('0' + v % 10);
+}
+
+static inline void pray2_bench_rtc(char s[18], int Y, int M, int D, int hh, int mm, int ss)
+{
+    memcpy(s, "00:00:00|00/00/00", 18);
+    pray2_bench_put2(&s[0], hh);
+    pray2_bench_put2(&s[3], mm);
+    pray2_bench_put2(&s[6], ss);
+    pray2_bench_put2(&s[9], D);
+    pray2_bench_put2(&s[12], M);
+    pray2_bench_put2(&s[15], Y % 100);
+}
+
+// Random in-span dates and RTC strings, sorted by nothing: every tick is a jump.
+static inline void pray2_bench_fill(struct pray2_bench_input *in, uint32_t seed)
+{
+    for (int i = 0; i < PRAY2_BENCH_RANDOM; i++) {
+        int y = in->hdr.year, m = in->hdr.start_month, d = in->hdr.start_day;
+        uint32_t skip = pray2_bench_rand(&seed) % in->hdr.days;
+        // advance_one_day() is what the firmware uses; fine outside timing.
+        while (skip--) advance_one_day(&y, &m, &d);
+        in->dates[i][0] = y;
+        in->dates[i][1] = m;
+        in->dates[i][2] = d;
+        uint32_t sec = pray2_bench_rand(&seed) % 86400u;
+        pray2_bench_rtc(in->rtc[i], y, m, d, (int)(sec / 3600), (int)(sec / 60 % 60), (int)(sec % 60));
+    }
+}
+
+// ---- kernels: each runs `n` operations and returns something to sink ----
+
+static uint32_t k_validate(const struct pray2_bench_input *in, uint32_t n)
+{
+    uint32_t acc = 0;
+    pray2_header_t h = {0};
+    for (uint32_t i = 0; i < n; i++) acc += pray2_validate_and_parse_no_crc(in->file, in->len, &h) + h.days;
+    return acc;
+}
+
+static uint32_t k_parse_rtc(const struct pray2_bench_input *in, uint32_t n)
+{
+    uint32_t acc = 0;
+    int hh = 0, mm, ss, DD = 0, MO, YY;
+    for (uint32_t i = 0; i < n; i++) {
+        acc += pray2_parse_rtc_ascii(in->rtc[i % PRAY2_BENCH_RANDOM], &hh, &mm, &ss, &DD, &MO, &YY);
+        acc += (uint32_t)(hh + DD);
+    }
+    return acc;
+}
+
+static uint32_t k_days_from_civil(const struct pray2_bench_input *in, uint32_t n)
+{
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const int *d = in->dates[i % PRAY2_BENCH_RANDOM];
+        acc += (uint32_t)pray2_days_from_civil(d[0], (unsigned)d[1], (unsigned)d[2]);
+    }
+    return acc;
+}
+
+static uint32_t k_day_index(const struct pray2_bench_input *in, uint32_t n)
+{
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const int *d = in->dates[i % PRAY2_BENCH_RANDOM];
+        acc += (uint32_t)pray2_compute_day_index(&in->hdr, d[0], d[1], d[2]);
+    }
+    return acc;
+}
+
+static uint32_t k_day_minutes(const struct pray2_bench_input *in, uint32_t n)
+{
+    uint32_t acc = 0, seed = 0x9E3779B9u;
+    uint16_t mins[5] = {0};
+    for (uint32_t i = 0; i < n; i++) {
+        // Index from a cheap LCG so the table walk is not sequential.
+        seed = seed * 1664525u + 1013904223u;
+        acc += pray2_get_day_minutes(&in->hdr, (uint16_t)((seed >> 8) % in->hdr.days), mins) + mins[4];
+    }
+    return acc;
+}
+
+// Minute-by-minute from the start of the span, as the device sees a normal day,
+// back to the start after the last day so any n stays inside the table.
+// Includes patching the RTC string (a few stores), as main.c formats one too.
+static uint32_t k_tick_steady(const struct pray2_bench_input *in, uint32_t n)
+{
+    static pray2_sched_t s;
+    pray2_time_t t0 = {0, 0, 0, in->hdr.start_day, in->hdr.start_month, in->hdr.year};
+    int Y = in->hdr.year, M = in->hdr.start_month, D = in->hdr.start_day, min = 0;
+    uint32_t day = 0;
+    char rtc[18];
+    uint32_t acc = 0;
+
+    pray2_sched_init(&s, &in->hdr, &t0);
+    pray2_bench_rtc(rtc, Y, M, D, 0, 0, 0);
+    for (uint32_t i = 0; i < n; i++) {
+        if (++min == 24 * 60) {
+            min = 0;
+            if (++day == in->hdr.days) {
+                day = 0;
+                Y = in->hdr.year, M = in->hdr.start_month, D = in->hdr.start_day;
+            } else {
+                advance_one_day(&Y, &M, &D);
+            }
+            pray2_bench_put2(&rtc[9], D);
+            pray2_bench_put2(&rtc[12], M);
+            pray2_bench_put2(&rtc[15], Y % 100);
+        }
+        pray2_bench_put2(&rtc[0], min / 60);
+        pray2_bench_put2(&rtc[3], min % 60);
+        int p;
+        uint16_t on;
+        acc += pray2_sched_tick(&s, rtc, &p, &on);
+    }
+    return acc;
+}
+
+// Every tick lands on a random day and time: day change path each call.
+static uint32_t k_tick_jumps(const struct pray2_bench_input *in, uint32_t n)
+{
+    static pray2_sched_t s;
+    pray2_time_t t0 = {0, 0, 0, in->hdr.start_day, in->hdr.start_month, in->hdr.year};
+    uint32_t acc = 0;
+
+    pray2_sched_init(&s, &in->hdr, &t0);
+    for (uint32_t i = 0; i < n; i++) {
+        int p;
+        uint16_t on;
+        acc += pray2_sched_tick(&s, in->rtc[i % PRAY2_BENCH_RANDOM], &p, &on);
+    }
+    return acc;
+}
+
+// One computed table row (pray_calc_day()) at the reference file's location
+// and method, random dates: the cost the calc mode pays once per day.
+static uint32_t k_calc_day(const struct pray2_bench_input *in, uint32_t n)
+{
+    static const struct pray_calc_params p = {
+        .lat = 30.033f, .lon = 40.55f, .utc_offset_min = 300,
+        .method = PRAY_METHOD_KARACHI, .asr_shadow = 1,
+    };
+    uint32_t acc = 0;
+    uint16_t mins[5] = {0};
+    for (uint32_t i = 0; i < n; i++) {
+        const int *d = in->dates[i % PRAY2_BENCH_RANDOM];
+        acc += pray_calc_day(&p, d[0], d[1], d[2], mins) + mins[4];
+    }
+    return acc;
+}
+
+struct pray2_bench_case {
+    const char *name;
+    const char *input;  // suffix after the table label
+    uint32_t (*run)(const struct pray2_bench_input *in, uint32_t n);
+    uint8_t tables;     // bit0: 1y, bit1: 10y
+};
+
+static const struct pray2_bench_case pray2_bench_cases[] = {
+    {"validate_and_parse_no_crc", "", k_validate, 3},
+    {"parse_rtc_ascii", "random", k_parse_rtc, 1},
+    {"days_from_civil", "random", k_days_from_civil, 1},
+    {"compute_day_index", "random", k_day_index, 3},
+    {"get_day_minutes", "random", k_day_minutes, 3},
+    {"sched_tick", "minutes", k_tick_steady, 3},
+    {"sched_tick", "jumps", k_tick_jumps, 3},
+    {"pray_calc_day", "random", k_calc_day, 1},
+};
+
+static void pray2_bench_result(const struct pray2_bench_io *io, const struct pray2_bench_case *c,
+                               const char *table, uint64_t ticks, bool first)
+{
+    char line[200];
+    uint64_t ops = io->iters;
+    // Fixed point, tenths of a nanosecond; no float formatting needed on target.
+    uint64_t ns10 = ticks * 10000u / ops * 1000000u / io->clock_hz;
+    int n = snprintf(line, sizeof(line),
+                     "%s{\"name\":\"%s\",\"input\":\"%s%s%s\",\"iters\":%" PRIu32
+                     ",\"ns_per_op\":%" PRIu64 ".%" PRIu64,
+                     first ? "" : ",", c->name, table, c->input[0] ? "-" : "", c->input, io->iters,
+                     ns10 / 10, ns10 % 10);
+    if (io->clock_is_cycles && n > 0 && (size_t)n < sizeof(line)) {
+        uint64_t cyc10 = ticks * 10 / ops;
+        snprintf(line + n, sizeof(line) - (size_t)n, ",\"cycles_per_op\":%" PRIu64 ".%" PRIu64 "}",
+                 cyc10 / 10, cyc10 % 10);
+    } else if (n > 0 && (size_t)n < sizeof(line)) {
+        snprintf(line + n, sizeof(line) - (size_t)n, ",\"cycles_per_op\":null}");
+    }
+    io->emit(line);
+}
+
+// Runs every case on the 1-year file and on the 10-year tile built in scratch.
+// Returns 0, or -1 if the file does not validate or cannot be tiled.
+static int pray2_bench_run(const struct pray2_bench_io *io, const uint8_t *file, size_t len,
+                           uint8_t *scratch, struct pray2_bench_input in[2])
+{
+    char line[160];
+
+    in[0].file = file;
+    in[0].len = len;
+    in[0].label = "1y";
+    if (pray2_validate_and_parse_no_crc(file, len, &in[0].hdr) != PRAY2_OK) return -1;
+    if ((in[0].hdr.flags & 0x01u) || (uint32_t)in[0].hdr.days * PRAY2_BENCH_YEARS > 0xFFFFu) return -1;
+
+    // Tile the table; the header keeps the start date, only days/size change.
+    size_t table = (size_t)in[0].hdr.days * 10u;
+    uint32_t days = (uint32_t)in[0].hdr.days * PRAY2_BENCH_YEARS;
+    if (PRAY2_HEADER_SIZE + table * PRAY2_BENCH_YEARS > PRAY2_BENCH_SCRATCH) return -1;
+    memcpy(scratch, file, PRAY2_HEADER_SIZE);
+    scratch[10] = (uint8_t)days;
+    scratch[11] = (uint8_t)(days >> 8);
+    uint32_t size = days * 10u;
+    for (int b = 0; b < 4; b++) scratch[48 + b] = (uint8_t)(size >> (8 * b));
+    for (int y = 0; y < PRAY2_BENCH_YEARS; y++) {
+        memcpy(scratch + PRAY2_HEADER_SIZE + table * (size_t)y, in[0].hdr.table_ptr, table);
+    }
+    in[1].file = scratch;
+    in[1].len = PRAY2_HEADER_SIZE + table * PRAY2_BENCH_YEARS;
+    in[1].label = "10y";
+    if (pray2_validate_and_parse_no_crc(in[1].file, in[1].len, &in[1].hdr) != PRAY2_OK) return -1;
+
+    pray2_bench_fill(&in[0], 0x2545F491u);
+    pray2_bench_fill(&in[1], 0x2545F491u);
+
+    snprintf(line, sizeof(line), "{\"target\":\"%s\",\"clock_hz\":%" PRIu64 ",\"results\":[",
+             io->target, io->clock_hz);
+    io->emit(line);
+
+    bool first = true;
+    for (size_t i = 0; i < sizeof(pray2_bench_cases) / sizeof(pray2_bench_cases[0]); i++) {
+        const struct pray2_bench_case *c = &pray2_bench_cases[i];
+        for (int t = 0; t < 2; t++) {
+            if (!(c->tables & (1u << t))) continue;
+            pray2_bench_sink += c->run(&in[t], io->iters / 16 + 1);  // warm caches
+            uint64_t t0 = io->now();
+            pray2_bench_sink += c->run(&in[t], io->iters);
+            uint64_t ticks = io->now() - t0;
+            if (io->clock_wraps32) ticks &= 0xFFFFFFFFu;
+            pray2_bench_result(io, c, in[t].label, ticks, first);
+            first = false;
+        }
+    }
+    io->emit("]}");
+    return 0;
+}
+
+#endif // PRAY2_BENCH_H
@@ -0,0 +1,359 @@
+// pray2_sim.c — host simulator: run pray2_sched_tick() across a whole file span
+//
+//   pray2_sim <file.bin> [--csv times.csv] [--log fires.txt|-]
+//             [--step second|minute|event] [--repeat N] [--max-wall-ms MS]
+//
+// Feeds the scheduler RTC strings exactly as main.c does, from 00:00:00 on the
+// first day of the span to 23:59:59 on the last, and records every fire. The
+// fire log is then diffed against the .bin table (every day must fire its five
+// minutes, in order, once) and, with --csv, against the generator's CSV.
+//
+//   second  1 Hz, like the device loop
+//   minute  one tick per minute; the scheduler only acts on minute edges
+//   event   day start plus each table minute; fastest, but driven by the table
+//
+// --repeat N tiles the table N times to time a longer span (CSV is only
+// compared for the dates it lists). Exit status is 0 only when nothing differs
+// and the run finished within --max-wall-ms.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pray2_reader.h"
+
+#define SIM_MAX_FILE (1u << 20)
+#define SIM_MAX_SHOW 20
+
+static const char *const PRAYER_NAME[5] = {"Fajr", "Dhuhr", "Asr", "Maghrib", "Isha"};
+
+struct fire {
+    int32_t day;      // index into the span
+    uint16_t minute;  // minute of day the tick saw
+    uint8_t prayer;
+    uint16_t on_sec;
+};
+
+static struct fire *fires;
+static size_t n_fires, cap_fires;
+
+void print_uart(char *buf)
+{
+    fputs(buf, stderr);
+}
+
+static double wall_s(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+static void put2(char *p, int v)
+{
+    p[0] = (char)('0' + v / 10);
+    p[1] = (char)('0' + v % 10);
+}
+
+static uint32_t crc32_zlib(const uint8_t *p, size_t n)
+{
+    uint32_t c = 0xFFFFFFFFu;
+    while (n--) {
+        c ^= *p++;
+        for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1u)));
+    }
+    return ~c;
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return NULL; }
+    uint8_t *buf = malloc(SIM_MAX_FILE);
+    *len = buf ? fread(buf, 1, SIM_MAX_FILE, f) : 0;
+    fclose(f);
+    return buf;
+}
+
+// Tile the day table `times` times; durations (flags bit0) are not supported.
+static uint8_t *repeat_table(const uint8_t *buf, const pray2_header_t *h, int times, size_t *len)
+{
+    uint32_t days = (uint32_t)h->days * (uint32_t)times;
+    if ((h->flags & 0x01u) || days > 0xFFFFu) return NULL;
+
+    size_t table = (size_t)h->days * 10u;
+    uint8_t *out = malloc(PRAY2_HEADER_SIZE + table * (size_t)times);
+    if (!out) return NULL;
+    memcpy(out, buf, PRAY2_HEADER_SIZE);
+    out[10] = (uint8_t)days;
+    out[11] = (uint8_t)(days >> 8);
+    uint32_t size = days * 10u, off = PRAY2_HEADER_SIZE;
+    memcpy(out + 44, &off, 4);   // host is little-endian like the target
+    memcpy(out + 48, &size, 4);
+    for (int i = 0; i < times; i++) memcpy(out + PRAY2_HEADER_SIZE + table * i, h->table_ptr, table);
+    *len = PRAY2_HEADER_SIZE + table * (size_t)times;
+    return out;
+}
+
+static void record(int32_t day, int minute, int prayer, uint16_t on_sec)
+{
+    if (n_fires == cap_fires) {
+        cap_fires = cap_fires ? cap_fires * 2 : 4096;
+        fires = realloc(fires, cap_fires * sizeof(*fires));
+        if (!fires) { fputs("out of memory\n", stderr); exit(2); }
+    }
+    fires[n_fires++] = (struct fire){day, (uint16_t)minute, (uint8_t)prayer, on_sec};
+}
+
+enum step { STEP_SECOND, STEP_MINUTE, STEP_EVENT };
+
+// Returns simulated seconds covered.
+static uint64_t simulate(const pray2_header_t *h, enum step step)
+{
+    static pray2_sched_t sched;
+    char rtc[18] = "00:00:00|00/00/00";
+    int Y = h->year, M = h->start_month, D = h->start_day;
+    pray2_time_t start = {0, 0, 0, D, M, Y};
+
+    pray2_sched_init(&sched, h, &start);
+
+    for (int32_t day = 0; day < h->days; day++) {
+        uint16_t mins[5];
+        pray2_get_day_minutes(h, (uint16_t)day, mins);
+        put2(&rtc[9], D);
+        put2(&rtc[12], M);
+        put2(&rtc[15], Y % 100);
+
+        int ev = 0;
+        for (int m = 0; m < 24 * 60; m++) {
+            if (step == STEP_EVENT) {
+                // Day start, then jump from table minute to table minute.
+                if (m != 0) {
+                    while (ev < 5 && mins[ev] < m) ev++;
+                    if (ev == 5) break;
+                    m = mins[ev];
+                }
+            }
+            put2(&rtc[0], m / 60);
+            put2(&rtc[3], m % 60);
+            int secs = (step == STEP_SECOND) ? 60 : 1;
+            for (int s = 0; s < secs; s++) {
+                int prayer;
+                uint16_t on_sec;
+                put2(&rtc[6], s);
+                if (pray2_sched_tick(&sched, rtc, &prayer, &on_sec)) record(day, m, prayer, on_sec);
+            }
+        }
+        advance_one_day(&Y, &M, &D);
+    }
+    return (uint64_t)h->days * 86400u;
+}
+
+static void fmt_date(const pray2_header_t *h, int32_t day, char out[24])
+{
+    int64_t d0 = pray2_days_from_civil(h->year, h->start_month, h->start_day) + day;
+    // civil_from_days (Hinnant)
+    int64_t z = d0 + 719468, era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100), mp = (5 * doy + 2) / 153;
+    unsigned dd = doy - (153 * mp + 2) / 5 + 1, mm = mp < 10 ? mp + 3 : mp - 9;
+    int yy = (int)(yoe + era * 400) + (mm <= 2);
+    snprintf(out, 24, "%04d-%02u-%02u", yy, mm, dd);
+}
+
+// Every day must fire its five table minutes once, in order, with the header's
+// default_on_sec (what pray2_sched_tick() reports).
+static size_t diff_against_bin(const pray2_header_t *h)
+{
+    size_t bad = 0, k = 0;
+    char date[24];
+
+    for (int32_t day = 0; day < h->days; day++) {
+        uint16_t mins[5];
+        pray2_get_day_minutes(h, (uint16_t)day, mins);
+        for (int p = 0; p < 5; p++) {
+            const struct fire *f = (k < n_fires) ? &fires[k] : NULL;
+            if (f && f->day == day && f->prayer == p && f->minute == mins[p] &&
+                f->on_sec == h->default_on_sec[p]) {
+                k++;
+                continue;
+            }
+            if (bad++ < SIM_MAX_SHOW) {
+                fmt_date(h, day, date);
+                if (f) {
+                    char got[24];
+                    fmt_date(h, f->day, got);
+                    printf("bin: %s %-7s want %02u:%02u, got %s %02u:%02u %s\n", date, PRAYER_NAME[p],
+                           mins[p] / 60, mins[p] % 60, got, f->minute / 60, f->minute % 60,
+                           PRAYER_NAME[f->prayer]);
+                } else {
+                    printf("bin: %s %-7s want %02u:%02u, no more fires\n", date, PRAYER_NAME[p],
+                           mins[p] / 60, mins[p] % 60);
+                }
+            }
+            // Resync: skip fires before this day/prayer
+            while (k < n_fires && (fires[k].day < day || (fires[k].day == day && fires[k].prayer < p))) k++;
+            if (k < n_fires && fires[k].day == day && fires[k].prayer == p) k++;
+        }
+    }
+    for (; k < n_fires; k++) {
+        if (bad++ < SIM_MAX_SHOW) {
+            fmt_date(h, fires[k].day, date);
+            printf("bin: %s %02u:%02u %s extra fire\n", date, fires[k].minute / 60,
+                   fires[k].minute % 60, PRAYER_NAME[fires[k].prayer]);
+        }
+    }
+    return bad;
+}
+
+static int parse_hhmm(const char *s)
+{
+    int hh, mm;
+    return (sscanf(s, "%d:%d", &hh, &mm) == 2) ? hh * 60 + mm : -1;
+}
+
+// Generator CSV: "Date,Weekday,Fajr,Sunrise,Dhuhr,Asr,Maghrib,Isha" after '#' lines.
+static size_t diff_against_csv(const pray2_header_t *h, const char *path, size_t *rows_out)
+{
+    static const char *const col_name[5] = {"Fajr", "Dhuhr", "Asr", "Maghrib", "Isha"};
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return 1; }
+
+    // Per-day fire minutes, -1 if that prayer never fired.
+    int32_t days = h->days;
+    int (*got)[5] = malloc(sizeof(*got) * (size_t)days);
+    for (int32_t d = 0; d < days; d++) for (int p = 0; p < 5; p++) got[d][p] = -1;
+    for (size_t k = 0; k < n_fires; k++) got[fires[k].day][fires[k].prayer] = fires[k].minute;
+
+    char line[512];
+    int col[5] = {-1, -1, -1, -1, -1};
+    size_t bad = 0, rows = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        char *s = line;
+        if ((uint8_t)s[0] == 0xEF && (uint8_t)s[1] == 0xBB && (uint8_t)s[2] == 0xBF) s += 3;
+        if (s[0] == '#' || s[0] == '\r' || s[0] == '\n') continue;
+
+        char *field[16];
+        int nf = 0;
+        for (char *tok = strtok(s, ",\r\n"); tok && nf < 16; tok = strtok(NULL, ",\r\n")) field[nf++] = tok;
+
+        if (col[0] < 0) {
+            for (int i = 0; i < nf; i++)
+                for (int p = 0; p < 5; p++)
+                    if (strcmp(field[i], col_name[p]) == 0) col[p] = i;
+            continue;
+        }
+
+        int y, m, d;
+        if (nf < 1 || sscanf(field[0], "%d-%d-%d", &y, &m, &d) != 3) continue;
+        rows++;
+        int day = pray2_compute_day_index(h, y, m, d);
+        for (int p = 0; p < 5; p++) {
+            int want = (col[p] < nf) ? parse_hhmm(field[col[p]]) : -1;
+            int have = (day >= 0) ? got[day][p] : -1;
+            if (want == have) continue;
+            if (bad++ < SIM_MAX_SHOW) {
+                if (have < 0) printf("csv: %s %-7s want %02d:%02d, did not fire\n", field[0], col_name[p], want / 60, want % 60);
+                else printf("csv: %s %-7s want %02d:%02d, fired %02d:%02d\n", field[0], col_name[p], want / 60, want % 60, have / 60, have % 60);
+            }
+        }
+    }
+    fclose(f);
+    free(got);
+    *rows_out = rows;
+    return bad;
+}
+
+static void write_log(const pray2_header_t *h, const char *path)
+{
+    FILE *f = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (!f) { perror(path); return; }
+    char date[24];
+    for (size_t k = 0; k < n_fires; k++) {
+        fmt_date(h, fires[k].day, date);
+        fprintf(f, "%s %02u:%02u %s %u\n", date, fires[k].minute / 60, fires[k].minute % 60,
+                PRAYER_NAME[fires[k].prayer], (unsigned)fires[k].on_sec);
+    }
+    if (f != stdout) fclose(f);
+}
+
+static int usage(void)
+{
+    fputs("usage: pray2_sim <file.bin> [--csv times.csv] [--log path|-] [--step second|minute|event]\n"
+          "                 [--repeat N] [--max-wall-ms MS]\n", stderr);
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    const char *bin = NULL, *csv = NULL, *log = NULL;
+    enum step step = STEP_MINUTE;
+    int repeat = 1;
+    double max_wall_ms = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (a[0] != '-') { bin = a; continue; }
+        if (!v) return usage();
+        if (strcmp(a, "--csv") == 0) csv = v;
+        else if (strcmp(a, "--log") == 0) log = v;
+        else if (strcmp(a, "--repeat") == 0) repeat = atoi(v);
+        else if (strcmp(a, "--max-wall-ms") == 0) max_wall_ms = atof(v);
+        else if (strcmp(a, "--step") == 0) {
+            if (strcmp(v, "second") == 0) step = STEP_SECOND;
+            else if (strcmp(v, "minute") == 0) step = STEP_MINUTE;
+            else if (strcmp(v, "event") == 0) step = STEP_EVENT;
+            else return usage();
+        } else return usage();
+        i++;
+    }
+    if (!bin || repeat < 1) return usage();
+
+    size_t len;
+    uint8_t *buf = read_file(bin, &len);
+    if (!buf) return 2;
+
+    pray2_header_t h;
+    if (pray2_validate_and_parse_no_crc(buf, len, &h) != PRAY2_OK) {
+        fprintf(stderr, "\n%s: not a valid PRAY2 file\n", bin);
+        return 1;
+    }
+    uint32_t payload = pray2_payload_size(buf, len);
+    int crc_ok = payload + 4 <= len && crc32_zlib(buf, payload) == pray2_rd_u32le(buf + payload);
+    printf("%s: %04u-%02u-%02u +%u days, flags 0x%02x, crc %s\n", bin, h.year, h.start_month,
+           h.start_day, h.days, h.flags, crc_ok ? "ok" : "BAD");
+
+    if (repeat > 1) {
+        uint8_t *tiled = repeat_table(buf, &h, repeat, &len);
+        if (!tiled || pray2_validate_and_parse_no_crc(tiled, len, &h) != PRAY2_OK) {
+            fputs("--repeat: span too long or file has durations\n", stderr);
+            return 2;
+        }
+        printf("repeated x%d: %u days\n", repeat, h.days);
+    }
+
+    double t0 = wall_s();
+    uint64_t sim_s = simulate(&h, step);
+    double wall = wall_s() - t0;
+
+    printf("%zu fires in %.1f simulated days, %.3f s wall, %.3g simulated s per wall s\n",
+           n_fires, sim_s / 86400.0, wall, wall > 0 ? sim_s / wall : 0.0);
+
+    size_t bad = diff_against_bin(&h);
+    printf("bin: %zu difference(s)\n", bad);
+    if (csv) {
+        size_t rows = 0;
+        size_t cbad = diff_against_csv(&h, csv, &rows);
+        printf("csv: %zu row(s), %zu difference(s)\n", rows, cbad);
+        bad += cbad;
+    }
+    if (log) write_log(&h, log);
+
+    int slow = max_wall_ms > 0 && wall * 1000.0 > max_wall_ms;
+    if (slow) printf("too slow: %.1f ms > %.1f ms\n", wall * 1000.0, max_wall_ms);
+    return (bad || !crc_ok || slow) ? 1 : 0;
+}
@@ -0,0 +1,226 @@
+// pray_calc_check.c — host check of pray_calc.c against the generator's output
+//
+//   pray_calc_check --csv times.csv [--bin file.bin] [--utc-offset MIN] [--bench N]
+//
+// Every day of the CSV (the generator's write_csv(): location, method and
+// offsets in its "#" lines) is computed with pray_calc_times() and compared
+// minute for minute, Sunrise included. With --bin, every table row must also
+// equal pray_calc_day(). The CSV names its zone, not its offset: pass
+// --utc-offset for zones other than Asia/Karachi (+300). Exit 1 on any
+// mismatch.
+//
+// --bench N times N passes over the CSV's days and prints the cost per day.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pray_calc.h"
+#include "pray2_reader.h"
+
+void print_uart(char *buf)
+{
+    fputs(buf, stderr);
+}
+
+#define MAX_DAYS 4000
+
+struct csv_day {
+    int y, m, d;
+    uint16_t t[PRAY_CALC_TIMES];  // CSV column order is pray_calc_times() order
+};
+
+static struct csv_day days[MAX_DAYS];
+static int n_days;
+
+static const struct {
+    const char *name;
+    uint8_t code;
+} method_names[] = {
+    {"KARACHI", PRAY_METHOD_KARACHI},
+    {"MUSLIM_WORLD_LEAGUE", PRAY_METHOD_MUSLIM_WORLD_LEAGUE},
+    {"EGYPTIAN", PRAY_METHOD_EGYPTIAN},
+    {"UMM_AL_QURA", PRAY_METHOD_UMM_AL_QURA},
+    {"MOON_SIGHTING_COMMITTEE", PRAY_METHOD_MOON_SIGHTING_COMMITTEE},
+    {"NORTH_AMERICA", PRAY_METHOD_NORTH_AMERICA},
+};
+
+static int parse_hhmm(const char *s, uint16_t *out)
+{
+    int hh, mm;
+    if (sscanf(s, "%d:%d", &hh, &mm) != 2) return -1;
+    *out = (uint16_t)(hh * 60 + mm);
+    return 0;
+}
+
+static int load_csv(const char *path, struct pray_calc_params *p)
+{
+    static const char *prayers[5] = {"Fajr", "Dhuhr", "Asr", "Maghrib", "Isha"};
+    char line[256];
+    int have_loc = 0, have_method = 0;
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        char *s = line;
+        if (!strncmp(s, "\xEF\xBB\xBF", 3)) s += 3;  // utf-8-sig
+        s[strcspn(s, "\r\n")] = '\0';
+        if (!strncmp(s, "# Location,", 11)) {
+            have_loc = sscanf(s + 11, "lat=%f,lon=%f", &p->lat, &p->lon) == 2;
+        } else if (!strncmp(s, "# Method,", 9)) {
+            for (size_t i = 0; i < sizeof(method_names) / sizeof(method_names[0]); i++) {
+                if (!strcmp(s + 9, method_names[i].name)) {
+                    p->method = method_names[i].code;
+                    have_method = 1;
+                }
+            }
+        } else if (!strncmp(s, "# Offsets,", 10)) {
+            for (int i = 0; i < 5; i++) {
+                char key[16];
+                snprintf(key, sizeof(key), "%s=", prayers[i]);
+                const char *v = strstr(s, key);
+                p->offset_min[i] = v ? (int8_t)atoi(v + strlen(key)) : 0;
+            }
+        } else if (s[0] >= '0' && s[0] <= '9') {
+            // 2025-01-01,Wednesday,05:49,07:07,12:24,15:21,17:41,18:59
+            struct csv_day *d = &days[n_days];
+            char *tok = strtok(s, ",");
+            if (n_days >= MAX_DAYS || !tok || sscanf(tok, "%d-%d-%d", &d->y, &d->m, &d->d) != 3) {
+                fprintf(stderr, "%s: bad row\n", path);
+                fclose(f);
+                return -1;
+            }
+            (void)strtok(NULL, ",");  // weekday
+            for (int i = 0; i < PRAY_CALC_TIMES; i++) {
+                tok = strtok(NULL, ",");
+                if (!tok || parse_hhmm(tok, &d->t[i])) {
+                    fprintf(stderr, "%s: bad time in %04d-%02d-%02d\n", path, d->y, d->m, d->d);
+                    fclose(f);
+                    return -1;
+                }
+            }
+            n_days++;
+        }
+    }
+    fclose(f);
+    if (!have_loc || !have_method || n_days == 0) {
+        fprintf(stderr, "%s: no location, method or days\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static int check_csv(const struct pray_calc_params *p)
+{
+    static const char *names[PRAY_CALC_TIMES] = {"Fajr", "Sunrise", "Dhuhr", "Asr", "Maghrib", "Isha"};
+    static const int8_t offset_of[PRAY_CALC_TIMES] = {0, -1, 1, 2, 3, 4};
+    int bad = 0;
+
+    for (int i = 0; i < n_days; i++) {
+        const struct csv_day *d = &days[i];
+        uint16_t t[PRAY_CALC_TIMES];
+        if (!pray_calc_times(p, d->y, d->m, d->d, t)) {
+            printf("%04d-%02d-%02d: no times\n", d->y, d->m, d->d);
+            bad++;
+            continue;
+        }
+        for (int k = 0; k < PRAY_CALC_TIMES; k++) {
+            int v = t[k] + (offset_of[k] >= 0 ? p->offset_min[offset_of[k]] : 0);
+            v = ((v % 1440) + 1440) % 1440;
+            if (v != d->t[k]) {
+                printf("%04d-%02d-%02d %-7s csv %02d:%02d calc %02d:%02d\n", d->y, d->m, d->d,
+                       names[k], d->t[k] / 60, d->t[k] % 60, v / 60, v % 60);
+                bad++;
+            }
+        }
+    }
+    printf("csv: %d days, %d mismatches\n", n_days, bad);
+    return bad;
+}
+
+static int check_bin(const char *path, const struct pray_calc_params *p)
+{
+    static uint8_t buf[PRAY2_HEADER_SIZE + 10u * 0xFFFFu + 64u];
+    pray2_header_t h;
+    int bad = 0;
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    size_t len = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    if (pray2_validate_and_parse_no_crc(buf, len, &h) != PRAY2_OK) {
+        fprintf(stderr, "%s: not a PRAY2 file\n", path);
+        return 1;
+    }
+    if (h.method_code != p->method) {
+        fprintf(stderr, "%s: method %u, csv says %u\n", path, h.method_code, p->method);
+        return 1;
+    }
+    int y = h.year, m = h.start_month, d = h.start_day;
+    for (uint16_t i = 0; i < h.days; i++, advance_one_day(&y, &m, &d)) {
+        uint16_t want[5], got[5];
+        (void)pray2_get_day_minutes(&h, i, want);
+        if (!pray_calc_day(p, y, m, d, got) || memcmp(want, got, sizeof(want)) != 0) {
+            printf("%04d-%02d-%02d bin %u %u %u %u %u calc %u %u %u %u %u\n", y, m, d,
+                   want[0], want[1], want[2], want[3], want[4], got[0], got[1], got[2], got[3], got[4]);
+            bad++;
+        }
+    }
+    printf("bin: %u days, %d mismatches\n", h.days, bad);
+    return bad;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void bench(const struct pray_calc_params *p, int passes)
+{
+    volatile uint32_t sink = 0;
+    uint16_t row[5];
+    double t0 = now_s();
+    for (int r = 0; r < passes; r++) {
+        for (int i = 0; i < n_days; i++) {
+            sink += pray_calc_day(p, days[i].y, days[i].m, days[i].d, row) + row[4];
+        }
+    }
+    double dt = now_s() - t0;
+    printf("bench: %d days, %.2f us/day\n", passes * n_days, dt * 1e6 / (passes * n_days));
+    (void)sink;
+}
+
+int main(int argc, char **argv)
+{
+    const char *csv = NULL, *bin = NULL;
+    int passes = 0;
+    struct pray_calc_params p = {.utc_offset_min = 300, .asr_shadow = 1};
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--csv") && i + 1 < argc) {
+            csv = argv[++i];
+        } else if (!strcmp(argv[i], "--bin") && i + 1 < argc) {
+            bin = argv[++i];
+        } else if (!strcmp(argv[i], "--utc-offset") && i + 1 < argc) {
+            p.utc_offset_min = (int16_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--bench") && i + 1 < argc) {
+            passes = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s --csv times.csv [--bin file.bin] [--utc-offset MIN] [--bench N]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (!csv || load_csv(csv, &p)) return 2;
+
+    int bad = check_csv(&p);
+    if (bin) bad += check_bin(bin, &p);
+    if (passes > 0) bench(&p, passes);
+    return bad ? 1 : 0;
+}